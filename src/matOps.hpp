@@ -3,1062 +3,9507 @@
 #include <cmath>
 #include <random>
 #include <algorithm>
+#include <numeric>
+#include <string>
+#include <stdexcept>
+#include <set>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <exception>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
 
 #pragma once
 
 #define EPS 1e-12
-#define OPENMP_THRESHOLD 10000
+
+/*
+ * Default parallel threshold (work below which loops run serially). Per-operation
+ * values can be changed at run time, see matOpsParallel::setThreshold().
+ */
+#ifndef OPENMP_THRESHOLD
+    #define OPENMP_THRESHOLD 10000
+#endif
+
+/*
+ * Backend used by the parallel loops until matOpsParallel::setBackend() is called:
+ * OpenMP, ThreadPool or Serial. Defaults to OpenMP when compiled with -fopenmp and to
+ * the built-in thread pool otherwise. Example: -DMATOPS_DEFAULT_BACKEND=ThreadPool
+ */
+#ifndef MATOPS_DEFAULT_BACKEND
+    #ifdef _OPENMP
+        #define MATOPS_DEFAULT_BACKEND OpenMP
+    #else
+        #define MATOPS_DEFAULT_BACKEND ThreadPool
+    #endif
+#endif
+
+/* Number of doubles held by one SIMD register of the target ISA. */
+#if defined(__AVX512F__)
+    #define MATOPS_SIMD_DOUBLES 8
+#elif defined(__AVX__)
+    #define MATOPS_SIMD_DOUBLES 4
+#else
+    #define MATOPS_SIMD_DOUBLES 2
+#endif
+
+class CSRMatrix;
+class SELLMatrix;
+template <size_t R, size_t C = R> class BSRMatrix;
+class SparseCholesky;
+class DiagonalMatrix;
+class TridiagonalMatrix;
+class BandedMatrix;
+class TriangularMatrix;
+class SymmetricMatrix;
+class LUDecomposition;
+class RunningCovariance;
+class MatrixBatch;
+class BatchedLU;
+
+/// @brief Selects the lower or upper triangle of a square matrix.
+enum class Triangle { Lower, Upper };
+
+/**
+ * @brief Direction of a reduction.
+ *
+ * Rows collapses the rows (one result per column, a 1 x ncols row vector),
+ * Columns collapses the columns (one result per row, an nrows x 1 column vector)
+ * and All collapses both (a 1 x 1 matrix).
+ */
+enum class Axis { Rows, Columns, All };
+
+/**
+ * @brief Summation algorithm used by sum() and mean().
+ *
+ * Naive adds left to right (spread over SIMD lanes), with an error bound that grows
+ * linearly with the number of terms. Pairwise recursively halves the data, giving an
+ * O(log n) error bound at the same speed. Kahan carries a running compensation term
+ * (Kahan-Babuska variant, which also survives terms larger than the running sum),
+ * making the error essentially independent of n at a few times the cost.
+ *
+ * Whatever the method, the data is cut into blocks that depend only on the shape and
+ * the block results are combined in a fixed order, so sums are bitwise reproducible
+ * for any number of threads, backend or threshold. (Compensation relies on strict IEEE semantics: do not
+ * build with -ffast-math.)
+ */
+enum class Summation { Naive, Pairwise, Kahan };
+
+/**
+ * @brief Matrix norms accepted by Matrix::norm().
+ *
+ * One is the maximum absolute column sum, Infinity the maximum absolute row sum,
+ * Frobenius the square root of the sum of squares and Max the largest absolute entry.
+ */
+enum class Norm { One, Infinity, Frobenius, Max };
+
+/**
+ * @brief Distance functions accepted by Matrix::pairwiseDistances().
+ *
+ * Euclidean is ||x - y||_2, SquaredEuclidean its square, Cosine is
+ * 1 - x.y / (||x|| ||y||) (a zero vector is at distance 1 from everything) and
+ * Manhattan is ||x - y||_1.
+ */
+enum class DistanceMetric { Euclidean, SquaredEuclidean, Cosine, Manhattan };
+
+/**
+ * @brief Threading layer of the library.
+ *
+ * Every parallel loop of matOps goes through parallelFor() / parallelForRange(), which
+ * dispatch to the selected backend. The backend and thread count are chosen at build
+ * time (MATOPS_DEFAULT_BACKEND), from the environment on first use (MATOPS_BACKEND =
+ * openmp | threadpool | serial, MATOPS_NUM_THREADS) or at run time with setBackend()
+ * and setNumThreads(). NUMA placement and thread binding likewise come from
+ * MATOPS_PLACEMENT (serial | partitioned | interleaved) and MATOPS_AFFINITY (none |
+ * compact | scatter), or setPlacement() and setAffinity(). An ExecutionContext
+ * overrides the global settings for the operations of one thread.
+ */
+namespace matOpsParallel {
+
+    /**
+     * @brief Threading backends.
+     *
+     * OpenMP runs loops on the OpenMP runtime (serially when built without -fopenmp).
+     * ThreadPool runs them on the library's own work-stealing pool, whose idle workers
+     * sleep instead of spin-waiting, so it coexists with an application thread pool
+     * without burning cores. Serial runs every loop on the calling thread.
+     */
+    enum class Backend { Serial, OpenMP, ThreadPool };
+
+    /**
+     * @brief Loop schedules.
+     *
+     * Static splits the range into one contiguous chunk per thread. Dynamic hands out
+     * chunks of a given grain on demand, for loops whose iterations vary in cost.
+     */
+    enum class Schedule { Static, Dynamic };
+
+    /**
+     * @brief Operation classes, each with its own parallel threshold.
+     *
+     * A loop runs in parallel when its work exceeds the threshold of its class, because
+     * the break-even points differ by orders of magnitude: an element-wise add is memory
+     * bound while a product does O(n) work per element. Work is counted in elements
+     * touched, except for Multiply (multiply-adds) and Factorization (elements updated
+     * by one elimination step).
+     *
+     * - Elementwise: arithmetic, broadcasting, apply / zip, powers.
+     * - Transpose.
+     * - Reduction: sums, extrema, norms, comparisons, hashing.
+     * - Multiply: dense products, matrix-vector products, syrk, pairwise distances.
+     * - Factorization: LU and Cholesky elimination steps.
+     * - Sparse: CSR, SELL and BSR kernels.
+     * - Structured: diagonal, tridiagonal, banded, triangular and symmetric kernels.
+     */
+    enum class Operation { Elementwise, Transpose, Reduction, Multiply, Factorization, Sparse, Structured };
+
+    /**
+     * @brief Where the pages of a new matrix end up on a NUMA machine.
+     *
+     * The operating system places a page on the node of the thread that first writes to
+     * it, so the policy decides which threads initialize the rows of large matrices
+     * (constructors, copies and operation results; see firstTouch()).
+     *
+     * - Serial: the constructing thread touches every row, so the whole matrix lands on
+     *   its node.
+     * - Partitioned: each thread touches the block of rows it later processes in
+     *   statically scheduled loops, keeping row-parallel kernels node local. Kernels
+     *   that follow this partition: element-wise arithmetic, broadcasting, apply / zip
+     *   and powers, reductions, comparisons, operator* (rows of A and C), and the
+     *   full-matrix pairwiseDistances (output rows, to within one 64-row tile).
+     *   Transposes, syrk / cov, the tiled pairwiseDistances (parallel over column
+     *   tiles) and the sparse and structured kernels read rows across the partition,
+     *   so they gain nothing from it.
+     * - Interleaved: rows are touched round-robin by the threads, spreading the matrix
+     *   evenly over the nodes. Suits data read by every thread, such as the right-hand
+     *   operand of a product.
+     */
+    enum class Placement { Serial, Partitioned, Interleaved };
+
+    /**
+     * @brief Binding of the worker threads to CPUs.
+     *
+     * - None: threads may run anywhere.
+     * - Compact: thread t is bound to the t-th CPU, filling one NUMA node before the next.
+     * - Scatter: consecutive threads are bound to CPUs of different nodes, spreading
+     *   memory bandwidth and Interleaved placement over every socket.
+     *
+     * Binding only takes effect on Linux.
+     */
+    enum class Affinity { None, Compact, Scatter };
+
+    struct ExecutionContext;
+
+    namespace detail {
+
+        inline std::vector<int> parseCpuList(const std::string& text) {
+            std::vector<int> cpus;
+            std::istringstream in(text);
+            std::string range;
+
+            while (std::getline(in, range, ',')) {
+                std::istringstream bounds(range);
+                int first = 0;
+                int last = 0;
+                char dash = 0;
+                if (!(bounds >> first)) {
+                    continue;
+                }
+                if (!(bounds >> dash >> last) || dash != '-') {
+                    last = first;
+                }
+                for (int cpu = first; cpu <= last; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+            return cpus;
+        }
+
+        /* CPUs the process may run on, as seen by the first caller (before any binding). */
+        inline const std::vector<int>& allowedCpus() {
+            static const std::vector<int> cpus = [] {
+                std::vector<int> list;
+                #ifdef __linux__
+                    cpu_set_t mask;
+                    CPU_ZERO(&mask);
+                    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+                        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                            if (CPU_ISSET(cpu, &mask)) {
+                                list.push_back(cpu);
+                            }
+                        }
+                    }
+                #endif
+                if (list.empty()) {
+                    for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+                        list.push_back(static_cast<int>(cpu));
+                    }
+                }
+                return list;
+            }();
+            return cpus;
+        }
+
+        /* Allowed CPUs grouped by NUMA node, from sysfs; a single node when unavailable. */
+        inline const std::vector<std::vector<int>>& topology() {
+            static const std::vector<std::vector<int>> nodes = [] {
+                const std::vector<int>& allowed = allowedCpus();
+                std::vector<std::vector<int>> result;
+
+                std::ifstream online("/sys/devices/system/node/online");
+                std::string text;
+                if (online && std::getline(online, text)) {
+                    for (int node : parseCpuList(text)) {
+                        std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                        std::string cpuText;
+                        if (!list || !std::getline(list, cpuText)) {
+                            continue;
+                        }
+
+                        std::vector<int> cpus;
+                        for (int cpu : parseCpuList(cpuText)) {
+                            if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                                cpus.push_back(cpu);
+                            }
+                        }
+                        if (!cpus.empty()) {
+                            result.push_back(cpus);
+                        }
+                    }
+                }
+
+                if (result.empty()) {
+                    result.push_back(allowed);
+                }
+                return result;
+            }();
+            return nodes;
+        }
+
+        inline std::vector<int> buildCpuOrder(Affinity affinity) {
+            const std::vector<std::vector<int>>& nodes = topology();
+            std::vector<int> order;
+
+            if (affinity == Affinity::Compact) {
+                for (const std::vector<int>& node : nodes) {
+                    order.insert(order.end(), node.begin(), node.end());
+                }
+            } else if (affinity == Affinity::Scatter) {
+                size_t widest = 0;
+                for (const std::vector<int>& node : nodes) {
+                    widest = std::max(widest, node.size());
+                }
+                for (size_t k = 0; k < widest; ++k) {
+                    for (const std::vector<int>& node : nodes) {
+                        if (k < node.size()) {
+                            order.push_back(node[k]);
+                        }
+                    }
+                }
+            }
+            return order;
+        }
+
+        /* CPU of thread t is cpuOrder(affinity)[t % size]; empty for Affinity::None. */
+        inline const std::vector<int>& cpuOrder(Affinity affinity) {
+            static const std::vector<int> orders[3] = {
+                buildCpuOrder(Affinity::None), buildCpuOrder(Affinity::Compact), buildCpuOrder(Affinity::Scatter)
+            };
+            return orders[static_cast<size_t>(affinity)];
+        }
+
+        /*
+         * Binds the calling thread to one CPU, or releases it to every allowed CPU when
+         * cpu < 0. Threads remember their binding, so repeating it costs nothing.
+         */
+        inline void bindCurrentThread(int cpu) {
+            static thread_local int applied = -1;
+            if (cpu == applied) {
+                return;
+            }
+            applied = cpu;
+
+            #ifdef __linux__
+                cpu_set_t mask;
+                CPU_ZERO(&mask);
+                for (int allowed : cpu < 0 ? allowedCpus() : std::vector<int>{ cpu }) {
+                    if (allowed < CPU_SETSIZE) {
+                        CPU_SET(allowed, &mask);
+                    }
+                }
+                pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+            #endif
+        }
+
+        /* Binds thread @p index of a loop team per @p affinity. */
+        inline void bindToAffinity(size_t index, Affinity affinity) {
+            const std::vector<int>& order = cpuOrder(affinity);
+            bindCurrentThread(order.empty() ? -1 : order[index % order.size()]);
+        }
+
+    }
+
+    /**
+     * @brief Work-stealing thread pool.
+     *
+     * Each worker owns a deque: it pushes and pops its own tasks at the back (LIFO, cache
+     * warm) while idle workers steal from the front of the others (FIFO, oldest and
+     * usually largest tasks first). Tasks submitted from outside the pool are spread
+     * round-robin over the deques. Idle workers block on a condition variable.
+     *
+     * Tasks must not throw; wrap them in a std::packaged_task to carry exceptions.
+     *
+     * Workers can be bound to CPUs: worker t runs on cpus[t % cpus.size()].
+     *
+     * @code
+     * matOpsParallel::ThreadPool pool(4);
+     * pool.submit([] { std::cout << "hello from the pool\n"; });
+     * @endcode
+     */
+    class ThreadPool {
+        private:
+            struct Queue {
+                std::mutex lock;
+                std::deque<std::function<void()>> tasks;
+            };
+
+            /* Identity of the calling thread: the pool it works for, and its queue. */
+            struct Worker {
+                const ThreadPool* pool;
+                size_t index;
+            };
+
+            std::vector<std::unique_ptr<Queue>> queues;
+            std::vector<std::thread> workers;
+            std::mutex sleepLock;
+            std::condition_variable wake;
+            std::atomic<size_t> pending;
+            std::atomic<size_t> nextQueue;
+            std::vector<int> cpus;
+            bool stopping;
+
+            static Worker& self() {
+                static thread_local Worker worker = { nullptr, 0 };
+                return worker;
+            }
+
+            /* Own queue from the back first, then steal from the front of the others. */
+            bool take(size_t home, std::function<void()>& task) {
+                const size_t n = this->queues.size();
+
+                {
+                    Queue& own = *this->queues[home];
+                    std::lock_guard<std::mutex> guard(own.lock);
+                    if (!own.tasks.empty()) {
+                        task = std::move(own.tasks.back());
+                        own.tasks.pop_back();
+                        --this->pending;
+                        return true;
+                    }
+                }
+
+                for (size_t k = 1; k < n; ++k) {
+                    Queue& victim = *this->queues[(home + k) % n];
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    if (!victim.tasks.empty()) {
+                        task = std::move(victim.tasks.front());
+                        victim.tasks.pop_front();
+                        --this->pending;
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void push(size_t home, std::function<void()> task) {
+                {
+                    std::lock_guard<std::mutex> guard(this->sleepLock);
+                    ++this->pending;
+                }
+
+                {
+                    Queue& q = *this->queues[home];
+                    std::lock_guard<std::mutex> guard(q.lock);
+                    q.tasks.push_back(std::move(task));
+                }
+                this->wake.notify_one();
+            }
+
+            void run(size_t index) {
+                self() = Worker{ this, index };
+                if (!this->cpus.empty()) {
+                    detail::bindCurrentThread(this->cpus[index % this->cpus.size()]);
+                }
+                std::function<void()> task;
+
+                for (;;) {
+                    if (this->take(index, task)) {
+                        task();
+                        task = nullptr;
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> guard(this->sleepLock);
+                    this->wake.wait(guard, [this] { return this->stopping || this->pending.load() > 0; });
+                    if (this->stopping && this->pending.load() == 0) {
+                        return;
+                    }
+                }
+            }
+
+        public:
+            /**
+             * @brief Starts a pool with the given number of worker threads.
+             * @param threads Number of workers; 0 means std::thread::hardware_concurrency().
+             * @param cpus CPUs to bind the workers to, round-robin; empty leaves them unbound.
+             */
+            explicit ThreadPool(size_t threads, std::vector<int> cpus = std::vector<int>())
+                : pending(0), nextQueue(0), cpus(std::move(cpus)), stopping(false) {
+                if (threads == 0) {
+                    threads = std::max(1u, std::thread::hardware_concurrency());
+                }
+
+                for (size_t t = 0; t < threads; ++t) {
+                    this->queues.emplace_back(new Queue());
+                }
+                for (size_t t = 0; t < threads; ++t) {
+                    this->workers.emplace_back(&ThreadPool::run, this, t);
+                }
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /// @brief Runs the remaining queued tasks, then joins the workers.
+            ~ThreadPool() {
+                {
+                    std::lock_guard<std::mutex> guard(this->sleepLock);
+                    this->stopping = true;
+                }
+                this->wake.notify_all();
+
+                for (std::thread& worker : this->workers) {
+                    worker.join();
+                }
+            }
+
+            /// @brief Number of worker threads.
+            size_t size() const {
+                return this->workers.size();
+            }
+
+            /// @brief Whether the calling thread is one of this pool's workers.
+            bool isWorkerThread() const {
+                return self().pool == this;
+            }
+
+            /// @brief Index of the calling worker thread, or size() if it is not a worker.
+            size_t workerIndex() const {
+                return this->isWorkerThread() ? self().index : this->size();
+            }
+
+            /**
+             * @brief Queues a task. From a worker it goes to that worker's own deque,
+             * otherwise to the next deque in round-robin order.
+             */
+            void submit(std::function<void()> task) {
+                const size_t home = this->isWorkerThread()
+                    ? self().index
+                    : this->nextQueue++ % this->queues.size();
+
+                this->push(home, std::move(task));
+            }
+
+            /**
+             * @brief Queues a task on the deque of a given worker, which runs it unless
+             * another worker steals it first. Keeps repeated loops on the same threads,
+             * and so on the memory those threads first touched.
+             *
+             * @param worker Worker index, taken modulo size().
+             * @param task The task.
+             */
+            void submitTo(size_t worker, std::function<void()> task) {
+                this->push(worker % this->queues.size(), std::move(task));
+            }
+
+            /**
+             * @brief Runs one queued task on the calling thread, if any is available.
+             *
+             * Lets a thread that waits for pool work help instead of blocking.
+             *
+             * @return true if a task was run.
+             */
+            bool runPendingTask() {
+                const size_t home = this->isWorkerThread()
+                    ? self().index
+                    : this->nextQueue.load() % this->queues.size();
+
+                std::function<void()> task;
+                if (!this->take(home, task)) {
+                    return false;
+                }
+
+                task();
+                return true;
+            }
+    };
+
+    namespace detail {
+
+        const size_t operationCount = 7;
+
+        inline const char* operationName(size_t op) {
+            static const char* const names[operationCount] = {
+                "elementwise", "transpose", "reduction", "multiply", "factorization", "sparse", "structured"
+            };
+            return names[op];
+        }
+
+        /* Products do O(n) multiply-adds per element, so their default is correspondingly larger. */
+        inline size_t defaultThreshold(Operation op) {
+            return op == Operation::Multiply ? 100 * static_cast<size_t>(OPENMP_THRESHOLD)
+                                             : static_cast<size_t>(OPENMP_THRESHOLD);
+        }
+
+        inline const char* backendName(Backend backend) {
+            switch (backend) {
+                case Backend::Serial: return "serial";
+                case Backend::OpenMP: return "openmp";
+                case Backend::ThreadPool: break;
+            }
+            return "threadpool";
+        }
+
+        inline const char* placementName(Placement placement) {
+            switch (placement) {
+                case Placement::Serial: return "serial";
+                case Placement::Partitioned: return "partitioned";
+                case Placement::Interleaved: break;
+            }
+            return "interleaved";
+        }
+
+        inline const char* affinityName(Affinity affinity) {
+            switch (affinity) {
+                case Affinity::None: return "none";
+                case Affinity::Compact: return "compact";
+                case Affinity::Scatter: break;
+            }
+            return "scatter";
+        }
+
+        struct Settings {
+            std::atomic<Backend> backend;
+            std::atomic<size_t> threads;
+            std::atomic<size_t> thresholds[operationCount];
+            std::atomic<Placement> placement;
+            std::atomic<Affinity> affinity;
+            std::atomic<bool> deterministic;
+
+            Settings() : backend(Backend::MATOPS_DEFAULT_BACKEND), threads(0),
+                         placement(Placement::Partitioned), affinity(Affinity::None), deterministic(false) {
+                for (size_t op = 0; op < operationCount; ++op) {
+                    this->thresholds[op] = defaultThreshold(static_cast<Operation>(op));
+                }
+
+                const char* name = std::getenv("MATOPS_BACKEND");
+                if (name != nullptr) {
+                    for (Backend b : {Backend::Serial, Backend::OpenMP, Backend::ThreadPool}) {
+                        if (std::string(name) == backendName(b)) {
+                            this->backend = b;
+                        }
+                    }
+                }
+
+                const char* count = std::getenv("MATOPS_NUM_THREADS");
+                if (count != nullptr) {
+                    this->threads = static_cast<size_t>(std::strtoul(count, nullptr, 10));
+                }
+
+                const char* placementEnv = std::getenv("MATOPS_PLACEMENT");
+                if (placementEnv != nullptr) {
+                    for (Placement p : {Placement::Serial, Placement::Partitioned, Placement::Interleaved}) {
+                        if (std::string(placementEnv) == placementName(p)) {
+                            this->placement = p;
+                        }
+                    }
+                }
+
+                const char* affinityEnv = std::getenv("MATOPS_AFFINITY");
+                if (affinityEnv != nullptr) {
+                    for (Affinity a : {Affinity::None, Affinity::Compact, Affinity::Scatter}) {
+                        if (std::string(affinityEnv) == affinityName(a)) {
+                            this->affinity = a;
+                        }
+                    }
+                }
+            }
+        };
+
+        inline Settings& settings() {
+            static Settings instance;
+            return instance;
+        }
+
+        inline std::mutex& poolLock() {
+            static std::mutex lock;
+            return lock;
+        }
+
+        inline std::unique_ptr<ThreadPool>& poolSlot() {
+            static std::unique_ptr<ThreadPool> slot;
+            return slot;
+        }
+
+        /* Context installed on the calling thread by a ScopedContext, if any. */
+        inline const ExecutionContext*& contextSlot() {
+            static thread_local const ExecutionContext* current = nullptr;
+            return current;
+        }
+
+        /* Number of parallel loop chunks the calling thread is running, one per nesting level. */
+        inline size_t& loopDepth() {
+            static thread_local size_t depth = 0;
+            return depth;
+        }
+
+        struct LoopScope {
+            LoopScope() { ++loopDepth(); }
+            ~LoopScope() { --loopDepth(); }
+            LoopScope(const LoopScope&) = delete;
+            LoopScope& operator=(const LoopScope&) = delete;
+        };
+
+        /* State shared by the threads of one pool-backed loop; outlives late helper tasks. */
+        struct LoopState {
+            static const size_t noChunk = static_cast<size_t>(-1);
+
+            std::atomic<size_t> next;
+            std::atomic<size_t> done;
+            size_t chunks;
+            std::unique_ptr<std::atomic<bool>[]> claimed;
+            std::function<void(size_t)> runChunk;
+            std::mutex lock;
+            std::condition_variable finished;
+            std::exception_ptr error;
+
+            LoopState(size_t chunks, std::function<void(size_t)> runChunk)
+                : next(0), done(0), chunks(chunks), claimed(new std::atomic<bool>[chunks]),
+                  runChunk(std::move(runChunk)) {
+                for (size_t c = 0; c < chunks; ++c) {
+                    this->claimed[c] = false;
+                }
+            }
+
+            void run(size_t c) {
+                if (this->claimed[c].exchange(true)) {
+                    return;
+                }
+
+                try {
+                    this->runChunk(c);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(this->lock);
+                    if (!this->error) {
+                        this->error = std::current_exception();
+                    }
+                }
+
+                if (++this->done == this->chunks) {
+                    std::lock_guard<std::mutex> guard(this->lock);
+                    this->finished.notify_all();
+                }
+            }
+
+            /* Runs the preferred chunk (if not taken yet), then helps with the rest. */
+            void work(size_t preferred) {
+                if (preferred < this->chunks) {
+                    this->run(preferred);
+                }
+
+                for (;;) {
+                    const size_t c = this->next++;
+                    if (c >= this->chunks) {
+                        return;
+                    }
+                    this->run(c);
+                }
+            }
+        };
+
+    }
+
+    /**
+     * @brief Threading settings for the operations run by one thread.
+     *
+     * The global settings (setBackend(), setNumThreads(), setAffinity(),
+     * setDeterministic()) apply to every thread. A context overrides them for the
+     * operations of a single thread, e.g. to keep each of several application threads
+     * that call into matOps from opening its own team on every core:
+     *
+     * @code
+     * // In worker thread w (0 to 7) of a 32-core server:
+     * matOpsParallel::ExecutionContext context;
+     * context.threads = 4;
+     * context.affinity = matOpsParallel::Affinity::Compact;
+     * context.cpuOffset = 4 * w; // CPUs 4w to 4w + 3 of the Compact order
+     * matOpsParallel::ScopedContext scope(context);
+     * Matrix C = A * B; // 4 threads per product, on this worker's own CPUs
+     * @endcode
+     *
+     * Each OpenMP team binds to a slice of the affinity's CPU order starting at
+     * cpuOffset. Give concurrent contexts disjoint slices. Otherwise every team binds
+     * its threads to the same first CPUs of the order, and the teams pile up there.
+     *
+     * Install a context for a scope with ScopedContext, or for a single call with
+     * withContext(). Asynchronous operations and task graphs run with the context of
+     * the thread that started them.
+     *
+     * With the ThreadPool backend every context shares the library's pool, so a loop
+     * runs on at most pool().size() workers plus the calling thread. Pool workers keep
+     * the binding of their own index, and cpuOffset does not apply to them.
+     */
+    struct ExecutionContext {
+        Backend backend;    ///< Backend of the parallel loops.
+        size_t threads;     ///< Threads per loop; 0 for the backend's default.
+        Affinity affinity;  ///< Binding of the threads that run the loops.
+        /**
+         * First entry of the affinity's CPU order used by this context's OpenMP teams.
+         * Thread t of a team binds to order[(cpuOffset + t) % order.size()]. Thread 0 is
+         * the calling thread and stays unbound.
+         */
+        size_t cpuOffset;
+        /**
+         * Bitwise reproducible results for any backend and thread count. Most kernels
+         * partition their work independently of the thread count anyway; the others
+         * (scattered sparse transposed products) then use a fixed partition.
+         */
+        bool deterministic;
+
+        /// @brief A context with the current global settings.
+        ExecutionContext()
+            : backend(detail::settings().backend), threads(detail::settings().threads),
+              affinity(detail::settings().affinity), cpuOffset(0),
+              deterministic(detail::settings().deterministic) {}
+
+        /// @brief A context that runs every loop on the calling thread.
+        static ExecutionContext serial() {
+            ExecutionContext context;
+            context.backend = Backend::Serial;
+            context.threads = 1;
+            return context;
+        }
+    };
+
+    /**
+     * @brief Installs an ExecutionContext on the calling thread for the lifetime of the
+     * scope, restoring the previous one (if any) on exit. Scopes nest.
+     */
+    class ScopedContext {
+        private:
+            ExecutionContext context;
+            const ExecutionContext* previous;
+
+        public:
+            explicit ScopedContext(const ExecutionContext& context)
+                : context(context), previous(detail::contextSlot()) {
+                detail::contextSlot() = &this->context;
+            }
+
+            ~ScopedContext() {
+                detail::contextSlot() = this->previous;
+            }
+
+            ScopedContext(const ScopedContext&) = delete;
+            ScopedContext& operator=(const ScopedContext&) = delete;
+    };
+
+    /**
+     * @brief The settings in effect on the calling thread: the installed context, or
+     * the global settings.
+     */
+    inline ExecutionContext currentContext() {
+        const ExecutionContext* current = detail::contextSlot();
+        return current != nullptr ? *current : ExecutionContext();
+    }
+
+    /**
+     * @brief Runs f() with the given context installed on the calling thread.
+     *
+     * @code
+     * Matrix C = matOpsParallel::withContext(matOpsParallel::ExecutionContext::serial(), [&] {
+     *     return A * B;
+     * });
+     * @endcode
+     *
+     * @return The value returned by f.
+     */
+    template <typename F>
+    auto withContext(const ExecutionContext& context, F f) -> decltype(f()) {
+        ScopedContext scope(context);
+        return f();
+    }
+
+    /**
+     * @brief Whether the calling thread is inside a parallel loop of matOps or an OpenMP
+     * parallel region. Loops started there run serially instead of oversubscribing
+     * the machine with nested teams.
+     */
+    inline bool inParallelRegion() {
+        #ifdef _OPENMP
+            if (omp_in_parallel()) {
+                return true;
+            }
+        #endif
+        return detail::loopDepth() > 0;
+    }
+
+    /**
+     * @brief Selects the backend used by subsequent parallel loops.
+     * @note Switch backends between operations, not while one is running.
+     */
+    inline void setBackend(Backend backend) {
+        detail::settings().backend = backend;
+    }
+
+    /// @brief The backend used by the parallel loops of the calling thread.
+    inline Backend getBackend() {
+        const ExecutionContext* current = detail::contextSlot();
+        return current != nullptr ? current->backend : detail::settings().backend.load();
+    }
+
+    /**
+     * @brief Sets the number of threads used by the parallel loops.
+     *
+     * 0 restores the default: the OpenMP runtime's own setting (omp_set_num_threads,
+     * OMP_NUM_THREADS) for the OpenMP backend, and the hardware concurrency for the
+     * thread pool. A running pool with a different size is drained and rebuilt, so
+     * do not call this while operations are running.
+     *
+     * @param threads Number of threads, or 0 for the default.
+     */
+    inline void setNumThreads(size_t threads) {
+        detail::settings().threads = threads;
+
+        std::lock_guard<std::mutex> guard(detail::poolLock());
+        std::unique_ptr<ThreadPool>& slot = detail::poolSlot();
+        const size_t wanted = threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+        if (slot && slot->size() != wanted) {
+            slot.reset();
+        }
+    }
+
+    /**
+     * @brief Number of threads a parallel loop of the current backend runs on.
+     */
+    inline size_t getNumThreads() {
+        const ExecutionContext* current = detail::contextSlot();
+        const size_t configured = current != nullptr ? current->threads : detail::settings().threads.load();
+
+        switch (getBackend()) {
+            case Backend::Serial:
+                return 1;
+            case Backend::OpenMP:
+                #ifdef _OPENMP
+                    return configured != 0 ? configured : static_cast<size_t>(omp_get_max_threads());
+                #else
+                    return 1;
+                #endif
+            case Backend::ThreadPool:
+                break;
+        }
+
+        return configured != 0 ? configured : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    /**
+     * @brief The CPUs this process may use, grouped by NUMA node (read from
+     * /sys/devices/system/node on Linux). Machines without NUMA information report a
+     * single node.
+     */
+    inline const std::vector<std::vector<int>>& numaNodes() {
+        return detail::topology();
+    }
+
+    /// @brief Selects the first-touch placement of new matrices; see Placement.
+    inline void setPlacement(Placement placement) {
+        detail::settings().placement = placement;
+    }
+
+    /// @brief The first-touch placement of new matrices.
+    inline Placement getPlacement() {
+        return detail::settings().placement;
+    }
+
+    /**
+     * @brief Binds the worker threads to CPUs; see Affinity.
+     *
+     * The thread pool is rebuilt with bound workers. OpenMP worker threads rebind at the
+     * start of their next parallel loop; this overrides OMP_PROC_BIND / OMP_PLACES, so
+     * leave the affinity at None when those are used. With either backend the calling
+     * thread, which also runs chunks, is never bound, so its own serial work keeps the
+     * CPUs it had. Affinity::None releases the
+     * binding. Do not call this while operations are running.
+     *
+     * Combine Affinity::Scatter or Compact with Placement::Partitioned so that each
+     * thread computes on rows resident on its own node.
+     *
+     * @param affinity The binding policy.
+     */
+    inline void setAffinity(Affinity affinity) {
+        detail::settings().affinity = affinity;
+
+        std::lock_guard<std::mutex> guard(detail::poolLock());
+        detail::poolSlot().reset();
+    }
+
+    /// @brief The thread binding policy of the calling thread's loops.
+    inline Affinity getAffinity() {
+        const ExecutionContext* current = detail::contextSlot();
+        return current != nullptr ? current->affinity : detail::settings().affinity.load();
+    }
+
+    /// @brief Requests bitwise reproducible results; see ExecutionContext::deterministic.
+    inline void setDeterministic(bool deterministic) {
+        detail::settings().deterministic = deterministic;
+    }
+
+    /// @brief Whether the calling thread's operations must be bitwise reproducible.
+    inline bool isDeterministic() {
+        const ExecutionContext* current = detail::contextSlot();
+        return current != nullptr ? current->deterministic : detail::settings().deterministic.load();
+    }
+
+    /// @brief The work above which loops of the given class run in parallel.
+    inline size_t getThreshold(Operation op) {
+        return detail::settings().thresholds[static_cast<size_t>(op)];
+    }
+
+    /**
+     * @brief Pins the parallel threshold of an operation class.
+     *
+     * @param op The operation class.
+     * @param work Loops with more work run in parallel; 0 parallelizes everything and
+     *        std::numeric_limits<size_t>::max() nothing.
+     */
+    inline void setThreshold(Operation op, size_t work) {
+        detail::settings().thresholds[static_cast<size_t>(op)] = work;
+    }
+
+    /// @brief Restores the built-in thresholds (derived from OPENMP_THRESHOLD).
+    inline void resetThresholds() {
+        for (size_t op = 0; op < detail::operationCount; ++op) {
+            setThreshold(static_cast<Operation>(op), detail::defaultThreshold(static_cast<Operation>(op)));
+        }
+    }
+
+    /// @brief Whether a loop of class @p op doing @p work units of work should run in parallel.
+    inline bool exceedsThreshold(Operation op, size_t work) {
+        return work > getThreshold(op);
+    }
+
+    /**
+     * @brief Writes the current thresholds to a wisdom file.
+     *
+     * The file is plain text, one "key value" pair per line, and records the backend and
+     * thread count the thresholds were measured for.
+     *
+     * The file is written to a temporary file in the same directory and then renamed
+     * over @p path, so a concurrent loadWisdom() never reads a truncated file.
+     *
+     * @param path Path of the file to (over)write.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    inline void saveWisdom(const std::string& path) {
+        // Unique per process and thread, so concurrent savers never share a temporary file.
+        const size_t salt = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+            static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        const std::string temporary = path + "." + std::to_string(salt) + ".tmp";
+
+        {
+            std::ofstream out(temporary);
+            out << "# matOps parallel thresholds\n";
+            out << "backend " << detail::backendName(getBackend()) << "\n";
+            out << "threads " << getNumThreads() << "\n";
+            for (size_t op = 0; op < detail::operationCount; ++op) {
+                out << detail::operationName(op) << " " << getThreshold(static_cast<Operation>(op)) << "\n";
+            }
+
+            out.close();
+            if (!out) {
+                std::remove(temporary.c_str());
+                throw std::runtime_error("Cannot write wisdom file: " + path);
+            }
+        }
+
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot write wisdom file: " + path);
+        }
+    }
+
+    /**
+     * @brief Loads thresholds saved by saveWisdom().
+     *
+     * Nothing is applied unless the file was written for the current backend and
+     * thread count, since break-even points depend on both.
+     *
+     * @param path Path of the wisdom file.
+     * @return true if the thresholds were loaded; false if the file does not exist or
+     *         was measured for another configuration.
+     * @throws std::runtime_error if the file is malformed.
+     */
+    inline bool loadWisdom(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+
+        std::string backend;
+        size_t threads = 0;
+        std::vector<size_t> values(detail::operationCount, 0);
+        std::vector<bool> seen(detail::operationCount, false);
+        std::string line;
+
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            std::istringstream fields(line);
+            std::string key;
+            if (!(fields >> key)) {
+                continue;
+            }
+
+            if (key == "backend") {
+                fields >> backend;
+            } else if (key == "threads") {
+                fields >> threads;
+            } else {
+                size_t op = 0;
+                while (op < detail::operationCount && key != detail::operationName(op)) {
+                    ++op;
+                }
+                if (op == detail::operationCount || !(fields >> values[op])) {
+                    throw std::runtime_error("Malformed wisdom file " + path + ": " + line);
+                }
+                seen[op] = true;
+            }
+        }
+
+        if (std::count(seen.begin(), seen.end(), true) != static_cast<long>(detail::operationCount)) {
+            throw std::runtime_error("Malformed wisdom file " + path + ": missing thresholds");
+        }
+
+        if (backend != detail::backendName(getBackend()) || threads != getNumThreads()) {
+            return false;
+        }
+
+        for (size_t op = 0; op < detail::operationCount; ++op) {
+            setThreshold(static_cast<Operation>(op), values[op]);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Measures the parallel break-even point of every operation class on this
+     * machine, with the current backend and thread count, and sets the thresholds.
+     *
+     * Each class is timed serially and in parallel on a representative kernel of
+     * doubling size. Parallel has to win by at least 20% at two consecutive sizes, so
+     * timing noise cannot lower a threshold. The threshold becomes the largest size
+     * before that streak, and never drops below the smallest size measured. Takes
+     * around a second. Do not run other operations meanwhile.
+     */
+    inline void calibrate();
+
+    /**
+     * @brief Startup tuning: loads the wisdom file if it matches this configuration,
+     * otherwise calibrates and saves the result to it.
+     *
+     * @code
+     * int main() {
+     *     matOpsParallel::tune("matops.wisdom");
+     *     ...
+     * }
+     * @endcode
+     *
+     * @param path Path of the wisdom file.
+     */
+    inline void tune(const std::string& path) {
+        if (!loadWisdom(path)) {
+            calibrate();
+            saveWisdom(path);
+        }
+    }
+
+    /**
+     * @brief The library's thread pool, started on first use with getNumThreads() workers
+     * (as configured for the ThreadPool backend).
+     */
+    inline ThreadPool& pool() {
+        std::lock_guard<std::mutex> guard(detail::poolLock());
+        std::unique_ptr<ThreadPool>& slot = detail::poolSlot();
+        if (!slot) {
+            slot.reset(new ThreadPool(detail::settings().threads, detail::cpuOrder(detail::settings().affinity)));
+        }
+        return *slot;
+    }
+
+    /**
+     * @brief Runs body(lo, hi) over sub-ranges that partition [begin, end), in parallel.
+     *
+     * With Schedule::Static the range is cut into one contiguous chunk per thread; with
+     * Schedule::Dynamic into chunks of grain iterations handed out on demand. Chunks
+     * are disjoint, but the thread that runs a given chunk is unspecified, so results
+     * must not depend on it. Static chunk c is nonetheless run by thread c whenever
+     * possible, so loops over the same range revisit the rows each thread first
+     * touched (see Placement). The first exception thrown by the body is rethrown on the
+     * calling thread once every chunk has finished.
+     *
+     * The backend, thread count and affinity come from the calling thread's
+     * ExecutionContext. Loops started from inside another loop's body, or from an OpenMP
+     * parallel region, run serially (see inParallelRegion()).
+     *
+     * Per-range bodies suit loops that set up scratch storage once per chunk.
+     *
+     * @param begin First index.
+     * @param end One past the last index.
+     * @param parallel Runs serially on the calling thread when false (the cut-off for
+     *        small problems).
+     * @param body Callable invoked as body(size_t lo, size_t hi).
+     * @param schedule Static or Dynamic.
+     * @param grain Chunk size for Schedule::Dynamic.
+     */
+    template <typename F>
+    void parallelForRange(size_t begin, size_t end, bool parallel, F body,
+                          Schedule schedule = Schedule::Static, size_t grain = 1) {
+        if (end <= begin) {
+            return;
+        }
+
+        const size_t n = end - begin;
+        const Backend backend = getBackend();
+        const size_t threads = getNumThreads();
+
+        if (!parallel || backend == Backend::Serial || threads <= 1 || n == 1 || inParallelRegion()) {
+            body(begin, end);
+            return;
+        }
+
+        grain = std::max<size_t>(grain, 1);
+        const size_t chunks = schedule == Schedule::Static
+            ? std::min(threads, n)
+            : (n + grain - 1) / grain;
+        const Affinity affinity = getAffinity();
+
+        auto runChunk = [&](size_t c) {
+            detail::LoopScope scope;
+            if (schedule == Schedule::Static) {
+                body(begin + n * c / chunks, begin + n * (c + 1) / chunks);
+            } else {
+                body(begin + c * grain, std::min(end, begin + (c + 1) * grain));
+            }
+        };
+
+        if (backend == Backend::OpenMP) {
+            std::exception_ptr error;
+
+            #ifdef _OPENMP
+                // Teams of concurrent contexts bind to their own slices of the CPU order.
+                const ExecutionContext* context = detail::contextSlot();
+                const size_t cpuOffset = context != nullptr ? context->cpuOffset : 0;
+            #endif
+
+            auto guardedChunk = [&](size_t c) {
+                // Thread 0 is the calling thread, which stays unbound as with the pool.
+                #ifdef _OPENMP
+                    const size_t thread = static_cast<size_t>(omp_get_thread_num());
+                    if (thread != 0) {
+                        detail::bindToAffinity(cpuOffset + thread, affinity);
+                    }
+                #endif
+                try {
+                    runChunk(c);
+                } catch (...) {
+                    #pragma omp critical(matOpsParallelError)
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            };
+
+            if (schedule == Schedule::Static) {
+                #pragma omp parallel for num_threads(static_cast<int>(threads)) schedule(static, 1)
+                for (size_t c = 0; c < chunks; ++c) {
+                    guardedChunk(c);
+                }
+            } else {
+                #pragma omp parallel for num_threads(static_cast<int>(threads)) schedule(dynamic, 1)
+                for (size_t c = 0; c < chunks; ++c) {
+                    guardedChunk(c);
+                }
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return;
+        }
+
+        ThreadPool& workers = pool();
+        std::shared_ptr<detail::LoopState> state = std::make_shared<detail::LoopState>(chunks, [&](size_t c) {
+            // The calling thread is not bound; workers follow the loop's affinity.
+            if (workers.isWorkerThread()) {
+                detail::bindToAffinity(workers.workerIndex(), affinity);
+            }
+            runChunk(c);
+        });
+
+        const size_t helpers = std::min(std::min(threads, workers.size() + 1), chunks) - 1;
+        for (size_t h = 0; h < helpers; ++h) {
+            if (schedule == Schedule::Static) {
+                // Helper h prefers chunk h + 1 and is queued on worker h, pinning chunks to threads.
+                workers.submitTo(h, [state, h] { state->work(h + 1); });
+            } else {
+                workers.submit([state] { state->work(detail::LoopState::noChunk); });
+            }
+        }
+
+        // The caller claims chunks too, so the loop completes even when every worker is busy.
+        state->work(schedule == Schedule::Static ? 0 : detail::LoopState::noChunk);
+
+        {
+            std::unique_lock<std::mutex> guard(state->lock);
+            state->finished.wait(guard, [&] { return state->done.load() == chunks; });
+        }
+
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+    /**
+     * @brief Runs body(i) for every i in [begin, end), in parallel.
+     *
+     * Equivalent of an OpenMP "parallel for" with an if() clause; see parallelForRange()
+     * for the schedule and exception semantics.
+     *
+     * @code
+     * const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, rows * cols);
+     * matOpsParallel::parallelFor(0, rows, parallel, [&](size_t i) {
+     *     out[i] = work(i);
+     * });
+     * @endcode
+     */
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, bool parallel, F body,
+                     Schedule schedule = Schedule::Static, size_t grain = 1) {
+        parallelForRange(begin, end, parallel, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                body(i);
+            }
+        }, schedule, grain);
+    }
+
+    /**
+     * @brief Runs initRow(i) for every row i of a new matrix on the threads chosen by the
+     * current Placement, so the row's pages are first touched on the right NUMA node.
+     *
+     * initRow must allocate and write row i itself (e.g. rows[i].assign(cols, 0.0)):
+     * memory is placed by the first write, not by the allocation of the outer vector.
+     *
+     * @param rows Number of rows.
+     * @param work Elements initialized; small matrices are initialized serially.
+     * @param initRow Callable invoked as initRow(size_t i).
+     */
+    template <typename F>
+    void firstTouch(size_t rows, size_t work, F initRow) {
+        const bool parallel = exceedsThreshold(Operation::Elementwise, work);
+
+        switch (getPlacement()) {
+            case Placement::Serial:
+                for (size_t i = 0; i < rows; ++i) {
+                    initRow(i);
+                }
+                return;
+            case Placement::Partitioned:
+                parallelFor(0, rows, parallel, initRow, Schedule::Static);
+                return;
+            case Placement::Interleaved:
+                break;
+        }
+
+        // One static chunk per thread, each touching every stride-th row.
+        const size_t stride = std::max<size_t>(1, std::min(getNumThreads(), rows));
+        parallelFor(0, stride, parallel, [&](size_t first) {
+            for (size_t i = first; i < rows; i += stride) {
+                initRow(i);
+            }
+        }, Schedule::Static);
+    }
+
+}
+
+/**
+ * @brief Cache blocking of the dense GEMM kernel behind Matrix::operator*.
+ *
+ * The best panel sizes depend on the cache hierarchy, so they are kept per shape class
+ * and can be measured on the current CPU with tune() / plan(). Results are persisted in
+ * a wisdom file keyed by CPU model, which can be shared by nodes of different types.
+ */
+namespace matOpsGemm {
+
+    /**
+     * @brief Shape classes of a product (m x k) * (k x n) with separately tuned blocking.
+     *
+     * Tall has m >= 4 max(k, n), Wide n >= 4 max(m, k), Deep k >= 4 max(m, n);
+     * everything else is Square.
+     */
+    enum class ShapeClass { Square, Tall, Wide, Deep };
+
+    /**
+     * @brief Panel sizes of the blocked GEMM kernel.
+     *
+     * The kernel walks rowPanel rows of A and C at a time and, within them, multiplies
+     * depthPanel x colPanel panels of B, which should fit in the L2 cache while they are
+     * reused by every row of the panel.
+     */
+    struct Blocking {
+        size_t rowPanel;
+        size_t depthPanel;
+        size_t colPanel;
+    };
+
+    namespace detail {
+
+        const size_t shapeCount = 4;
+
+        inline const char* shapeName(size_t shape) {
+            static const char* const names[shapeCount] = { "square", "tall", "wide", "deep" };
+            return names[shape];
+        }
+
+        /* Serializes writers; readers go through the atomic pointer of current(). */
+        inline std::mutex& lock() {
+            static std::mutex instance;
+            return instance;
+        }
+
+        /* An immutable set of blockings, one per shape class. */
+        struct Table {
+            Blocking blockings[shapeCount];
+        };
+
+        inline std::atomic<const Table*>& current() {
+            static std::atomic<const Table*> table(new Table{ {
+                { 64, 128, 512 }, { 64, 128, 512 }, { 64, 128, 512 }, { 64, 128, 512 }
+            } });
+            return table;
+        }
+
+        /*
+         * Tables replaced by setBlocking(). A product may still be reading one, so they are
+         * kept rather than freed; each is under 100 bytes.
+         */
+        inline std::vector<std::unique_ptr<const Table>>& retired() {
+            static std::vector<std::unique_ptr<const Table>> tables;
+            return tables;
+        }
+
+    }
+
+    /// @brief The blocking used by default for every shape class.
+    inline Blocking defaultBlocking() {
+        return Blocking{ 64, 128, 512 };
+    }
+
+    /// @brief Shape class of the product (m x k) * (k x n).
+    inline ShapeClass classify(size_t m, size_t k, size_t n) {
+        if (m >= 4 * std::max(k, n)) {
+            return ShapeClass::Tall;
+        }
+        if (n >= 4 * std::max(m, k)) {
+            return ShapeClass::Wide;
+        }
+        if (k >= 4 * std::max(m, n)) {
+            return ShapeClass::Deep;
+        }
+        return ShapeClass::Square;
+    }
+
+    /// @brief The blocking currently used for a shape class.
+    inline Blocking getBlocking(ShapeClass shape) {
+        return detail::current().load(std::memory_order_acquire)->blockings[static_cast<size_t>(shape)];
+    }
+
+    /**
+     * @brief Pins the blocking of a shape class.
+     * @throws std::invalid_argument if a panel size is zero.
+     */
+    inline void setBlocking(ShapeClass shape, Blocking blocking) {
+        if (blocking.rowPanel == 0 || blocking.depthPanel == 0 || blocking.colPanel == 0) {
+            throw std::invalid_argument("Panel sizes must be positive");
+        }
+
+        std::lock_guard<std::mutex> guard(detail::lock());
+        const detail::Table* previous = detail::current().load();
+        std::unique_ptr<detail::Table> next(new detail::Table(*previous));
+        next->blockings[static_cast<size_t>(shape)] = blocking;
+
+        detail::retired().emplace_back(previous);
+        detail::current().store(next.release(), std::memory_order_release);
+    }
+
+    /// @brief Restores defaultBlocking() for every shape class.
+    inline void resetBlocking() {
+        for (size_t shape = 0; shape < detail::shapeCount; ++shape) {
+            setBlocking(static_cast<ShapeClass>(shape), defaultBlocking());
+        }
+    }
+
+    /**
+     * @brief Model name of the CPU (the "model name" of /proc/cpuinfo), or "unknown"
+     * where it is not available.
+     */
+    inline std::string cpuModel() {
+        std::ifstream info("/proc/cpuinfo");
+        std::string line;
+
+        while (std::getline(info, line)) {
+            if (line.compare(0, 10, "model name") != 0) {
+                continue;
+            }
+
+            const size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                break;
+            }
+
+            const size_t first = line.find_first_not_of(" \t", colon + 1);
+            const size_t last = line.find_last_not_of(" \t\r");
+            if (first != std::string::npos && last >= first) {
+                return line.substr(first, last - first + 1);
+            }
+        }
+
+        return "unknown";
+    }
+
+    /**
+     * @brief Times candidate panel sizes for a shape class on this CPU, with the current
+     * backend and thread count, and keeps the fastest.
+     *
+     * Runs a representative product of the class (a few hundred rows and columns) once
+     * per candidate; takes a fraction of a second. Do not run other products meanwhile.
+     *
+     * @param shape The shape class to tune.
+     * @return The chosen blocking, now in effect.
+     */
+    inline Blocking tune(ShapeClass shape);
+
+    /**
+     * @brief Writes the current blockings to a wisdom file, under this CPU's model.
+     *
+     * Entries of other CPU models already in the file are kept, so nodes of different
+     * types can share one file. One line per entry: shape, the three panel sizes, and
+     * the CPU model.
+     *
+     * The new contents go to a temporary file in the same directory, which is then
+     * renamed over @p path. Readers and concurrent savers therefore never see a
+     * truncated file. When two nodes save at the same time, the last rename wins.
+     *
+     * @param path Path of the wisdom file.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    inline void saveWisdom(const std::string& path) {
+        const std::string cpu = cpuModel();
+        std::vector<std::string> kept;
+
+        {
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line)) {
+                std::istringstream fields(line);
+                std::string shape, model;
+                size_t mc, kc, nc;
+                if (fields >> shape >> mc >> kc >> nc && std::getline(fields >> std::ws, model) && model != cpu) {
+                    kept.push_back(line);
+                }
+            }
+        }
+
+        // Unique per process and thread, so concurrent savers never share a temporary file.
+        const size_t salt = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+            static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        const std::string temporary = path + "." + std::to_string(salt) + ".tmp";
+
+        {
+            std::ofstream out(temporary);
+            for (const std::string& line : kept) {
+                out << line << "\n";
+            }
+            for (size_t shape = 0; shape < detail::shapeCount; ++shape) {
+                const Blocking b = getBlocking(static_cast<ShapeClass>(shape));
+                out << detail::shapeName(shape) << " " << b.rowPanel << " " << b.depthPanel << " "
+                    << b.colPanel << " " << cpu << "\n";
+            }
+
+            out.close();
+            if (!out) {
+                std::remove(temporary.c_str());
+                throw std::runtime_error("Cannot write wisdom file: " + path);
+            }
+        }
+
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot write wisdom file: " + path);
+        }
+    }
+
+    /**
+     * @brief Loads the blockings stored for this CPU model by saveWisdom().
+     *
+     * @param path Path of the wisdom file.
+     * @return The number of shape classes loaded (0 if the file does not exist or has
+     *         no entries for this CPU).
+     */
+    inline size_t loadWisdom(const std::string& path) {
+        const std::string cpu = cpuModel();
+        std::ifstream in(path);
+        std::string line;
+        size_t loaded = 0;
+
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string shape, model;
+            Blocking b;
+            if (!(fields >> shape >> b.rowPanel >> b.depthPanel >> b.colPanel) ||
+                !std::getline(fields >> std::ws, model) || model != cpu ||
+                b.rowPanel == 0 || b.depthPanel == 0 || b.colPanel == 0) {
+                continue;
+            }
+
+            for (size_t s = 0; s < detail::shapeCount; ++s) {
+                if (shape == detail::shapeName(s)) {
+                    setBlocking(static_cast<ShapeClass>(s), b);
+                    ++loaded;
+                }
+            }
+        }
+
+        return loaded;
+    }
+
+    /**
+     * @brief Loads the stored blockings for this CPU, tuning and saving them only when
+     * the wisdom file has none yet.
+     *
+     * @code
+     * matOpsGemm::plan("gemm.wisdom"); // first run: tunes (~1 s), later runs: instant
+     * @endcode
+     *
+     * @param path Path of the wisdom file.
+     * @return true if the blockings were tuned, false if they were loaded.
+     */
+    inline bool plan(const std::string& path) {
+        if (loadWisdom(path) == detail::shapeCount) {
+            return false;
+        }
+
+        for (size_t shape = 0; shape < detail::shapeCount; ++shape) {
+            tune(static_cast<ShapeClass>(shape));
+        }
+        saveWisdom(path);
+        return true;
+    }
+
+}
+
+namespace matOpsDetail {
+
+    /**
+     * @brief Builds the exception thrown when the operands of a product have incompatible shapes.
+     */
+    inline std::invalid_argument productShapeError(size_t m, size_t n, size_t p, size_t r) {
+        return std::invalid_argument(
+            "Incorrect dimensions: For matrices (m x n) and (p x r), n must be equal to p. "
+            "Given: (" + std::to_string(m) + "x" + std::to_string(n) +
+            ") and (" + std::to_string(p) + "x" + std::to_string(r) + ")."
+        );
+    }
+
+    /**
+     * @brief Dense row-major GEMM kernel: C += alpha * A * B^T.
+     *
+     * A is (m x k), B is (n x k) and C is (m x n), with leading dimensions lda, ldb
+     * and ldc. Both operands are read along contiguous rows, which is the access
+     * pattern of the outer-product updates in blocked factorizations.
+     *
+     * @note The output is tiled so that a tile of C stays in cache while the
+     *       matching rows of A and B are streamed through it.
+     */
+    inline void gemmNT(size_t m, size_t n, size_t k, double alpha,
+                       const double* A, size_t lda, const double* B, size_t ldb,
+                       double* C, size_t ldc) {
+        const size_t tile = 64;
+        const size_t nTiles = (m + tile - 1) / tile;
+
+        const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Multiply, m * n * k);
+        matOpsParallel::parallelFor(0, nTiles, parallel, [&](size_t t) {
+            const size_t iEnd = std::min(m, (t + 1) * tile);
+
+            for (size_t j0 = 0; j0 < n; j0 += tile) {
+                const size_t jEnd = std::min(n, j0 + tile);
+
+                for (size_t i = t * tile; i < iEnd; ++i) {
+                    const double* ai = A + i * lda;
+                    double* ci = C + i * ldc;
+
+                    for (size_t j = j0; j < jEnd; ++j) {
+                        const double* bj = B + j * ldb;
+                        double dot = 0.0;
+
+                        #pragma omp simd reduction(+:dot)
+                        for (size_t p = 0; p < k; ++p) {
+                            dot += ai[p] * bj[p];
+                        }
+
+                        ci[j] += alpha * dot;
+                    }
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief Blocked row-major GEMM kernel: C += A * B, on arrays of row pointers.
+     *
+     * A is (m x k), B is (k x n) and C is (m x n). Each thread gets one contiguous range
+     * of rows of A and C, the same rows a statically scheduled loop over them would give
+     * it. Products with fewer rows than threads also split the columns, so short, wide
+     * products still use every thread. Within its block, a thread walks rowPanel rows at
+     * a time and reuses depthPanel x colPanel panels of B while they sit in cache. Each
+     * C(i, j) still accumulates its terms in ascending order of k, so the result does not
+     * depend on the blocking or the thread count.
+     */
+    inline void gemmNN(size_t m, size_t n, size_t k, const double* const* A, const double* const* B,
+                       double* const* C, const matOpsGemm::Blocking& blocking) {
+        const size_t mc = blocking.rowPanel, kc = blocking.depthPanel, nc = blocking.colPanel;
+
+        const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Multiply, m * n * k);
+        const size_t threads = parallel ? matOpsParallel::getNumThreads() : 1;
+        const size_t rowParts = std::max<size_t>(1, std::min(threads, m));
+        // Column ranges start on 8-double boundaries and are at least 8 wide.
+        const size_t colParts = std::max<size_t>(1, std::min(threads / rowParts, n / 8));
+        auto colEdge = [&](size_t c) { return c == colParts ? n : n * c / colParts / 8 * 8; };
+
+        matOpsParallel::parallelFor(0, rowParts * colParts, parallel, [&](size_t part) {
+            const size_t r = part / colParts, c = part % colParts;
+            const size_t rowBegin = m * r / rowParts, rowEnd = m * (r + 1) / rowParts;
+            const size_t colBegin = colEdge(c), colEnd = colEdge(c + 1);
+
+            for (size_t i0 = rowBegin; i0 < rowEnd; i0 += mc) {
+                const size_t i1 = std::min(rowEnd, i0 + mc);
+
+                for (size_t j0 = colBegin; j0 < colEnd; j0 += nc) {
+                    const size_t j1 = std::min(colEnd, j0 + nc);
+
+                    for (size_t p0 = 0; p0 < k; p0 += kc) {
+                        const size_t p1 = std::min(k, p0 + kc);
+
+                        for (size_t i = i0; i < i1; ++i) {
+                            const double* ai = A[i];
+                            double* ci = C[i];
+
+                            for (size_t p = p0; p < p1; ++p) {
+                                const double aip = ai[p];
+                                const double* bp = B[p];
+
+                                #pragma omp simd
+                                for (size_t j = j0; j < j1; ++j) {
+                                    ci[j] += aip * bp[j];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }, matOpsParallel::Schedule::Static);
+    }
+}
+
+namespace matOpsDetail {
+
+    /// @brief Reinterprets the bits of a double as an unsigned 64-bit integer.
+    inline uint64_t toBits(double x) {
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof bits);
+        return bits;
+    }
+
+    /// @brief Reinterprets an unsigned 64-bit integer as a double.
+    inline double fromBits(uint64_t bits) {
+        double x;
+        std::memcpy(&x, &bits, sizeof x);
+        return x;
+    }
+
+    /**
+     * @brief Branch-free cond ? a : b.
+     *
+     * A plain ternary lets the compiler move the computation of the unused operand
+     * behind a branch, and since floating point operations may trap it then refuses to
+     * if-convert the loop again, so the loop is not vectorized. Blending through a bit
+     * mask keeps both operands live.
+     */
+    inline double select(bool cond, double a, double b) {
+        const uint64_t mask = 0 - static_cast<uint64_t>(cond);
+        return fromBits((toBits(a) & mask) | (toBits(b) & ~mask));
+    }
+
+    /**
+     * @brief Number of representable doubles between a and b (0 if a == b, including
+     * +0 and -0; the maximum uint64_t if either is NaN).
+     */
+    inline uint64_t ulpDistance(double a, double b) {
+        const uint64_t sign = 0x8000000000000000ULL;
+        const uint64_t ua = toBits(a), ub = toBits(b);
+
+        // Map the sign-magnitude encoding to an unsigned scale that is monotone in the value.
+        const uint64_t ka = (ua & sign) ? sign - (ua & ~sign) : sign + ua;
+        const uint64_t kb = (ub & sign) ? sign - (ub & ~sign) : sign + ub;
+        const uint64_t dist = ka > kb ? ka - kb : kb - ka;
+
+        return (a != a || b != b) ? std::numeric_limits<uint64_t>::max() : dist;
+    }
+
+    /// @brief xxHash64 primes.
+    const uint64_t xxPrime1 = 11400714785074694791ULL;
+    const uint64_t xxPrime2 = 14029467366897019727ULL;
+    const uint64_t xxPrime3 = 1609587929392839161ULL;
+    const uint64_t xxPrime4 = 9650029242287828579ULL;
+    const uint64_t xxPrime5 = 2870177450012600261ULL;
+
+    inline uint64_t rotl64(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t xxRound(uint64_t acc, uint64_t input) {
+        return rotl64(acc + input * xxPrime2, 31) * xxPrime1;
+    }
+
+    inline uint64_t xxMerge(uint64_t acc, uint64_t val) {
+        return (acc ^ xxRound(0, val)) * xxPrime1 + xxPrime4;
+    }
+
+    inline uint64_t xxWord(uint64_t x) { return x; }
+    inline uint64_t xxWord(double x) { return toBits(x); }
+
+    /**
+     * @brief xxHash64 of n 64-bit words (the reference algorithm restricted to inputs
+     * whose length is a multiple of 8 bytes). Doubles are hashed by their bit patterns.
+     *
+     * Stripes of four words go to four independent accumulators, which keeps the
+     * multiply latency off the critical path.
+     */
+    template <typename T>
+    uint64_t xxHash64(const T* words, size_t n, uint64_t seed) {
+        size_t i = 0;
+        uint64_t h;
+
+        if (n >= 4) {
+            uint64_t v[4] = { seed + xxPrime1 + xxPrime2, seed + xxPrime2, seed, seed - xxPrime1 };
+
+            for (; i + 4 <= n; i += 4) {
+                for (int l = 0; l < 4; ++l) {
+                    v[l] = xxRound(v[l], xxWord(words[i + l]));
+                }
+            }
+
+            h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+            for (int l = 0; l < 4; ++l) {
+                h = xxMerge(h, v[l]);
+            }
+        } else {
+            h = seed + xxPrime5;
+        }
+
+        h += static_cast<uint64_t>(n) * 8;
+
+        for (; i < n; ++i) {
+            h = rotl64(h ^ xxRound(0, xxWord(words[i])), 27) * xxPrime1 + xxPrime4;
+        }
+
+        h ^= h >> 33;
+        h *= xxPrime2;
+        h ^= h >> 29;
+        h *= xxPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    /// @brief Returns a process-wide unique, increasing version stamp.
+    inline uint64_t nextVersion() {
+        static std::atomic<uint64_t> counter(0);
+        return ++counter;
+    }
+
+    /**
+     * @brief out[j] *= sqrt(in[j]) for n contiguous elements, correctly rounded.
+     *
+     * GCC does not vectorize std::sqrt unless built with -fno-math-errno, so SSE2
+     * targets use sqrtpd directly. It gives the same correctly rounded results.
+     */
+    inline void multiplyBySqrt(double* out, const double* in, size_t n) {
+        size_t j = 0;
+        #ifdef __SSE2__
+            for (; j + 2 <= n; j += 2) {
+                const __m128d root = _mm_sqrt_pd(_mm_loadu_pd(in + j));
+                _mm_storeu_pd(out + j, _mm_mul_pd(_mm_loadu_pd(out + j), root));
+            }
+        #endif
+        for (; j < n; ++j) {
+            out[j] *= std::sqrt(in[j]);
+        }
+    }
+
+    /// @brief Naive sum of n contiguous values over 2 * MATOPS_SIMD_DOUBLES lanes.
+    inline double laneSum(const double* a, size_t n) {
+        const size_t lanes = 2 * MATOPS_SIMD_DOUBLES;
+        double acc[lanes] = {};
+
+        size_t j = 0;
+        for (; j + lanes <= n; j += lanes) {
+            #pragma omp simd
+            for (size_t l = 0; l < lanes; ++l) {
+                acc[l] += a[j + l];
+            }
+        }
+
+        double res = 0.0;
+        for (size_t l = 0; l < lanes; ++l) {
+            res += acc[l];
+        }
+        for (; j < n; ++j) {
+            res += a[j];
+        }
+
+        return res;
+    }
+
+    /// @brief Pairwise sum: halves down to 256 values, which are summed with laneSum().
+    inline double pairwiseSum(const double* a, size_t n) {
+        if (n <= 256) {
+            return laneSum(a, n);
+        }
+
+        const size_t half = n / 2;
+        return pairwiseSum(a, half) + pairwiseSum(a + half, n - half);
+    }
+
+    /**
+     * @brief One step of Kahan-Babuska (Neumaier) summation: adds x to sum and the
+     * rounding error of that addition to comp. Unlike plain Kahan it stays exact when
+     * x is larger in magnitude than the running sum.
+     */
+    inline void neumaierAdd(double& sum, double& comp, double x) {
+        const double t = sum + x;
+        const bool sumLarger = std::abs(sum) >= std::abs(x);
+        comp += (select(sumLarger, sum, x) - t) + select(sumLarger, x, sum);
+        sum = t;
+    }
+
+    /// @brief Compensated (Kahan-Babuska) sum, one compensation term per SIMD lane.
+    inline double kahanSum(const double* a, size_t n) {
+        const size_t lanes = 2 * MATOPS_SIMD_DOUBLES;
+        double acc[lanes] = {};
+        double comp[lanes] = {};
+
+        size_t j = 0;
+        for (; j + lanes <= n; j += lanes) {
+            #pragma omp simd
+            for (size_t l = 0; l < lanes; ++l) {
+                neumaierAdd(acc[l], comp[l], a[j + l]);
+            }
+        }
+
+        double res = 0.0, c = 0.0;
+        for (size_t l = 0; l < lanes; ++l) {
+            neumaierAdd(res, c, acc[l]);
+            c += comp[l];
+        }
+        for (; j < n; ++j) {
+            neumaierAdd(res, c, a[j]);
+        }
+
+        return res + c;
+    }
+
+    /// @brief Sum of n contiguous values with the given method.
+    inline double sumSpan(const double* a, size_t n, Summation method) {
+        switch (method) {
+            case Summation::Pairwise: return pairwiseSum(a, n);
+            case Summation::Kahan:    return kahanSum(a, n);
+            default:                  return laneSum(a, n);
+        }
+    }
+
+    /**
+     * @brief Adds rows[i0, i1) element-wise into out (n values per row) with the given
+     * method: Naive in row order, Pairwise by recursive halving of the row range, Kahan
+     * with one compensation term per column.
+     */
+    inline void sumRows(const std::vector<std::vector<double>>& rows, size_t i0, size_t i1,
+                        size_t n, double* out, Summation method) {
+        if (method == Summation::Pairwise && i1 - i0 > 8) {
+            const size_t mid = i0 + (i1 - i0) / 2;
+            std::vector<double> upper(n, 0.0);
+            sumRows(rows, i0, mid, n, out, method);
+            sumRows(rows, mid, i1, n, upper.data(), method);
+
+            #pragma omp simd
+            for (size_t j = 0; j < n; ++j) {
+                out[j] += upper[j];
+            }
+            return;
+        }
+
+        if (method == Summation::Kahan) {
+            std::vector<double> comp(n, 0.0);
+            double* c = comp.data();
+
+            for (size_t i = i0; i < i1; ++i) {
+                const double* a = rows[i].data();
+
+                #pragma omp simd
+                for (size_t j = 0; j < n; ++j) {
+                    neumaierAdd(out[j], c[j], a[j]);
+                }
+            }
+
+            #pragma omp simd
+            for (size_t j = 0; j < n; ++j) {
+                out[j] += c[j];
+            }
+            return;
+        }
+
+        for (size_t i = i0; i < i1; ++i) {
+            const double* a = rows[i].data();
+
+            #pragma omp simd
+            for (size_t j = 0; j < n; ++j) {
+                out[j] += a[j];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Vectorizable elementary functions.
+ *
+ * The libm versions of these functions cannot be vectorized by the compiler (they are
+ * opaque calls that may set errno), so loops over them run one element at a time.
+ * The functions below are written branch-free, using only arithmetic, comparisons and
+ * bit manipulation, and are declared `omp declare simd`, so a loop calling them under
+ * `#pragma omp simd` processes a full SIMD register per iteration. (The blends need
+ * 64-bit vector compares, i.e. SSE4.2/AVX or later: build with -march=native. On
+ * baseline x86-64 the results are identical but the loops stay scalar.)
+ *
+ * Accuracy (relative, over the whole double range unless stated):
+ *  - exp, log: a few ulp; subnormal results of exp keep only their stored bits.
+ *  - sqrt: within 1 ulp.
+ *  - tanh, sigmoid: a few ulp.
+ *  - erf: about 1e-15.
+ *
+ * The functors (Exp, Log, ...) wrap the functions for Matrix::apply() and friends.
+ *
+ * Example Usage:
+ * @code
+ * Matrix Y = X.apply(matOpsMath::Sigmoid());
+ * @endcode
+ */
+namespace matOpsMath {
+
+    /**
+     * @brief e^x.
+     *
+     * x = n ln2 + r with |r| <= ln2 / 2, e^r from its degree 13 Taylor polynomial and
+     * 2^n built directly in the exponent bits (split in two factors so that subnormal
+     * results are still produced).
+     */
+    #pragma omp declare simd
+    inline double exp(double x) {
+        const double log2e   = 1.4426950408889634;
+        const double ln2Hi   = 6.93147180369123816490e-01;
+        const double ln2Lo   = 1.90821492927058770002e-10;
+        const double shifter = 6755399441055744.0; // 1.5 * 2^52: adding it rounds to an integer.
+
+        // Past the clamp the scale factors overflow or underflow on their own, so
+        // +-inf and out-of-range arguments need no special casing (NaN passes through).
+        double xc = matOpsDetail::select(x > 710.0, 710.0, x);
+        xc = matOpsDetail::select(xc < -746.0, -746.0, xc);
+        const double n = (xc * log2e + shifter) - shifter;
+        const double r = (xc - n * ln2Hi) - n * ln2Lo;
+
+        double p = 1.0 / 6227020800.0;
+        p = p * r + 1.0 / 479001600.0;
+        p = p * r + 1.0 / 39916800.0;
+        p = p * r + 1.0 / 3628800.0;
+        p = p * r + 1.0 / 362880.0;
+        p = p * r + 1.0 / 40320.0;
+        p = p * r + 1.0 / 5040.0;
+        p = p * r + 1.0 / 720.0;
+        p = p * r + 1.0 / 120.0;
+        p = p * r + 1.0 / 24.0;
+        p = p * r + 1.0 / 6.0;
+        p = p * r + 0.5;
+        p = p * r + 1.0;
+        p = p * r + 1.0;
+
+        // 2^n = 2^n1 * 2^n2, both factors normal. The biased exponent lands in the
+        // low mantissa bits after adding the shifter and is moved into place.
+        const double n1 = (n * 0.5 - 0.25 + shifter) - shifter;
+        const double n2 = n - n1;
+        const double s1 = matOpsDetail::fromBits(matOpsDetail::toBits(n1 + 1023.0 + shifter) << 52);
+        const double s2 = matOpsDetail::fromBits(matOpsDetail::toBits(n2 + 1023.0 + shifter) << 52);
+
+        return p * s1 * s2;
+    }
+
+    /**
+     * @brief Natural logarithm.
+     *
+     * x = 2^e * m with m in [sqrt(2)/2, sqrt(2)], and log(m) = 2 atanh((m - 1) / (m + 1))
+     * from its odd series, which converges fast on that interval.
+     */
+    #pragma omp declare simd
+    inline double log(double x) {
+        const double ln2Hi = 6.93147180369123816490e-01;
+        const double ln2Lo = 1.90821492927058770002e-10;
+
+        const bool subnormal = x < 2.2250738585072014e-308;
+        const double xs = matOpsDetail::select(subnormal, x * 18014398509481984.0, x); // 2^54
+        const uint64_t bits = matOpsDetail::toBits(xs);
+
+        // Biased exponent converted to double through the 2^52 trick.
+        double e = matOpsDetail::fromBits((bits >> 52) | 0x4330000000000000ULL) - 4503599627370496.0 - 1023.0;
+        double m = matOpsDetail::fromBits((bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL);
+
+        const bool high = m > 1.4142135623730951;
+        m = matOpsDetail::select(high, m * 0.5, m);
+        e = matOpsDetail::select(high, e + 1.0, e);
+        e = matOpsDetail::select(subnormal, e - 54.0, e);
+
+        const double f = (m - 1.0) / (m + 1.0);
+        const double s = f * f;
+
+        double p = 1.0 / 21.0;
+        p = p * s + 1.0 / 19.0;
+        p = p * s + 1.0 / 17.0;
+        p = p * s + 1.0 / 15.0;
+        p = p * s + 1.0 / 13.0;
+        p = p * s + 1.0 / 11.0;
+        p = p * s + 1.0 / 9.0;
+        p = p * s + 1.0 / 7.0;
+        p = p * s + 1.0 / 5.0;
+        p = p * s + 1.0 / 3.0;
+        p = p * s + 1.0;
+
+        double res = e * ln2Hi + (2.0 * f * p + e * ln2Lo);
+        res = matOpsDetail::select(x == 0.0, -std::numeric_limits<double>::infinity(), res);
+        res = matOpsDetail::select(x < 0.0, std::numeric_limits<double>::quiet_NaN(), res);
+        res = matOpsDetail::select(x == std::numeric_limits<double>::infinity(), x, res);
+        return matOpsDetail::select(x != x, x, res);
+    }
+
+    /**
+     * @brief Square root.
+     *
+     * Newton iterations on the reciprocal square root, started from the classic bit
+     * level estimate, followed by one correction step on sqrt(x) itself.
+     */
+    #pragma omp declare simd
+    inline double sqrt(double x) {
+        const bool subnormal = x < 2.2250738585072014e-308;
+        const double xs = matOpsDetail::select(subnormal, x * 324518553658426726783156020576256.0, x); // 2^108
+
+        double r = matOpsDetail::fromBits(0x5FE6EB50C7B537A9ULL - (matOpsDetail::toBits(xs) >> 1));
+        r = r * (1.5 - 0.5 * xs * r * r);
+        r = r * (1.5 - 0.5 * xs * r * r);
+        r = r * (1.5 - 0.5 * xs * r * r);
+        r = r * (1.5 - 0.5 * xs * r * r);
+
+        double y = xs * r;
+        y = y + 0.5 * r * (xs - y * y);
+        y = matOpsDetail::select(subnormal, y * 5.5511151231257827e-17, y); // 2^-54
+
+        y = matOpsDetail::select(x == 0.0, x, y);
+        y = matOpsDetail::select(x < 0.0, std::numeric_limits<double>::quiet_NaN(), y);
+        y = matOpsDetail::select(x == std::numeric_limits<double>::infinity(), x, y);
+        return matOpsDetail::select(x != x, x, y);
+    }
+
+    /**
+     * @brief Hyperbolic tangent.
+     *
+     * |x| > 0.625 uses 1 - 2 / (e^(2|x|) + 1); smaller arguments use a rational
+     * approximation (Cephes) that avoids the cancellation of the exponential form.
+     */
+    #pragma omp declare simd
+    inline double tanh(double x) {
+        const double ax = std::abs(x);
+
+        double large = 1.0 - 2.0 / (matOpsMath::exp(2.0 * ax) + 1.0);
+        large = matOpsDetail::select(x < 0.0, -large, large);
+
+        const double s = x * x;
+        const double P = (-9.64399179425052238628E-1 * s - 9.92877231001918586564E1) * s - 1.61468768441708447952E3;
+        const double Q = ((s + 1.12811678491632931402E2) * s + 2.23548839060100448583E3) * s + 4.84406305325125486048E3;
+        const double small = x + x * s * P / Q;
+
+        return matOpsDetail::select(ax > 0.625, large, small);
+    }
+
+    /**
+     * @brief Logistic sigmoid 1 / (1 + e^-x).
+     */
+    #pragma omp declare simd
+    inline double sigmoid(double x) {
+        return 1.0 / (1.0 + matOpsMath::exp(-x));
+    }
+
+    /**
+     * @brief Error function.
+     *
+     * |x| < 2 uses the series erf(x) = 2/sqrt(pi) e^(-x^2) sum 2^n x^(2n+1) / (2n+1)!!,
+     * whose terms are all positive (no cancellation). Larger arguments use
+     * erf(x) = 1 - erfc(x) with the continued fraction of erfc. Both have a fixed
+     * number of terms so the function stays branch-free.
+     */
+    #pragma omp declare simd
+    inline double erf(double x) {
+        const double ax = std::abs(x);
+        const double x2 = ax * ax;
+        const double expm = matOpsMath::exp(-x2);
+
+        double term = ax, sum = ax;
+        #pragma GCC unroll 30
+        for (int k = 1; k <= 30; ++k) {
+            term *= 2.0 * x2 / (2 * k + 1);
+            sum += term;
+        }
+        const double series = 1.1283791670955126 * expm * sum; // 2 / sqrt(pi)
+
+        double f = ax;
+        #pragma GCC unroll 40
+        for (int k = 40; k >= 1; --k) {
+            f = ax + 0.5 * k / f;
+        }
+        const double fraction = 1.0 - expm / (1.7724538509055160 * f); // sqrt(pi)
+
+        double res = matOpsDetail::select(ax < 2.0, series, fraction);
+        res = matOpsDetail::select(ax > 6.0, 1.0, res);
+        return matOpsDetail::select(x < 0.0, -res, res);
+    }
+
+    /// @brief Functor for matOpsMath::exp().
+    struct Exp { double operator()(double x) const { return matOpsMath::exp(x); } };
+
+    /// @brief Functor for matOpsMath::log().
+    struct Log { double operator()(double x) const { return matOpsMath::log(x); } };
+
+    /// @brief Functor for matOpsMath::sqrt().
+    struct Sqrt { double operator()(double x) const { return matOpsMath::sqrt(x); } };
+
+    /// @brief Functor for matOpsMath::tanh().
+    struct Tanh { double operator()(double x) const { return matOpsMath::tanh(x); } };
+
+    /// @brief Functor for matOpsMath::sigmoid().
+    struct Sigmoid { double operator()(double x) const { return matOpsMath::sigmoid(x); } };
+
+    /// @brief Functor for matOpsMath::erf().
+    struct Erf { double operator()(double x) const { return matOpsMath::erf(x); } };
+}
+
+/**
+ * @class Matrix
+ * @brief A simple linear algebra library for matrix operations.
+ * @version 0.6.1
+ * 
+ * This class provides basic matrix operations such as addition, subtraction,
+ * multiplication, transposition, determinant calculation, inversion, and row/column insertion.
+ *
+ * Example Usage:
+ * @code
+ * Matrix A({{1, 2}, {3, 4}});
+ * Matrix B({{5, 6}, {7, 8}});
+ * Matrix C = A + B; // Matrix addition
+ * Matrix D = A * B; // Matrix multiplication
+ * double detA = A.determinant(); // Determinant calculation
+ * @endcode
+ */
+class Matrix {
+    private:
+        std::vector<std::vector<double>> container; ///< 2D vector holding matrix elements.
+        size_t nrows; ///< Number of rows in the matrix.
+        size_t ncols; ///< Number of columns in the matrix.
+
+        /**
+         * @brief Version stamp and content hash cache, safe to read from const member functions.
+         *
+         * A mutation only clears the stamp of its own object. The next version() call
+         * then draws a fresh stamp from the process-wide counter, so element loops
+         * through the non-const operator() never touch shared state. The cached hash is
+         * valid while hashStamp equals the current stamp.
+         *
+         * Operators build their results by copying an operand and writing to the copy's
+         * container, so a copy starts with a fresh stamp and an empty cache instead of
+         * inheriting them.
+         */
+        struct Revision {
+            std::atomic<uint64_t> stamp; ///< 0 until assigned after the last mutation.
+            std::atomic<uint64_t> hash;
+            std::atomic<uint64_t> hashStamp; ///< Stamp the cached hash belongs to, 0 if none.
+
+            Revision() : stamp(0), hash(0), hashStamp(0) {}
+            Revision(const Revision&) : Revision() {}
+            Revision& operator=(const Revision&) {
+                this->invalidate();
+                return *this;
+            }
+
+            void invalidate() {
+                this->stamp.store(0, std::memory_order_relaxed);
+            }
+
+            /* Assigns a stamp if the object changed since the last call; concurrent callers agree. */
+            uint64_t current() {
+                uint64_t s = this->stamp.load();
+                if (s == 0) {
+                    const uint64_t fresh = matOpsDetail::nextVersion();
+                    s = this->stamp.compare_exchange_strong(s, fresh) ? fresh : s;
+                }
+                return s;
+            }
+        };
+
+        mutable Revision revision; ///< Version stamp and cached result of hash().
+
+        /* Called by every non-const member function that can change an element. */
+        void touch() {
+            this->revision.invalidate();
+        }
+
+        struct InternalTag {};
+
+        /* A rows x cols container filled with value, first-touched per matOpsParallel::Placement. */
+        static std::vector<std::vector<double>> allocateRows(size_t rows, size_t cols, double value = 0.0) {
+            std::vector<std::vector<double>> res(rows);
+            matOpsParallel::firstTouch(rows, rows * cols, [&](size_t i) {
+                res[i].assign(cols, value);
+            });
+            return res;
+        }
+
+        /* Copy of a container, first-touched per matOpsParallel::Placement. */
+        static std::vector<std::vector<double>> copyRows(const std::vector<std::vector<double>>& src) {
+            std::vector<std::vector<double>> res(src.size());
+            matOpsParallel::firstTouch(src.size(), src.size() * (src.empty() ? 0 : src[0].size()), [&](size_t i) {
+                res[i] = src[i];
+            });
+            return res;
+        }
+
+        friend class CSRMatrix;
+        friend class SELLMatrix;
+        template <size_t R, size_t C> friend class BSRMatrix;
+        friend class SparseCholesky;
+        friend class DiagonalMatrix;
+        friend class TridiagonalMatrix;
+        friend class BandedMatrix;
+        friend class TriangularMatrix;
+        friend class SymmetricMatrix;
+        friend class LUDecomposition;
+        friend class RunningCovariance;
+        friend class MatrixBatch;
+
+        /**
+         * @brief Internal constructor for creating a Matrix by moving a pre-validated container.
+         *
+         * This constructor is intended for internal use only. It bypasses the usual
+         * validation performed in the public constructor, assuming that the provided
+         * container is already well-formed (i.e., non-empty and with consistent row sizes).
+         * The container is moved into the new Matrix object for efficient transfer of data.
+         *
+         * @param container An rvalue reference to a 2D vector of doubles representing the matrix elements.
+         * @param tag A dummy parameter (of type InternalTag) used to differentiate this constructor from the public one.
+         * @throws std::invalid_argument if the container is empty or if it contains no columns.
+         *
+         * @note This constructor does not perform full validation. It assumes that the input container is valid.
+         */
+        Matrix(std::vector<std::vector<double>>&& container, InternalTag)
+            : container(std::move(container)), 
+              nrows(this->container.size()),
+              ncols(this->container.empty() ? 0 : this->container[0].size()) {
+
+            if (nrows == 0 || ncols == 0) {
+                throw std::invalid_argument("Matrix is empty. Expected a non-empty container.");
+            }
+            // No validation performed. Assumed well formed matrix.
+        }
+
+    public:
+        /**
+         * @brief Copy constructor. Large matrices are copied in parallel, with the rows
+         * placed per matOpsParallel::Placement rather than on the copying thread's node.
+         */
+        Matrix(const Matrix& other)
+            : container(copyRows(other.container)), nrows(other.nrows), ncols(other.ncols) {}
+
+        Matrix(Matrix&& other) = default;
+
+        /// @brief Copy assignment; copies like the copy constructor.
+        Matrix& operator=(const Matrix& other) {
+            if (this != &other) {
+                this->container = copyRows(other.container);
+                this->nrows = other.nrows;
+                this->ncols = other.ncols;
+                this->touch();
+            }
+            return *this;
+        }
+
+        Matrix& operator=(Matrix&& other) = default;
+
+    private:
+
+        /// @throws std::invalid_argument unless the two shapes are broadcast compatible.
+        void requireBroadcastable(const Matrix& other) const {
+            const bool rowsOk = this->nrows == other.nrows || this->nrows == 1 || other.nrows == 1;
+            const bool colsOk = this->ncols == other.ncols || this->ncols == 1 || other.ncols == 1;
+
+            if (!rowsOk || !colsOk) {
+                throw std::invalid_argument(
+                    "Matrix dimensions do not match: (" + 
+                    std::to_string(this->nrows) + "x" + std::to_string(this->ncols) + 
+                    ") vs (" + 
+                    std::to_string(other.nrows) + "x" + std::to_string(other.ncols) + 
+                    ")"
+                );
+            }
+        }
+
+        /**
+         * @brief Applies a binary element-wise operation with NumPy-style broadcasting.
+         *
+         * Along each axis the two sizes must either match or one of them must be 1, in
+         * which case that operand is reused along the axis. The result has the larger
+         * size on every axis, e.g. (M x N) op (1 x N), (M x N) op (M x 1), (M x 1) op (1 x N)
+         * and (M x N) op (1 x 1) are all valid. Broadcast operands are read through a zero
+         * stride, so the expanded operand is never built.
+         *
+         * @param other The right-hand operand.
+         * @param op The element-wise operation, called as op(lhs, rhs).
+         * @return A new Matrix holding op applied to every broadcast pair of elements.
+         * @throws std::invalid_argument if the shapes are not broadcast compatible.
+         */
+        template <typename Op>
+        Matrix broadcast(const Matrix& other, Op op) const {
+            this->requireBroadcastable(other);
+
+            const size_t rows = std::max(this->nrows, other.nrows);
+            const size_t cols = std::max(this->ncols, other.ncols);
+            const bool aFull = this->ncols == cols;
+            const bool bFull = other.ncols == cols;
+
+            std::vector<std::vector<double>> res = allocateRows(rows, cols);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, rows * cols);
+            matOpsParallel::parallelFor(0, rows, parallel, [&](size_t i) {
+                const double* a = this->container[this->nrows == 1 ? 0 : i].data();
+                const double* b = other.container[other.nrows == 1 ? 0 : i].data();
+                double* out = res[i].data();
+
+                // One loop per stride combination keeps every inner loop unit-stride.
+                if (aFull && bFull) {
+                    #pragma omp simd
+                    for (size_t j = 0; j < cols; ++j) {
+                        out[j] = op(a[j], b[j]);
+                    }
+                } else if (aFull) {
+                    const double bv = b[0];
+                    #pragma omp simd
+                    for (size_t j = 0; j < cols; ++j) {
+                        out[j] = op(a[j], bv);
+                    }
+                } else if (bFull) {
+                    const double av = a[0];
+                    #pragma omp simd
+                    for (size_t j = 0; j < cols; ++j) {
+                        out[j] = op(av, b[j]);
+                    }
+                } else {
+                    std::fill(out, out + cols, op(a[0], b[0]));
+                }
+            });
+
+            return Matrix(std::move(res), InternalTag{});
+        }
+
+        /**
+         * @brief Checks whether any element is exactly zero.
+         */
+        bool containsZero() const {
+            std::atomic<bool> hasZero(false);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Reduction, this->nrows * this->ncols);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                const double* a = this->container[i].data();
+                bool rowZero = false;
+
+                #pragma omp simd reduction(||:rowZero)
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    rowZero = rowZero || (a[j] == 0.0);
+                }
+
+                if (rowZero) {
+                    hasZero.store(true, std::memory_order_relaxed);
+                }
+            });
+
+            return hasZero.load();
+        }
+
+        /**
+         * @brief out[j] = in[j] ^ power for n contiguous elements.
+         *
+         * An exponent p with 2p integral and |p| <= 64 is split as |p| = k + h with k a
+         * non-negative integer and h in {0, 0.5}: x^k by binary powering (one SIMD pass
+         * over the data per bit of k, with 2 and 3 done in a single pass), a correctly
+         * rounded factor sqrt(x) if h = 0.5, then a single reciprocal if p < 0. Taking the reciprocal
+         * last keeps x^k * sqrt(x) from overflowing or underflowing on the way to a
+         * representable result such as (1e-200)^-1.5. Any other exponent calls pow().
+         *
+         * @param in The bases.
+         * @param out The results, may not alias @p in.
+         * @param scratch Workspace of n doubles.
+         * @param n Number of elements.
+         * @param power The exponent.
+         */
+        static void powKernel(const double* in, double* out, double* scratch, size_t n, double power) {
+            const double twice = 2 * power;
+
+            if (twice != std::floor(twice) || std::abs(power) > 64) {
+                for (size_t j = 0; j < n; ++j) {
+                    out[j] = std::pow(in[j], power);
+                }
+                return;
+            }
+
+            const bool half = std::fmod(twice, 2.0) != 0;
+            const double magnitude = std::abs(power);
+            unsigned k = static_cast<unsigned>(half ? magnitude - 0.5 : magnitude);
+
+            if (k == 0) {
+                std::fill(out, out + n, 1.0);
+            } else if (k == 1) {
+                std::copy(in, in + n, out);
+            } else if (k == 2) {
+                #pragma omp simd
+                for (size_t j = 0; j < n; ++j) {
+                    out[j] = in[j] * in[j];
+                }
+            } else if (k == 3) {
+                #pragma omp simd
+                for (size_t j = 0; j < n; ++j) {
+                    out[j] = in[j] * in[j] * in[j];
+                }
+            } else {
+                // scratch holds x^(2^b) while the set bits of k are multiplied into out.
+                std::copy(in, in + n, scratch);
+                bool started = false;
+
+                while (true) {
+                    if (k & 1u) {
+                        if (started) {
+                            #pragma omp simd
+                            for (size_t j = 0; j < n; ++j) {
+                                out[j] *= scratch[j];
+                            }
+                        } else {
+                            std::copy(scratch, scratch + n, out);
+                            started = true;
+                        }
+                    }
+
+                    k >>= 1;
+                    if (k == 0) {
+                        break;
+                    }
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < n; ++j) {
+                        scratch[j] *= scratch[j];
+                    }
+                }
+            }
+
+            if (half) {
+                matOpsDetail::multiplyBySqrt(out, in, n);
+            }
+
+            if (power < 0) {
+                #pragma omp simd
+                for (size_t j = 0; j < n; ++j) {
+                    out[j] = 1.0 / out[j];
+                }
+            }
+        }
+
+        /**
+         * @brief Folds n contiguous elements: op(...op(op(init, map(a[0])), map(a[1]))...).
+         *
+         * The elements are spread over 2 * MATOPS_SIMD_DOUBLES independent accumulators
+         * so the main loop vectorizes for any associative @p op; the accumulators are
+         * folded at the end.
+         */
+        template <typename Map, typename Op>
+        static double reduceSpan(const double* a, size_t n, double init, Map map, Op op) {
+            const size_t lanes = 2 * MATOPS_SIMD_DOUBLES;
+            double acc[lanes];
+            std::fill(acc, acc + lanes, init);
+
+            size_t j = 0;
+            for (; j + lanes <= n; j += lanes) {
+                #pragma omp simd
+                for (size_t l = 0; l < lanes; ++l) {
+                    acc[l] = op(acc[l], map(a[j + l]));
+                }
+            }
+
+            double res = init;
+            for (size_t l = 0; l < lanes; ++l) {
+                res = op(res, acc[l]);
+            }
+            for (; j < n; ++j) {
+                res = op(res, map(a[j]));
+            }
+
+            return res;
+        }
+
+        /**
+         * @brief Rows per block when collapsing the rows: about 4096 elements, and at
+         * most 64 blocks.
+         *
+         * The blocking depends only on the shape, never on the team size or the
+         * Reduction threshold, which only decides whether the blocks run in parallel.
+         */
+        size_t reductionBlockRows() const {
+            const size_t blockElements = 4096;
+            const size_t minRows = blockElements / std::max<size_t>(this->ncols, 1);
+            const size_t maxBlocks = 64;
+            return std::max<size_t>(1, std::max(minRows, (this->nrows + maxBlocks - 1) / maxBlocks));
+        }
+
+        /**
+         * @brief Generic reduction along an axis.
+         *
+         * Every element is passed through @p map and combined with @p op, starting from
+         * @p init (which must be the identity of @p op). Long rows are split into chunks
+         * and tall matrices into row blocks so the work parallelizes for any shape; the
+         * partial results are always combined in the same order.
+         *
+         * @return A 1 x ncols, nrows x 1 or 1 x 1 Matrix, see Axis.
+         */
+        template <typename Map, typename Op>
+        Matrix reduce(Axis axis, double init, Map map, Op op) const {
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Reduction, this->nrows * this->ncols);
+
+            if (axis == Axis::Rows) {
+                const size_t blockRows = this->reductionBlockRows();
+                const size_t nBlocks = (this->nrows + blockRows - 1) / blockRows;
+
+                std::vector<std::vector<double>> partial(nBlocks, std::vector<double>(this->ncols, init));
+
+                matOpsParallel::parallelFor(0, nBlocks, parallel && nBlocks > 1, [&](size_t b) {
+                    double* acc = partial[b].data();
+                    const size_t end = std::min(this->nrows, (b + 1) * blockRows);
+
+                    for (size_t i = b * blockRows; i < end; ++i) {
+                        const double* a = this->container[i].data();
+
+                        #pragma omp simd
+                        for (size_t j = 0; j < this->ncols; ++j) {
+                            acc[j] = op(acc[j], map(a[j]));
+                        }
+                    }
+                });
+
+                std::vector<std::vector<double>> res(1, std::vector<double>(this->ncols, init));
+                for (size_t b = 0; b < nBlocks; ++b) {
+                    const double* acc = partial[b].data();
+                    double* out = res[0].data();
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < this->ncols; ++j) {
+                        out[j] = op(out[j], acc[j]);
+                    }
+                }
+
+                return Matrix(std::move(res), InternalTag{});
+            }
+
+            const size_t chunk = 4096;
+            const size_t chunksPerRow = std::max<size_t>(1, (this->ncols + chunk - 1) / chunk);
+            const size_t nTasks = this->nrows * chunksPerRow;
+            std::vector<double> partial(nTasks);
+
+            matOpsParallel::parallelFor(0, nTasks, parallel, [&](size_t t) {
+                const size_t i = t / chunksPerRow;
+                const size_t start = (t % chunksPerRow) * chunk;
+                const size_t len = std::min(chunk, this->ncols - std::min(start, this->ncols));
+                partial[t] = reduceSpan(this->container[i].data() + start, len, init, map, op);
+            });
+
+            if (axis == Axis::All) {
+                double total = init;
+                for (size_t t = 0; t < nTasks; ++t) {
+                    total = op(total, partial[t]);
+                }
+                return Matrix::constValMatrix(1, 1, total);
+            }
+
+            std::vector<std::vector<double>> res(this->nrows, std::vector<double>(1));
+            for (size_t i = 0; i < this->nrows; ++i) {
+                double total = init;
+                for (size_t c = 0; c < chunksPerRow; ++c) {
+                    total = op(total, partial[i * chunksPerRow + c]);
+                }
+                res[i][0] = total;
+            }
+
+            return Matrix(std::move(res), InternalTag{});
+        }
+
+        /**
+         * @brief Shared implementation of argmin() and argmax().
+         *
+         * Ties resolve to the first occurrence. NaN elements are skipped unless a whole
+         * row or column is NaN, in which case its index is 0.
+         */
+        std::vector<size_t> argReduce(Axis axis, bool findMax) const {
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Reduction, this->nrows * this->ncols);
+            const double sign = findMax ? -1.0 : 1.0;
+
+            if (axis == Axis::Rows) {
+                std::vector<size_t> idx(this->ncols, 0);
+                const size_t tile = 256;
+                const size_t nTiles = (this->ncols + tile - 1) / tile;
+
+                matOpsParallel::parallelFor(0, nTiles, parallel && nTiles > 1, [&](size_t t) {
+                    const size_t start = t * tile;
+                    const size_t end = std::min(this->ncols, start + tile);
+                    std::vector<double> best(this->container[0].begin() + start, this->container[0].begin() + end);
+
+                    for (size_t i = 1; i < this->nrows; ++i) {
+                        const double* a = this->container[i].data() + start;
+
+                        for (size_t j = 0; j < end - start; ++j) {
+                            // A NaN best gives way to the first non-NaN, so leading NaNs are
+                            // skipped and an all-NaN column keeps index 0.
+                            if (sign * a[j] < sign * best[j] || (best[j] != best[j] && a[j] == a[j])) {
+                                best[j] = a[j];
+                                idx[start + j] = i;
+                            }
+                        }
+                    }
+                });
+
+                return idx;
+            }
+
+            std::vector<size_t> idx(this->nrows, 0);
+            std::vector<double> value(this->nrows);
+            const double inf = std::numeric_limits<double>::infinity();
+
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                const double* a = this->container[i].data();
+                const double v = reduceSpan(a, this->ncols, inf, [sign](double x) { return sign * x; },
+                                            [](double x, double y) { return y < x ? y : x; });
+
+                size_t j = 0;
+                while (j < this->ncols && sign * a[j] != v) {
+                    ++j;
+                }
+
+                idx[i] = j < this->ncols ? j : 0;
+                value[i] = sign * a[idx[i]];
+            });
+
+            if (axis == Axis::Columns) {
+                return idx;
+            }
+
+            size_t bestRow = 0;
+            for (size_t i = 1; i < this->nrows; ++i) {
+                if (value[i] < value[bestRow] || (value[bestRow] != value[bestRow] && value[i] == value[i])) {
+                    bestRow = i;
+                }
+            }
+
+            return std::vector<size_t>(1, bestRow * this->ncols + idx[bestRow]);
+        }
+
+        /**
+         * @brief Scales a covariance matrix to correlations: C(i, j) / sqrt(C(i, i) C(j, j)).
+         */
+        static Matrix covarianceToCorrelation(Matrix C) {
+            const size_t n = C.nrows;
+            std::vector<double> inv(n);
+            for (size_t i = 0; i < n; ++i) {
+                inv[i] = 1.0 / std::sqrt(C.container[i][i]);
+            }
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, n * n);
+            matOpsParallel::parallelFor(0, n, parallel, [&](size_t i) {
+                double* c = C.container[i].data();
+                const double si = inv[i];
+
+                #pragma omp simd
+                for (size_t j = 0; j < n; ++j) {
+                    c[j] *= si * inv[j];
+                }
+                // Exact ones on the diagonal (NaN stays NaN for constant variables).
+                c[i] = std::isfinite(si) ? 1.0 : std::numeric_limits<double>::quiet_NaN();
+            });
+
+            return C;
+        }
+
+        /**
+         * @brief Rows of the matrix packed contiguously, with their squared 2-norms.
+         */
+        struct PackedRows {
+            std::vector<double> data; ///< Row-major rows, rows * dim doubles.
+            std::vector<double> sqNorms; ///< Squared 2-norm of every row.
+            size_t rows;
+            size_t dim;
+        };
+
+        PackedRows packRows() const {
+            PackedRows p;
+            p.rows = this->nrows;
+            p.dim = this->ncols;
+            p.data.resize(this->nrows * this->ncols);
+            p.sqNorms.resize(this->nrows);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, this->nrows * this->ncols);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                const double* a = this->container[i].data();
+                double* out = &p.data[i * this->ncols];
+                double sq = 0.0;
+
+                #pragma omp simd reduction(+:sq)
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    out[j] = a[j];
+                    sq += a[j] * a[j];
+                }
+                p.sqNorms[i] = sq;
+            });
+
+            return p;
+        }
+
+        /**
+         * @brief Distances between rows [i0, i1) of X and rows [j0, j1) of Y into out
+         * (row stride ldo).
+         *
+         * Euclidean and cosine distances come from the dot products x.y, computed for
+         * the whole tile with the gemmNT() kernel, combined with the precomputed norms.
+         * Manhattan distances have no such decomposition and run a SIMD reduction over
+         * the coordinates of every pair, with the tile keeping both row sets in L1/L2.
+         */
+        static void distanceTile(const PackedRows& X, const PackedRows& Y, DistanceMetric metric,
+                                 size_t i0, size_t i1, size_t j0, size_t j1, double* out, size_t ldo) {
+            const size_t d = X.dim;
+
+            if (metric == DistanceMetric::Manhattan) {
+                for (size_t i = i0; i < i1; ++i) {
+                    const double* x = &X.data[i * d];
+                    double* o = out + (i - i0) * ldo;
+
+                    for (size_t j = j0; j < j1; ++j) {
+                        const double* y = &Y.data[j * d];
+                        double dist = 0.0;
+
+                        #pragma omp simd reduction(+:dist)
+                        for (size_t k = 0; k < d; ++k) {
+                            dist += std::abs(x[k] - y[k]);
+                        }
+                        o[j - j0] = dist;
+                    }
+                }
+                return;
+            }
+
+            for (size_t i = i0; i < i1; ++i) {
+                std::fill(out + (i - i0) * ldo, out + (i - i0) * ldo + (j1 - j0), 0.0);
+            }
+            matOpsDetail::gemmNT(i1 - i0, j1 - j0, d, 1.0, &X.data[i0 * d], d, &Y.data[j0 * d], d, out, ldo);
+
+            for (size_t i = i0; i < i1; ++i) {
+                double* o = out + (i - i0) * ldo;
+                const double xx = X.sqNorms[i];
+                const double* yy = &Y.sqNorms[j0];
+
+                if (metric == DistanceMetric::Cosine) {
+                    const double ix = xx > 0 ? 1.0 / std::sqrt(xx) : 0.0;
+
+                    for (size_t j = 0; j < j1 - j0; ++j) {
+                        const double iy = yy[j] > 0 ? 1.0 / std::sqrt(yy[j]) : 0.0;
+                        o[j] = std::min(2.0, std::max(0.0, 1.0 - o[j] * ix * iy));
+                    }
+                } else {
+                    // Rounding can push the squared distance of near-identical rows below 0.
+                    #pragma omp simd
+                    for (size_t j = 0; j < j1 - j0; ++j) {
+                        const double sq = xx + yy[j] - 2.0 * o[j];
+                        o[j] = sq > 0.0 ? sq : 0.0;
+                    }
+
+                    if (metric == DistanceMetric::Euclidean) {
+                        #pragma omp simd
+                        for (size_t j = 0; j < j1 - j0; ++j) {
+                            o[j] = matOpsMath::sqrt(o[j]);
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Whether the distance of row i of X to itself is set to exactly 0 when X
+         * is Y.
+         *
+         * The dot-product decomposition leaves rounding noise on the diagonal. Manhattan
+         * distances are exact already, and a zero row keeps its cosine distance of 1.
+         */
+        static bool pinSelfDistance(const PackedRows& X, DistanceMetric metric, size_t i) {
+            return metric != DistanceMetric::Manhattan && (metric != DistanceMetric::Cosine || X.sqNorms[i] > 0);
+        }
+
+        static void requireSameDimension(const Matrix& X, const Matrix& Y) {
+            if (X.ncols != Y.ncols) {
+                throw std::invalid_argument(
+                    "Point sets must have the same dimension. Given: " +
+                    std::to_string(X.ncols) + " and " + std::to_string(Y.ncols)
+                );
+            }
+        }
+
+        /**
+         * @brief Checks that @p mismatch(a, b) is false for every pair of corresponding
+         * elements of two matrices of the same shape.
+         *
+         * Rows are scanned in parallel (statically scheduled, so each thread reads the
+         * rows it first touched), in SIMD blocks of 1024 elements. The first mismatch
+         * raises a shared flag, after which every thread abandons its current row and
+         * skips the rest, so unequal matrices are usually rejected after a fraction of
+         * a pass.
+         */
+        template <typename Mismatch>
+        bool allPairsMatch(const Matrix& other, Mismatch mismatch) const {
+            std::atomic<bool> found(false);
+            const size_t block = 1024;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Reduction, this->nrows * this->ncols);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                if (found.load(std::memory_order_relaxed)) {
+                    return;
+                }
+
+                const double* a = this->container[i].data();
+                const double* b = other.container[i].data();
+
+                for (size_t j0 = 0; j0 < this->ncols; j0 += block) {
+                    const size_t j1 = std::min(this->ncols, j0 + block);
+                    int bad = 0;
+
+                    #pragma omp simd reduction(+:bad)
+                    for (size_t j = j0; j < j1; ++j) {
+                        bad += mismatch(a[j], b[j]) ? 1 : 0;
+                    }
+
+                    if (bad != 0) {
+                        found.store(true, std::memory_order_relaxed);
+                        break;
+                    }
+                    if (found.load(std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+            }, matOpsParallel::Schedule::Static);
+
+            return !found.load();
+        }
+
+    public:
+        /**
+         * @brief Returns the dimensions of the matrix.
+         *
+         * @return A std::pair where first is the number of rows and second is the number of columns.
+         */
+        std::pair<size_t, size_t> shape() const { return {nrows, ncols}; }
+
+
+        /**
+         * @brief Constructs a Matrix from a given 2D vector container.
+         *
+         * @param container A 2D vector of doubles representing the matrix.
+         * @throws std::invalid_argument if the container is empty or row sizes are inconsistent.
+         * @note The shape is determined by the size of the container.
+         */
+        Matrix(const std::vector<std::vector<double>>& container) {
+            this->nrows = container.size();
+
+            if ( this->nrows == 0 ) {
+                throw std::invalid_argument("Matrix is empty. Expected `const std::vector<std::vector<double>>& container`");
+            } else {
+                this->ncols = container[0].size();
+            }
+
+            for (const auto& row : container) {
+                if (row.size() != ncols) {
+                    throw std::invalid_argument("Inconsistent row sizes in matrix");
+                }
+            }
+
+            this->container = copyRows(container);
+        }
+
+        /**
+         * @brief Constructs an Identity Matrix of specified dimensions.
+         * @code
+         * Matrix A = Matrix::identity(3);
+         * A = [
+         *      [1, 0, 0]
+         *      [0, 1, 0]
+         *      [0, 0, 1]
+         * ]
+         * @endcode
+         * @param dim Dimensions of matrix (dim x dim).
+         */
+        static Matrix identity(size_t dim) {
+            std::vector<std::vector<double>> I = allocateRows(dim, dim);
+
+            for (size_t i = 0; i < dim; ++i) {
+                I[i][i] = 1.0;
+            }
+
+            return Matrix(std::move(I), InternalTag{});
+        }
+
+        /**
+         * @brief Creates a matrix with constant values.
+         *
+         * Function constructs and returns a Matrix object with the specified
+         * dimensions, initializing every element to the given constant value.
+         * 
+         * Example usage:
+         * @code
+         * // Create a 3x3 matrix filled with 5.0
+         * Matrix A = Matrix::constValMatrix(3, 3, 5.0);
+         *
+         * // Expected Output:
+         * //  5.0  5.0  5.0
+         * //  5.0  5.0  5.0
+         * //  5.0  5.0  5.0
+         * @endcode
+         *
+         * @param rows The number of rows in the matrix.
+         * @param cols The number of columns in the matrix.
+         * @param val The constant value to initialize each element of the matrix.
+         * @return A Matrix object of dimensions (rows x cols) where each element is set to @p val.
+         * @throws std::invalid_argument if either @p rows or @p cols is zero.
+         */
+        static Matrix constValMatrix(size_t rows, size_t cols, double val) {
+            if (rows == 0 || cols == 0) {
+                throw std::invalid_argument("Matrix cannot have zero dimensions");
+            }
+            
+            return Matrix(allocateRows(rows, cols, val), InternalTag{});
+        }
+
+        /**
+         * @brief Returns a copy of the matrix data.
+         *
+         * This function returns a new 2D vector containing the matrix elements.
+         * Modifications to the returned vector do not affect the original matrix.
+         *
+         * @return A copy of the 2D vector representing the matrix.
+         */
+        std::vector<std::vector<double>> toVector() const {
+            return this->container;
+        }
+
+        /**
+         * @brief Adds two matrices element-wise, with broadcasting.
+         *
+         * Shapes follow NumPy broadcasting rules: each dimension must match or be 1 in one
+         * of the operands. For example, subtracting the (1 x N) column means from an (M x N)
+         * data matrix needs no repeated copy of the means.
+         *
+         * @code
+         * Matrix A({{1, 2}, {3, 4}});
+         * Matrix r({{10, 20}});
+         * Matrix B = A + r; // [[11, 22], [13, 24]]
+         * @endcode
+         *
+         * @param other The Matrix to add.
+         * @return A new Matrix representing the element-wise sum.
+         * @throws std::invalid_argument if the dimensions of the two matrices are not broadcast compatible.
+         * @note The shape of the result is the broadcast shape of both operands.
+         */
+        Matrix operator+(const Matrix& other) const {
+            return this->broadcast(other, [](double a, double b) { return a + b; });
+        }
+
+        /**
+         * @brief Adds a scalar value to each element of the matrix. (MATRIX + K)
+         *
+         * @param scalar A double value to add.
+         * @return A new Matrix with the scalar added to each element.
+         * @note The shape remains unchanged.
+         */
+        Matrix operator+(double scalar) const {
+            Matrix addRes = *this;
+            
+            const size_t totalElements = this->ncols * this->nrows;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, totalElements);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    addRes.container[i][j] += scalar;
+                }
+            });
+
+            return addRes;
+        }
+
+        /**
+         * @brief Adds a scalar to each element of a matrix. (K + MATRIX)
+         *
+         * @param scalar The scalar value.
+         * @param other The Matrix to add the scalar to.
+         * @return A new Matrix with the result.
+         * @note The shape remains unchanged.
+         */
+        friend Matrix operator+(double scalar, const Matrix& other) {
+            return other + scalar;
+        }
+
+        /**
+         * @brief Subtracts one matrix from another element-wise, with broadcasting.
+         *
+         * Shapes follow the same broadcasting rules as operator+(const Matrix&).
+         *
+         * @param other The Matrix to subtract.
+         * @return A new Matrix representing the element-wise difference.
+         * @throws std::invalid_argument if the dimensions of the two matrices are not broadcast compatible.
+         * @note The shape of the result is the broadcast shape of both operands.
+         */
+        Matrix operator-(const Matrix& other) const {
+            return this->broadcast(other, [](double a, double b) { return a - b; });
+        }
+
+        /**
+         * @brief Subtracts a scalar from each element of the matrix. (MATRIX - K)
+         *
+         * @param scalar The scalar value to subtract.
+         * @return A new Matrix with each element reduced by the scalar.
+         * @note The shape remains unchanged.
+         */
+        Matrix operator-(double scalar) const {
+            Matrix subRes = *this; // subRes = A in A - B
+
+            const size_t totalElements = this->ncols * this->nrows;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, totalElements);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    subRes.container[i][j] -= scalar;
+                }
+            });
+
+            return subRes;
+        }
+        
+        /**
+         * @brief Subtracts each element of the matrix from a scalar. (K - MATRIX)
+         *
+         * @param scalar The scalar value.
+         * @param other The Matrix whose elements are subtracted from the scalar.
+         * @return A new Matrix with the result.
+         * @note The shape remains unchanged.
+         */
+        friend Matrix operator-(double scalar, const Matrix& other) {
+            Matrix subRes = other;
+
+            const size_t totalElements = other.ncols * other.nrows;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, totalElements);
+            matOpsParallel::parallelFor(0, subRes.nrows, parallel, [&](size_t i) {
+                for (size_t j = 0; j < subRes.ncols; ++j) {
+                    subRes.container[i][j] = scalar - subRes.container[i][j];
+                }
+            });
+
+            return subRes;
+        }
+
+        /**
+         * @brief Compares two matrices for equality.
+         *
+         * @param other The Matrix to compare with.
+         * @return True if the matrices are equal (within a tolerance), false otherwise.
+         */
+        bool operator==(const Matrix& other) const {
+            if (this->nrows != other.nrows || this->ncols != other.ncols) {
+                return false;
+            }
+
+            return this->allPairsMatch(other, [](double a, double b) { return std::abs(a - b) > EPS; });
+        }
+
+        /**
+         * @brief Whether two matrices are element-wise equal within a tolerance.
+         *
+         * Elements a and b are close when |a - b| <= atol + rtol * |b| (the NumPy
+         * definition, so the test is not symmetric in @p A and @p B) or when they are
+         * equal, which covers infinities of the same sign; an infinity is not close to
+         * anything else, and NaN is never close. Unlike operator==, the relative term
+         * makes the test meaningful for large values.
+         *
+         * The scan is parallel and SIMD, and stops at the first mismatch.
+         *
+         * @param A The matrix being tested.
+         * @param B The reference matrix.
+         * @param rtol Relative tolerance.
+         * @param atol Absolute tolerance.
+         * @return true if the shapes match and every pair of elements is close.
+         */
+        static bool allclose(const Matrix& A, const Matrix& B, double rtol = 1e-5, double atol = 1e-8) {
+            if (A.nrows != B.nrows || A.ncols != B.ncols) {
+                return false;
+            }
+
+            return A.allPairsMatch(B, [rtol, atol](double a, double b) {
+                const double diff = std::abs(a - b);
+                return !(a == b || (diff <= atol + rtol * std::abs(b) && diff < std::numeric_limits<double>::infinity()));
+            });
+        }
+
+        /**
+         * @brief Element-wise version of allclose(), with broadcasting.
+         *
+         * @param A The matrix being tested.
+         * @param B The reference matrix; shapes follow the rules of operator+(const Matrix&).
+         * @param rtol Relative tolerance.
+         * @param atol Absolute tolerance.
+         * @return A mask with 1.0 where the elements are close and 0.0 elsewhere.
+         * @throws std::invalid_argument if the shapes are not broadcast compatible.
+         */
+        static Matrix isclose(const Matrix& A, const Matrix& B, double rtol = 1e-5, double atol = 1e-8) {
+            return A.broadcast(B, [rtol, atol](double a, double b) {
+                const double diff = std::abs(a - b);
+                return (a == b || (diff <= atol + rtol * std::abs(b) && diff < std::numeric_limits<double>::infinity())) ? 1.0 : 0.0;
+            });
+        }
+
+        /**
+         * @brief Whether two matrices are element-wise equal to within @p maxUlps units
+         * in the last place.
+         *
+         * The ULP distance counts the representable doubles between two values, so it is
+         * a scale-independent relative tolerance (1 ULP is about 2.2e-16 relative). +0 and
+         * -0 are 0 ULP apart; NaN is never close. Parallel, SIMD, with early exit.
+         *
+         * @param A First matrix.
+         * @param B Second matrix.
+         * @param maxUlps Largest accepted distance.
+         * @return true if the shapes match and every pair is within @p maxUlps.
+         */
+        static bool ulpClose(const Matrix& A, const Matrix& B, uint64_t maxUlps = 4) {
+            if (A.nrows != B.nrows || A.ncols != B.ncols) {
+                return false;
+            }
+
+            return A.allPairsMatch(B, [maxUlps](double a, double b) {
+                return matOpsDetail::ulpDistance(a, b) > maxUlps;
+            });
+        }
+
+        /**
+         * @brief Compares two matrices for inequality.
+         *
+         * This operator checks if two matrices are not equal by comparing their dimensions and
+         * individual elements. Two matrices are considered not equal if:
+         *  - Their dimensions differ, or
+         *  - At least one pair of corresponding elements differs by more than EPS.
+         *
+         * @param other The matrix to compare with.
+         * @return true if the matrices differ by at least one element more than EPS; false otherwise.
+         */
+        bool operator!=(const Matrix& other) const {
+            return !(*this == other);
+        }
+
+        /**
+         * @brief Multiplies two matrices.
+         *
+         * Runs a cache-blocked kernel whose panel sizes are taken from matOpsGemm for
+         * the shape class of the product (see matOpsGemm::plan() to tune them).
+         *
+         * @param other The Matrix to multiply with.
+         * @return A new Matrix resulting from matrix multiplication.
+         * @throws std::invalid_argument if the number of columns of the first matrix
+         *         does not match the number of rows of the second.
+         * @note The shape of the result is (nrows of first, ncols of second).
+         */
+        Matrix operator*(const Matrix& other) const {
+            if (this->ncols != other.nrows) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: For matrices (m x n) and (p x r), n must be equal to p. "
+                    "Given: (" + std::to_string(this->nrows) + "x" + std::to_string(this->ncols) + 
+                    ") and (" + std::to_string(other.nrows) + "x" + std::to_string(other.ncols) + ")."
+                );
+            }
+
+            std::vector<std::vector<double>> mulResContainer = allocateRows(this->nrows, other.ncols);
+
+            std::vector<const double*> a(this->nrows), b(other.nrows);
+            std::vector<double*> c(this->nrows);
+            for (size_t i = 0; i < this->nrows; ++i) {
+                a[i] = this->container[i].data();
+                c[i] = mulResContainer[i].data();
+            }
+            for (size_t k = 0; k < other.nrows; ++k) {
+                b[k] = other.container[k].data();
+            }
+
+            const matOpsGemm::Blocking blocking =
+                matOpsGemm::getBlocking(matOpsGemm::classify(this->nrows, this->ncols, other.ncols));
+            matOpsDetail::gemmNN(this->nrows, other.ncols, this->ncols, a.data(), b.data(), c.data(), blocking);
+
+            return Matrix(std::move(mulResContainer), InternalTag{});
+        }
+
+        /**
+         * @brief Multiplies each element of the matrix by a scalar. (MATRIX * K)
+         *
+         * @param scalar The scalar value.
+         * @return A new Matrix with each element multiplied by the scalar.
+         * @note The shape remains unchanged.
+         */
+        Matrix operator*(double scalar) const {
+            Matrix mulRes = *this;
+            const size_t totalElements = this->ncols * this->nrows;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, totalElements);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    mulRes.container[i][j] *= scalar;
+                }
+            });
+
+            return mulRes;
+        }
+
+        /**
+         * @brief Multiplies a scalar by a matrix. (K * MATRIX)
+         *
+         * @param scalar The scalar value.
+         * @param other The Matrix to multiply.
+         * @return A new Matrix with each element multiplied by the scalar.
+         * @note The shape remains unchanged.
+         */
+        friend Matrix operator*(double scalar, const Matrix& other) {
+            return other * scalar;
+        }
+
+        /**
+         * @brief Divides each element of the matrix by a scalar.
+         *
+         * @param scalar The scalar value.
+         * @return A new Matrix with each element divided by the scalar.
+         * @throws std::runtime_error if scalar is zero.
+         * @note The shape remains unchanged.
+         */
+        Matrix operator/(double scalar) const {
+            if (scalar == 0) {
+                throw std::runtime_error("Division by Zero");
+            }
+
+            Matrix devRes = *this;
+            return devRes * (1 / scalar);
+        }
+
+        /**
+         * @brief Element-wise (Hadamard) product, with broadcasting.
+         *
+         * Shapes follow the same broadcasting rules as operator+(const Matrix&).
+         *
+         * @code
+         * Matrix A({{1, 2}, {3, 4}});
+         * Matrix B({{5, 6}, {7, 8}});
+         * Matrix C = A.hadamard(B); // [[5, 12], [21, 32]]
+         * @endcode
+         *
+         * @param other The Matrix to multiply element-wise.
+         * @return A new Matrix holding the element-wise products.
+         * @throws std::invalid_argument if the dimensions are not broadcast compatible.
+         */
+        Matrix hadamard(const Matrix& other) const {
+            return this->broadcast(other, [](double a, double b) { return a * b; });
+        }
+
+        /**
+         * @brief Element-wise division, with broadcasting.
+         *
+         * Shapes follow the same broadcasting rules as operator+(const Matrix&).
+         *
+         * @param other The Matrix of divisors.
+         * @return A new Matrix holding the element-wise quotients.
+         * @throws std::invalid_argument if the dimensions are not broadcast compatible.
+         * @throws std::runtime_error if any element of @p other is zero.
+         */
+        Matrix divide(const Matrix& other) const {
+            this->requireBroadcastable(other);
+
+            if (other.containsZero()) {
+                throw std::runtime_error("Division by Zero");
+            }
+
+            return this->broadcast(other, [](double a, double b) { return a / b; });
+        }
+
+        /**
+         * @brief Fused element-wise multiply-add: A .* B + C.
+         *
+         * The product and the sum are computed in a single pass over the three operands,
+         * without the intermediate matrix that A.hadamard(B) + C would allocate.
+         *
+         * @param A First factor.
+         * @param B Second factor, same shape as @p A.
+         * @param C Addend, same shape as @p A.
+         * @return A new Matrix with elements A(i, j) * B(i, j) + C(i, j).
+         * @throws std::invalid_argument if the three shapes are not identical.
+         */
+        static Matrix fma(const Matrix& A, const Matrix& B, const Matrix& C) {
+            if (A.nrows != B.nrows || A.ncols != B.ncols || A.nrows != C.nrows || A.ncols != C.ncols) {
+                throw std::invalid_argument(
+                    "Matrix dimensions do not match: (" +
+                    std::to_string(A.nrows) + "x" + std::to_string(A.ncols) + ") vs (" +
+                    std::to_string(B.nrows) + "x" + std::to_string(B.ncols) + ") vs (" +
+                    std::to_string(C.nrows) + "x" + std::to_string(C.ncols) + ")"
+                );
+            }
+
+            std::vector<std::vector<double>> res = allocateRows(A.nrows, A.ncols);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, A.nrows * A.ncols);
+            matOpsParallel::parallelFor(0, A.nrows, parallel, [&](size_t i) {
+                const double* a = A.container[i].data();
+                const double* b = B.container[i].data();
+                const double* c = C.container[i].data();
+                double* out = res[i].data();
+
+                #pragma omp simd
+                for (size_t j = 0; j < A.ncols; ++j) {
+                    out[j] = a[j] * b[j] + c[j];
+                }
+            });
+
+            return Matrix(std::move(res), InternalTag{});
+        }
+
+        /**
+         * @brief Applies a unary function to every element.
+         *
+         * Rows are split across threads and each row runs as a SIMD loop, so a function
+         * from matOpsMath (or any branch-free lambda) is evaluated a register at a time.
+         *
+         * @code
+         * Matrix Y = X.apply(matOpsMath::Tanh());
+         * Matrix Z = X.apply([](double x) { return x > 0 ? x : 0.0; });
+         * @endcode
+         *
+         * @param f The function, called as f(double) and returning a double.
+         * @return A new Matrix with elements f(A(i, j)).
+         */
+        template <typename F>
+        Matrix apply(F f) const {
+            std::vector<std::vector<double>> res = allocateRows(this->nrows, this->ncols);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, this->nrows * this->ncols);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                const double* a = this->container[i].data();
+                double* out = res[i].data();
+
+                #pragma omp simd
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    out[j] = f(a[j]);
+                }
+            });
+
+            return Matrix(std::move(res), InternalTag{});
+        }
+
+        /**
+         * @brief In-place version of apply(): replaces every element by f(element).
+         *
+         * @param f The function, called as f(double) and returning a double.
+         */
+        template <typename F>
+        void applyInPlace(F f) {
+            this->touch();
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, this->nrows * this->ncols);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                double* a = this->container[i].data();
+
+                #pragma omp simd
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    a[j] = f(a[j]);
+                }
+            });
+        }
+
+        /**
+         * @brief Applies a binary function to every pair of elements, with broadcasting.
+         *
+         * Shapes follow the same broadcasting rules as operator+(const Matrix&).
+         *
+         * @code
+         * Matrix H = Matrix::zip(X, Y, [](double x, double y) { return std::max(x, y); });
+         * @endcode
+         *
+         * @param A The left operand.
+         * @param B The right operand.
+         * @param f The function, called as f(A(i, j), B(i, j)) and returning a double.
+         * @return A new Matrix holding f applied to every broadcast pair of elements.
+         * @throws std::invalid_argument if the shapes are not broadcast compatible.
+         */
+        template <typename F>
+        static Matrix zip(const Matrix& A, const Matrix& B, F f) {
+            return A.broadcast(B, f);
+        }
+
+        /**
+         * @brief In-place version of zip(): A(i, j) = f(A(i, j), B(i, j)).
+         *
+         * @p other is broadcast to the shape of this matrix, so it may be a single row,
+         * a single column or a 1 x 1 matrix; this matrix never changes shape.
+         *
+         * @param other The right operand.
+         * @param f The function, called as f(A(i, j), B(i, j)) and returning a double.
+         * @throws std::invalid_argument if @p other cannot be broadcast to this shape.
+         */
+        template <typename F>
+        void zipInPlace(const Matrix& other, F f) {
+            const bool rowsOk = other.nrows == this->nrows || other.nrows == 1;
+            const bool colsOk = other.ncols == this->ncols || other.ncols == 1;
+
+            if (!rowsOk || !colsOk) {
+                throw std::invalid_argument(
+                    "Matrix dimensions do not match: (" +
+                    std::to_string(this->nrows) + "x" + std::to_string(this->ncols) +
+                    ") vs (" +
+                    std::to_string(other.nrows) + "x" + std::to_string(other.ncols) +
+                    ")"
+                );
+            }
+
+            const bool bFull = other.ncols == this->ncols;
+            this->touch();
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, this->nrows * this->ncols);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                double* a = this->container[i].data();
+                const double* b = other.container[other.nrows == 1 ? 0 : i].data();
+
+                if (bFull) {
+                    #pragma omp simd
+                    for (size_t j = 0; j < this->ncols; ++j) {
+                        a[j] = f(a[j], b[j]);
+                    }
+                } else {
+                    const double bv = b[0];
+                    #pragma omp simd
+                    for (size_t j = 0; j < this->ncols; ++j) {
+                        a[j] = f(a[j], bv);
+                    }
+                }
+            });
+        }
+
+        /**
+         * @brief Raises every element to the power @p scalar.
+         *
+         * Integer and half-integer exponents up to 64 in magnitude (2, 3, 0.5, -1, ...)
+         * are computed with vectorized multiplications, a reciprocal and a square root
+         * instead of calling pow() per element; other exponents fall back to pow().
+         * Rows are split across threads in both cases.
+         *
+         * @param scalar The exponent.
+         * @return A new Matrix with elements A(i, j) ^ scalar.
+         * @throws std::runtime_error if any element is zero and @p scalar is less than or equal to zero.
+         */
+        Matrix operator^(double scalar) const {
+
+            if (scalar == 1) {
+                return *this;
+            }
+
+            if (scalar <= 0 && this->containsZero()) {
+                throw std::runtime_error("Division by zero occured. (0 ^ ( <=0 ))");
+            }
+
+            std::vector<std::vector<double>> res = allocateRows(this->nrows, this->ncols);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Elementwise, this->nrows * this->ncols);
+            matOpsParallel::parallelForRange(0, this->nrows, parallel, [&](size_t lo, size_t hi) {
+                std::vector<double> scratch(this->ncols);
+
+                for (size_t i = lo; i < hi; ++i) {
+                    powKernel(this->container[i].data(), res[i].data(), scratch.data(), this->ncols, scalar);
+                }
+            });
+
+            return Matrix(std::move(res), InternalTag{});
+        }
+
+        /**
+         * @brief Accesses an element of the matrix at a specified row and column.
+         *
+         * Marks the matrix as modified, as the returned reference is assumed to be
+         * written through: the next version() or hash() call sees a new stamp. Marking is
+         * a store to this object only. Writes made through a reference kept from an
+         * earlier call are not tracked. Read through a const Matrix& to keep the stamp.
+         *
+         * @param row The row index.
+         * @param col The column index.
+         * @return Reference to the value at the specified position. (modifiable)
+         * @throws std::out_of_range if the indices are out of bounds.
+         */
+        double& operator()(size_t row, size_t col) {
+            if (row >= this->nrows || col >= this->ncols) {
+                throw std::out_of_range("Index out of bounds");
+            }
+
+            this->touch();
+            return this->container[row][col];
+        }
+
+        /**
+         * @brief Reads an element of the matrix at a specified row and column.
+         *
+         * @param row The row index.
+         * @param col The column index.
+         * @return The value at the specified position.
+         * @throws std::out_of_range if the indices are out of bounds.
+         */
+        double operator()(size_t row, size_t col) const {
+            if (row >= this->nrows || col >= this->ncols) {
+                throw std::out_of_range("Index out of bounds");
+            }
+
+            return this->container[row][col];
+        }
+
+        /**
+         * @brief Returns the version stamp of the matrix in O(1).
+         *
+         * Stamps are unique across the process and renewed after every mutating member
+         * function (the non-const operator(), applyInPlace, zipInPlace, shuffleRows),
+         * and copies get a stamp of their own. A new stamp is drawn on the first call
+         * after a mutation, not by the mutation itself. An unchanged stamp therefore means
+         * unchanged contents, which makes it a cheap cache key for memoized results.
+         *
+         * @return The current version stamp.
+         */
+        uint64_t version() const {
+            return this->revision.current();
+        }
+
+        /**
+         * @brief Computes a 64-bit content hash of the matrix (xxHash64 based).
+         *
+         * Each row is hashed in chunks of 4096 elements in parallel, and the chunk hashes
+         * are combined in order together with the shape, so the result does not depend on
+         * the thread count and matrices of different shapes with the same elements hash
+         * differently. The value is cached until the next mutation, making repeated calls O(1).
+         *
+         * Elements are hashed by their bit patterns: 0.0 and -0.0 hash differently, and
+         * NaNs only match with identical payloads. Use hash() to detect identical matrices
+         * (memoization, deduplication), not approximately equal ones.
+         *
+         * @return The content hash.
+         */
+        uint64_t hash() const {
+            const uint64_t stamp = this->revision.current();
+            if (this->revision.hashStamp.load() == stamp) {
+                return this->revision.hash.load();
+            }
+
+            const size_t chunk = 4096;
+            const size_t chunksPerRow = (this->ncols + chunk - 1) / chunk;
+            const size_t tasks = this->nrows * chunksPerRow;
+            std::vector<uint64_t> partial(tasks);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Reduction, this->nrows * this->ncols);
+            matOpsParallel::parallelFor(0, tasks, parallel, [&](size_t t) {
+                const size_t i = t / chunksPerRow;
+                const size_t j0 = (t % chunksPerRow) * chunk;
+                const size_t len = std::min(chunk, this->ncols - j0);
+                partial[t] = matOpsDetail::xxHash64(this->container[i].data() + j0, len, 0);
+            });
+
+            const uint64_t shape[2] = { this->nrows, this->ncols };
+            const uint64_t seed = matOpsDetail::xxHash64(shape, 2, 0);
+            const uint64_t result = matOpsDetail::xxHash64(partial.data(), tasks, seed);
+
+            this->revision.hash.store(result);
+            this->revision.hashStamp.store(stamp);
+            return result;
+        }
+
+        /**
+         * @brief Transposes the matrix.
+         * @return A new matrix of dim (mxn) for a calling matrix of dim (nxm)
+         * Example:
+         * @code
+         * Matrix A({{1, 2}, {3, 4}});
+         * A = A.transpose();
+         * // A becomes:
+         * // [
+         * //   [1, 3],
+         * //   [2, 4]
+         * // ]
+         * @endcode
+         */
+        Matrix transpose() const {
+
+            std::vector<std::vector<double>> transposeContainer = allocateRows(this->ncols, this->nrows);
+
+            const size_t totalElements = this->ncols * this->nrows;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Transpose, totalElements);
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    transposeContainer[j][i] = this->container[i][j];
+                }
+            });
+
+            return Matrix(std::move(transposeContainer), InternalTag{});
+        }
+
+        /**
+         * @brief Computes a matrix norm.
+         *
+         * Each norm is a single parallel SIMD pass over the matrix (two for the
+         * Frobenius norm when the sum of squares over- or underflows and the entries
+         * have to be rescaled).
+         *
+         * @code
+         * Matrix A({{1, -2}, {3, 4}});
+         * A.norm(Norm::One);       // 6
+         * A.norm(Norm::Infinity);  // 7
+         * A.norm(Norm::Max);       // 4
+         * A.norm();                // sqrt(30)
+         * @endcode
+         *
+         * @param type Which norm, see Norm.
+         * @return The norm (0 for an empty matrix).
+         */
+        double norm(Norm type = Norm::Frobenius) const {
+            auto absVal = [](double x) { return std::abs(x); };
+            auto add    = [](double x, double y) { return x + y; };
+            auto maxOf  = [](double x, double y) { return y > x ? y : x; };
+
+            switch (type) {
+                case Norm::One:
+                    return this->reduce(Axis::Rows, 0.0, absVal, add).reduce(Axis::All, 0.0, absVal, maxOf).container[0][0];
+                case Norm::Infinity:
+                    return this->reduce(Axis::Columns, 0.0, absVal, add).reduce(Axis::All, 0.0, absVal, maxOf).container[0][0];
+                case Norm::Max:
+                    return this->reduce(Axis::All, 0.0, absVal, maxOf).container[0][0];
+                default:
+                    break;
+            }
+
+            const double squares = this->reduce(Axis::All, 0.0, [](double x) { return x * x; }, add).container[0][0];
+            if (squares > 1e-290 && squares < 1e290) {
+                return std::sqrt(squares);
+            }
+
+            // Rescale by the largest entry so that the squares neither overflow nor underflow.
+            const double scale = this->norm(Norm::Max);
+            if (scale == 0.0 || std::isinf(scale)) {
+                return scale;
+            }
+
+            const double scaled = this->reduce(Axis::All, 0.0, [scale](double x) { return (x / scale) * (x / scale); }, add).container[0][0];
+            return scale * std::sqrt(scaled);
+        }
+
+        /**
+         * @brief Estimates the 2-norm (largest singular value) by power iteration.
+         *
+         * Iterates v <- A^T A v / ||A^T A v|| from a fixed pseudo-random start and returns
+         * ||A v||, a lower bound that converges to the 2-norm. Each iteration is two
+         * parallel passes over the matrix.
+         *
+         * @param maxIterations Upper bound on the number of iterations.
+         * @param tolerance Stop when the estimate changes by less than this (relative).
+         * @return The estimate of ||A||_2 (0 for an empty or zero matrix).
+         */
+        double norm2Estimate(size_t maxIterations = 100, double tolerance = 1e-10) const {
+            if (this->nrows == 0 || this->ncols == 0) {
+                return 0.0;
+            }
+
+            std::mt19937 gen(42);
+            std::uniform_real_distribution<double> dist(0.5, 1.5);
+
+            std::vector<double> v(this->ncols), w(this->nrows), z(this->ncols);
+            for (double& x : v) {
+                x = dist(gen);
+            }
+
+            const size_t tile = 256;
+            const size_t nTiles = (this->ncols + tile - 1) / tile;
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Multiply, this->nrows * this->ncols);
+            double estimate = 0.0;
+
+            for (size_t it = 0; it < maxIterations; ++it) {
+                const double vNorm = std::sqrt(std::inner_product(v.begin(), v.end(), v.begin(), 0.0));
+                if (vNorm == 0.0) {
+                    return 0.0;
+                }
+                for (double& x : v) {
+                    x /= vNorm;
+                }
+
+                // w = A v
+                matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                    const double* a = this->container[i].data();
+                    double dot = 0.0;
+
+                    #pragma omp simd reduction(+:dot)
+                    for (size_t j = 0; j < this->ncols; ++j) {
+                        dot += a[j] * v[j];
+                    }
+                    w[i] = dot;
+                });
+
+                const double previous = estimate;
+                estimate = std::sqrt(std::inner_product(w.begin(), w.end(), w.begin(), 0.0));
+                if (it > 0 && std::abs(estimate - previous) <= tolerance * estimate) {
+                    break;
+                }
+
+                // z = A^T w, one column tile per task so no reduction is needed.
+                matOpsParallel::parallelFor(0, nTiles, parallel, [&](size_t t) {
+                    const size_t j0 = t * tile;
+                    const size_t j1 = std::min(this->ncols, j0 + tile);
+                    std::fill(z.begin() + j0, z.begin() + j1, 0.0);
+
+                    for (size_t i = 0; i < this->nrows; ++i) {
+                        const double* a = this->container[i].data();
+                        const double wi = w[i];
+
+                        #pragma omp simd
+                        for (size_t j = j0; j < j1; ++j) {
+                            z[j] += wi * a[j];
+                        }
+                    }
+                });
+
+                v.swap(z);
+            }
+
+            return estimate;
+        }
+
+        /**
+         * @brief Estimates the 1-norm condition number ||A||_1 ||A^-1||_1.
+         *
+         * Factorizes the matrix once and runs the Hager/Higham estimator, which needs
+         * only a handful of triangular solves instead of the inverse. To reuse an
+         * existing factorization call LUDecomposition::conditionEstimate() directly.
+         *
+         * @return The estimate (a lower bound, usually within a factor of 3), or
+         *         infinity if the matrix is singular.
+         * @throws std::invalid_argument if the matrix is not square.
+         */
+        double conditionEstimate() const;
+
+        /**
+         * @brief Covariance matrix of the columns, with observations in rows.
+         *
+         * The column means are one parallel reduction; the centered Gram matrix is then
+         * built by SymmetricMatrix::syrk(), which subtracts the means on the fly and
+         * computes only the lower triangle, so neither a centered copy nor a transpose
+         * is made.
+         *
+         * @code
+         * Matrix X = ...;           // m observations x n variables
+         * Matrix C = X.cov();       // n x n, sample covariance
+         * Matrix P = X.cov(0);      // population covariance
+         * @endcode
+         *
+         * @param ddof Delta degrees of freedom: the divisor is m - ddof.
+         * @return The (n x n) covariance matrix.
+         * @throws std::invalid_argument if there are not more than @p ddof observations.
+         */
+        Matrix cov(size_t ddof = 1) const;
+
+        /**
+         * @brief Correlation matrix of the columns, with observations in rows.
+         *
+         * @return The (n x n) matrix of Pearson correlation coefficients (NaN in the
+         *         rows and columns of constant variables).
+         * @throws std::invalid_argument if there are fewer than two observations.
+         */
+        Matrix corr() const;
+
+        /**
+         * @brief Distances between every row of @p X and every row of @p Y.
+         *
+         * For Euclidean and cosine distances all dot products are computed as one
+         * GEMM-style product, using ||x - y||^2 = ||x||^2 + ||y||^2 - 2 x.y. This is much
+         * faster than a loop over pairs but loses relative accuracy for points much
+         * closer to each other than to the origin; the diagonal is exactly zero when
+         * @p X and @p Y are the same object. Manhattan distances use a tiled SIMD kernel.
+         *
+         * @code
+         * Matrix D = Matrix::pairwiseDistances(points, centroids);          // Euclidean
+         * Matrix S = Matrix::pairwiseDistances(docs, docs, DistanceMetric::Cosine);
+         * @endcode
+         *
+         * @param X (m x d) points, one per row.
+         * @param Y (n x d) points, one per row.
+         * @param metric The distance function, see DistanceMetric.
+         * @return The (m x n) matrix of distances D(i, j) = dist(X row i, Y row j).
+         * @throws std::invalid_argument if the points have different dimensions.
+         */
+        static Matrix pairwiseDistances(const Matrix& X, const Matrix& Y,
+                                        DistanceMetric metric = DistanceMetric::Euclidean) {
+            requireSameDimension(X, Y);
+
+            const PackedRows px = X.packRows();
+            PackedRows packedY;
+            if (&X != &Y) {
+                packedY = Y.packRows();
+            }
+            const PackedRows& py = (&X == &Y) ? px : packedY;
+            const size_t rowTile = 64, colTile = 256;
+            const size_t rowTiles = (X.nrows + rowTile - 1) / rowTile;
+            const size_t colTiles = (Y.nrows + colTile - 1) / colTile;
+
+            std::vector<std::vector<double>> res = allocateRows(X.nrows, Y.nrows);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Multiply, X.nrows * Y.nrows * X.ncols);
+            matOpsParallel::parallelFor(0, rowTiles * colTiles, parallel, [&](size_t t) {
+                const size_t i0 = (t / colTiles) * rowTile, i1 = std::min(X.nrows, i0 + rowTile);
+                const size_t j0 = (t % colTiles) * colTile, j1 = std::min(Y.nrows, j0 + colTile);
+                std::vector<double> buffer((i1 - i0) * (j1 - j0));
+
+                distanceTile(px, py, metric, i0, i1, j0, j1, buffer.data(), j1 - j0);
+                for (size_t i = i0; i < i1; ++i) {
+                    std::copy(&buffer[(i - i0) * (j1 - j0)], &buffer[(i - i0) * (j1 - j0)] + (j1 - j0), &res[i][j0]);
+                }
+            }, matOpsParallel::Schedule::Static);
+
+            if (&X == &Y) {
+                for (size_t i = 0; i < X.nrows; ++i) {
+                    if (pinSelfDistance(px, metric, i)) {
+                        res[i][i] = 0.0;
+                    }
+                }
+            }
+
+            return Matrix(std::move(res), InternalTag{});
+        }
+
+        /**
+         * @brief Blocked pairwiseDistances(): hands the distance matrix to @p emit one
+         * tile at a time, so that it never has to be held in memory.
+         *
+         * Tiles are computed a band of @p tileSize rows of @p X at a time, in parallel,
+         * and then emitted from the calling thread in row-major tile order, so @p emit
+         * does not need to be thread safe. Memory use is O(tileSize * rows of Y).
+         *
+         * @code
+         * // Nearest neighbour of every row of X, without an m x n matrix.
+         * Matrix::pairwiseDistances(X, Y, DistanceMetric::Euclidean, 512,
+         *     [&](size_t row0, size_t col0, const Matrix& tile) { ... });
+         * @endcode
+         *
+         * @param X (m x d) points, one per row.
+         * @param Y (n x d) points, one per row.
+         * @param metric The distance function, see DistanceMetric.
+         * @param tileSize Rows and columns per tile (edge tiles may be smaller).
+         * @param emit Called as emit(size_t rowStart, size_t colStart, const Matrix& tile),
+         *             where tile(i, j) is the distance between X row rowStart + i and
+         *             Y row colStart + j.
+         * @throws std::invalid_argument if the dimensions differ or @p tileSize is zero.
+         */
+        template <typename Callback>
+        static void pairwiseDistances(const Matrix& X, const Matrix& Y, DistanceMetric metric,
+                                      size_t tileSize, Callback emit) {
+            requireSameDimension(X, Y);
+            if (tileSize == 0) {
+                throw std::invalid_argument("Tile size must be positive");
+            }
+
+            const PackedRows px = X.packRows();
+            PackedRows packedY;
+            if (&X != &Y) {
+                packedY = Y.packRows();
+            }
+            const PackedRows& py = (&X == &Y) ? px : packedY;
+            const size_t colTiles = (Y.nrows + tileSize - 1) / tileSize;
+
+            for (size_t i0 = 0; i0 < X.nrows; i0 += tileSize) {
+                const size_t i1 = std::min(X.nrows, i0 + tileSize);
+                std::vector<std::vector<std::vector<double>>> band(colTiles);
+
+                const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Multiply, (i1 - i0) * Y.nrows * X.ncols);
+                matOpsParallel::parallelFor(0, colTiles, parallel, [&](size_t t) {
+                    const size_t j0 = t * tileSize, j1 = std::min(Y.nrows, j0 + tileSize);
+                    const size_t w = j1 - j0;
+                    std::vector<double> buffer((i1 - i0) * w);
+
+                    distanceTile(px, py, metric, i0, i1, j0, j1, buffer.data(), w);
+
+                    band[t].resize(i1 - i0);
+                    for (size_t i = 0; i < i1 - i0; ++i) {
+                        band[t][i].assign(&buffer[i * w], &buffer[i * w] + w);
+                        if (&X == &Y && i0 + i >= j0 && i0 + i < j1 && pinSelfDistance(px, metric, i0 + i)) {
+                            band[t][i][i0 + i - j0] = 0.0;
+                        }
+                    }
+                }, matOpsParallel::Schedule::Dynamic);
+
+                for (size_t t = 0; t < colTiles; ++t) {
+                    const Matrix tile(std::move(band[t]), InternalTag{});
+                    emit(i0, t * tileSize, tile);
+                }
+            }
+        }
+
+        /**
+         * @brief Computes the determinant of the matrix.
+         *
+         * @return The determinant as a double.
+         * @throws std::invalid_argument if the matrix is not square.
+         * @note The shape of the matrix remains unchanged.
+         */
+        double determinant() const {
+            if (this->nrows != this->ncols) {
+                throw std::invalid_argument(
+                    "Determinant is only defined for square matrices. Given: " + 
+                    std::to_string(nrows) + "x" + std::to_string(ncols)
+                );
+            }
+            
+            size_t n = this->container.size();
+
+            std::vector<std::vector<double>> LU = this->container;
+            int numRowSwaps = 0;
+        
+            // Perform LU Decomposition with partial pivoting.
+            for (size_t i = 0; i < n; i++) {
+                // Find the pivot in column i.
+                double maxVal = std::abs(LU[i][i]);
+                size_t pivotRow = i;
+                for (size_t k = i + 1; k < n; k++) {
+                    double val = std::abs(LU[k][i]);
+                    if (val > maxVal) {
+                        maxVal = val;
+                        pivotRow = k;
+                    }
+                }
+
+                if (std::abs(maxVal) < EPS) {
+                    return 0.0;
+                }
+
+                if (pivotRow != i) {
+                    std::swap(LU[i], LU[pivotRow]);
+                    numRowSwaps++;
+                }
+
+                for (size_t j = i + 1; j < n; j++) {
+                    LU[j][i] /= LU[i][i];
+                    for (size_t k = i + 1; k < n; k++) {
+                        LU[j][k] -= LU[j][i] * LU[i][k];
+                    }
+                }
+            }
+
+            double det = (numRowSwaps % 2 == 0) ? 1.0 : -1.0;
+            for (size_t i = 0; i < n; i++) {
+                det *= LU[i][i];
+            }
+
+            return det;
+        }
+
+        /**
+         * @brief Computes the inverse of the matrix.
+         *
+         * @return A new Matrix representing the inverse.
+         * @throws std::runtime_error if the matrix is singular (non-invertible).
+         * @note The shape remains unchanged.
+         */
+        Matrix inverse() const {
+            if (nrows != ncols) {
+                throw std::invalid_argument(
+                    "Matrix must be square to invert. Given: " + 
+                    std::to_string(nrows) + "x" + std::to_string(ncols) + "."
+                );
+            }
+
+            size_t n = nrows;
+            
+            // Make copies: one for the working matrix (A) and one for the identity (I)
+            Matrix A(*this);
+            Matrix I = Matrix::identity(n);
+            
+            // Gauss–Jordan elimination.
+            for (size_t i = 0; i < n; ++i) {
+                
+                size_t pivot = i;
+                for (size_t j = i + 1; j < n; ++j) {
+                    if (std::abs(A.container[j][i]) > std::abs(A.container[pivot][i])) {
+                        pivot = j;
+                    }
+                }
+                if (std::abs(A.container[pivot][i]) < EPS) {
+                    throw std::runtime_error("Singular matrix");
+                }
+                
+                
+                std::swap(A.container[i], A.container[pivot]);
+                std::swap(I.container[i], I.container[pivot]);
+                
+                // Normalize the pivot row.
+                double pivotVal = A.container[i][i];
+                for (size_t j = 0; j < n; ++j) {
+                    A.container[i][j] /= pivotVal;
+                    I.container[i][j] /= pivotVal;
+                }
+                
+                
+                for (size_t k = 0; k < n; ++k) {
+
+                    if (k == i) {
+                        continue;
+                    }
+
+                    double factor = A.container[k][i];
+                    for (size_t j = 0; j < n; ++j) {
+                        A.container[k][j] -= factor * A.container[i][j];
+                        I.container[k][j] -= factor * I.container[i][j];
+                    }
+                }
+            }
+            
+            return I;
+        }
+
+        /**
+         * @brief Inserts a new row into the matrix.
+         *
+         * @param row A vector representing the new row.
+         * @param idx The index at which to insert the row.
+         * @return A new Matrix with the row inserted.
+         * @throws std::invalid_argument if the row size is inconsistent or if idx is out of range.
+         */
+        Matrix insertRow(std::vector<double> row, size_t idx) const {
+            if ( this->ncols != row.size() ) {
+                throw std::invalid_argument("Ill formed row. Should be of same size as the rest of the matrix");
+            }
+
+            if (idx > this->nrows) {
+                throw std::invalid_argument("Row index out of range");
+            }
+
+            Matrix hstackRes = *this;
+            hstackRes.container.insert(hstackRes.container.begin() + idx, row);
+            hstackRes.nrows += 1;
+
+            return hstackRes;
+        }
+
+        /**
+         * @brief Inserts a new row filled with a constant value into the matrix.
+         *
+         * @param rowVal The constant value to fill the new row.
+         * @param idx The index at which to insert the row.
+         * @return A new Matrix with the row inserted.
+         * @throws std::invalid_argument if idx is out of range.
+         */
+        Matrix insertRow(double rowVal, size_t idx) const {
+            if (idx > this->nrows) {
+                throw std::invalid_argument("Row index out of range");
+            }
+
+            Matrix hstackRes = *this;
+            hstackRes.container.insert(hstackRes.container.begin() + idx, std::vector<double>(this->ncols, rowVal));
+            hstackRes.nrows += 1;
+
+            return hstackRes;
+        }
+
+        /**
+         * @brief Inserts a new column into the matrix.
+         *
+         * @param col A vector representing the new column.
+         * @param idx The index at which to insert the column.
+         * @return A new Matrix with the column inserted.
+         * @throws std::invalid_argument if the column size is inconsistent or if idx is out of range.
+         */
+        Matrix insertCol(std::vector<double> col, size_t idx) const {
+            if (this->nrows != col.size()) {
+                throw std::invalid_argument("Ill formed column. Should be of same size as the rest of the matrix");
+            }
+
+            if (idx > this->ncols) {
+                throw std::invalid_argument("Column index out of range");
+            }
+
+            Matrix vstackRes = *this;
+
+            size_t colIter = 0;
+
+            for (auto& row : vstackRes.container) {
+                row.insert(row.begin() + idx, col[colIter]);
+                colIter++;
+            }
+
+            vstackRes.ncols += 1;
+
+            return vstackRes;
+        }
+
+        /**
+         * @brief Inserts a new column filled with a constant value into the matrix.
+         *
+         * @param colVal The constant value to fill the new column.
+         * @param idx The index at which to insert the column.
+         * @return A new Matrix with the column inserted.
+         * @throws std::invalid_argument if idx is out of range.
+         */
+        Matrix insertCol(double colVal, size_t idx) const {
+            if (idx > this->ncols) {
+                throw std::invalid_argument("Column index out of range");
+            }
+
+            Matrix vstackRes = *this;
+
+            for (auto& row : vstackRes.container) {
+                row.insert(row.begin() + idx, colVal);
+            }
+
+            vstackRes.ncols += 1;
+
+            return vstackRes;
+        }
+
+        /**
+         * @brief Horizontally concatenates two matrices.
+         *
+         * This function creates and returns a new Matrix by appending the columns of the given matrix
+         * to the right of the calling matrix. Both matrices must have the same number of rows.
+         *
+         * @param other The Matrix whose columns will be appended to the calling matrix.
+         * @return A new Matrix representing the horizontal concatenation of the two matrices.
+         * @throws std::invalid_argument if the two matrices do not have the same number of rows.
+         *
+         * @note This implementation reserves the necessary capacity before inserting to minimize reallocations.
+         */
+        Matrix hStack(const Matrix& other) const {
+            if (this->nrows != other.nrows) {
+                throw std::invalid_argument("Horizontal stack requires alignment of no. of rows");
+            }
+
+            size_t rowIter = 0;
+            Matrix hStackRes = *this;
+
+            for (auto& rows: other.container) {
+                for (double val: rows) {
+                    hStackRes.container[rowIter].push_back(val);
+                }
+                rowIter++;
+            }
+
+            hStackRes.ncols += other.ncols;
+
+            return hStackRes;
+        }
+
+        /**
+         * @brief Vertically concatenates two matrices.
+         *
+         * This function creates and returns a new Matrix by appending the rows of the given matrix
+         * below the rows of the calling matrix. Both matrices must have the same number of columns.
+         *
+         * @param other The Matrix whose rows will be appended to the calling matrix.
+         * @return A new Matrix representing the vertical concatenation of the two matrices.
+         * @throws std::invalid_argument if the two matrices do not have the same number of columns.
+         *
+         * @note The function appends each row of the second matrix to the container of the first,
+         *       and updates the total row count accordingly.
+         */
+        Matrix vStack(const Matrix& other) const {
+            if (this->ncols != other.ncols) {
+                throw std::invalid_argument("Vertical stack requires alignment of no. of cols");
+            }
+
+            Matrix vStackRes = *this;
+
+            for (auto& row: other.container) {
+                vStackRes.container.push_back(row);
+            }
+
+            vStackRes.nrows += other.nrows;
+
+            return vStackRes;
+        }
+
+        /**
+         * @brief Shuffles the rows of the matrix using a random seed.
+         *
+         * This function uses a random seed generated by std::random_device to
+         * initialize the random number generator, ensuring that the shuffle
+         * is non-deterministic.
+         */
+        void shuffleRows() {
+
+            std::random_device rd;
+            std::mt19937 gen(rd());
+
+            std::shuffle(this->container.begin(), this->container.end(), gen);
+            this->touch();
+        }
+
+        /**
+         * @brief Shuffles the rows of the matrix using a specified seed.
+         *
+         * This function initializes the random number generator with the provided
+         * seed (random_state), allowing for reproducible shuffling.
+         *
+         * @param random_state The seed value used to initialize the random number generator.
+         */
+        void shuffleRows(size_t random_state) {
+
+            std::mt19937 gen(random_state);
+
+            std::shuffle(this->container.begin(), this->container.end(), gen);
+            this->touch();
+        }
+
+        /**
+         * @brief Extracts a submatrix from the current Matrix.
+         *
+         * Given a pair of row indices and a pair of column indices, this function creates
+         * and returns a new Matrix containing the submatrix defined by the specified ranges [start, end).
+
+         * @param rowSlice A std::pair<size_t, size_t> representing the start and end row indices.
+         * @param colSlice A std::pair<size_t, size_t> representing the start and end column indices.
+         * @return A new Matrix object containing the extracted submatrix.
+         * @throws std::out_of_range If any indices are out of bounds or if the slice ranges are invalid.
+         */
+        Matrix extractMatrix(std::pair<size_t, size_t> rowSlice, std::pair<size_t, size_t> colSlice) const {
+            /* Convert [start, end) to container indices */
+            size_t rowStart = rowSlice.first;       
+            size_t rowEnd   = rowSlice.second - 1;
+
+            size_t colStart = colSlice.first;
+            size_t colEnd   = colSlice.second - 1;
+
+            if (
+                rowStart >= this->nrows ||  // Check if rowStart is out of bounds
+                rowEnd   >= this->nrows ||  // Check if rowEnd is out of bounds
+                rowStart >  rowEnd      ||  // Ensure rowStart comes before rowEnd
+                colStart >= this->ncols ||  // Check if colStart is out of bounds
+                colEnd   >= this->ncols ||  // Check if colEnd is out of bounds
+                colStart > colEnd           // Ensure colStart comes before colEnd
+            ) {
+                throw std::out_of_range("Slice indices are out of bounds or invalid.");
+            }
+
+            std::vector<std::vector<double>> slice(rowEnd - rowStart + 1); 
+            /*
+            slice = something like this
+            {
+                {},
+                {},
+                ...
+            }
+            */
+            size_t sliceRowIndex = 0;
+
+            for (size_t i = rowStart; i <= rowEnd; ++i) {
+                slice[sliceRowIndex].reserve(colEnd - colStart + 1);
+                for (size_t j = colStart; j <= colEnd; ++j) {
+                    slice[sliceRowIndex].push_back(this->container[i][j]);
+                }
+                sliceRowIndex++;
+            }
+
+            return Matrix(std::move(slice), InternalTag{});
+        }
+
+        /**
+         * @brief Extracts a specific row from the current Matrix.
+         *
+         * This function creates and returns a new Matrix object containing the row at the specified index.
+         * The row is extracted as a single-row submatrix.
+         *
+         * @param rowIdx The zero-based index of the row to extract.
+         * @return A new Matrix object containing the extracted row.
+         * @throws std::invalid_argument If the specified row index is out of range.
+         */
+        Matrix extractRow(size_t rowIdx) const {
+            if (rowIdx >= this->nrows) {
+                throw std::invalid_argument("Row index out of range.");
+            }
+
+            return Matrix({this->container[rowIdx]}, InternalTag{});
+        }
+
+        /**
+         * @brief Extracts a specific column from the current Matrix.
+         *
+         * This function calls Matrix::extractMatrix() under the hood
+         * as extracting a column will require the exact same logic.
+         *
+         * @param colIdx The zero-based index of the column to extract.
+         * @return A new Matrix object containing the extracted column.
+         * @throws std::invalid_argument If the specified column index is out of range.
+         */
+        Matrix extractCol(size_t colIdx) const {
+            if (colIdx >= this->ncols) {
+                throw std::invalid_argument("Column index out of range.");
+            }
+
+            return this->extractMatrix({0, this->nrows}, {colIdx, colIdx + 1});
+        }
+
+        /**
+         * @brief Computes the sum of the elements of a vector.
+         *
+         * Calculates the sum of elements for matrices that are
+         * considered as vectors. It supports both column vectors (K x 1) and
+         * row vectors (1 x K). 
+         *
+         * @param method The summation algorithm, see Summation. The result does not
+         *               depend on the number of threads.
+         * @return The sum of all elements in the vector.
+         * @throws std::invalid_argument If the matrix is not a one-dimensional vector.
+         */
+        double sum(Summation method = Summation::Naive) const {
+            bool colMatrix = this->ncols == 1;
+            bool rowMatrix = this->nrows == 1;
+
+            if ( !colMatrix && !rowMatrix ) {
+                throw std::invalid_argument("Sum can only be calculated for (K, 1) or (1, K) dim matrices");
+            }
+
+            if ( rowMatrix ) {
+                return this->sum(Axis::All, method).container[0][0];
+            }
+
+            return this->sum(Axis::Rows, method).container[0][0];
+        }
+
+        /**
+         * @brief Computes the sum of all elements raised to a specified power.
+         *
+         * This function calculates the sum of each element in the matrix after raising
+         * it to the given @p power. The function only works for matrices that are either
+         * a row matrix (1 x K) or a column matrix (K x 1). If the matrix has any other dimensions,
+         * an std::invalid_argument exception is thrown.
+         *
+         * Additionally, if an element is zero and the @p power is less than or equal to zero,
+         * the function will throw an std::runtime_error to indicate a division by zero scenario,
+         * since 0 raised to a non-positive power is undefined.
+         *
+         * Powers are computed with the same kernels as operator^(), and long vectors are
+         * processed in parallel blocks.
+         *
+         * @param power The exponent to which each element in the matrix is raised.
+         * @param method The summation algorithm, see Summation. The result does not
+         *               depend on the number of threads.
+         * @return The sum of all elements raised to the specified power.
+         *
+         * @throws std::invalid_argument if the matrix dimensions are not (1, K) or (K, 1).
+         * @throws std::runtime_error if any element is zero and @p power is less than or equal to zero.
+         */
+        double sum(double power, Summation method = Summation::Naive) const {
+            bool colMatrix = this->ncols == 1;
+            bool rowMatrix = this->nrows == 1;
+
+            if ( !colMatrix && !rowMatrix ) {
+                throw std::invalid_argument("Sum can only be calculated for (K, 1) or (1, K) dim matrices");
+            }
+
+            if (power <= 0 && this->containsZero()) {
+                throw std::runtime_error("Division by zero occured. (0 ^ ( <=0 ))");
+            }
+
+            std::vector<double> column;
+            const double* data = this->container[0].data();
+            const size_t n = rowMatrix ? this->ncols : this->nrows;
+
+            if ( !rowMatrix ) {
+                column.resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    column[i] = this->container[i][0];
+                }
+                data = column.data();
+            }
+
+            // Powers are evaluated in blocks small enough to stay in L1.
+            const size_t block = 512;
+            const size_t nBlocks = (n + block - 1) / block;
+            std::vector<double> partial(nBlocks);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Reduction, n);
+            matOpsParallel::parallelForRange(0, nBlocks, parallel, [&](size_t lo, size_t hi) {
+                std::vector<double> powered(block), scratch(block);
+
+                for (size_t b = lo; b < hi; ++b) {
+                    const size_t start = b * block;
+                    const size_t len = std::min(block, n - start);
+                    powKernel(data + start, powered.data(), scratch.data(), len, power);
+                    partial[b] = matOpsDetail::sumSpan(powered.data(), len, method);
+                }
+            });
+
+            return matOpsDetail::sumSpan(partial.data(), nBlocks, method);
+        }
+
+        /**
+         * @brief Computes the mean (average) of the elements of a vector.
+         *
+         * Calculates the mean value for matrices that are considered as vectors.
+         * It supports both row vectors (1 x K) and column vectors (K x 1) by dividing the sum
+         * of the elements by the number of elements in the vector.
+         *
+         * @param method The summation algorithm, see Summation.
+         * @return The mean (average) value of the vector elements.
+         * @throws std::invalid_argument If the matrix is not a one-dimensional vector.
+         */
+        double mean(Summation method = Summation::Naive) const {
+            
+            double sum   = this->sum(method);
+            size_t count = (this->nrows == 1) ? this->ncols : this->nrows;
+            
+            return sum / count;
+        }
+
+        /**
+         * @brief Sum along an axis.
+         *
+         * @code
+         * Matrix A({{1, 2}, {3, 4}});
+         * A.sum(Axis::Rows);    // [[4, 6]]
+         * A.sum(Axis::Columns); // [[3], [7]]
+         * A.sum(Axis::All);     // [[10]]
+         * @endcode
+         *
+         * The data is processed in fixed blocks (row chunks of 4096 elements, or at most 64
+         * row blocks of about 4096 elements each) whose partial sums are combined in a fixed
+         * order with the same method, so the result depends neither on the number of threads
+         * nor on the Reduction threshold.
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @param method The summation algorithm, see Summation.
+         * @return A 1 x ncols, nrows x 1 or 1 x 1 Matrix of sums.
+         */
+        Matrix sum(Axis axis, Summation method = Summation::Naive) const {
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Reduction, this->nrows * this->ncols);
+
+            if (axis == Axis::Rows) {
+                const size_t blockRows = this->reductionBlockRows();
+                const size_t nBlocks = (this->nrows + blockRows - 1) / blockRows;
+
+                std::vector<std::vector<double>> partial(nBlocks, std::vector<double>(this->ncols, 0.0));
+
+                matOpsParallel::parallelFor(0, nBlocks, parallel && nBlocks > 1, [&](size_t b) {
+                    const size_t end = std::min(this->nrows, (b + 1) * blockRows);
+                    matOpsDetail::sumRows(this->container, b * blockRows, end, this->ncols, partial[b].data(), method);
+                });
+
+                std::vector<std::vector<double>> res(1, std::vector<double>(this->ncols, 0.0));
+                matOpsDetail::sumRows(partial, 0, nBlocks, this->ncols, res[0].data(), method);
+
+                return Matrix(std::move(res), InternalTag{});
+            }
+
+            const size_t chunk = 4096;
+            const size_t chunksPerRow = std::max<size_t>(1, (this->ncols + chunk - 1) / chunk);
+            const size_t nTasks = this->nrows * chunksPerRow;
+            std::vector<double> partial(nTasks);
+
+            matOpsParallel::parallelFor(0, nTasks, parallel, [&](size_t t) {
+                const size_t i = t / chunksPerRow;
+                const size_t start = (t % chunksPerRow) * chunk;
+                const size_t len = std::min(chunk, this->ncols - std::min(start, this->ncols));
+                partial[t] = matOpsDetail::sumSpan(this->container[i].data() + start, len, method);
+            });
+
+            if (axis == Axis::All) {
+                return Matrix::constValMatrix(1, 1, matOpsDetail::sumSpan(partial.data(), nTasks, method));
+            }
+
+            std::vector<std::vector<double>> res(this->nrows, std::vector<double>(1));
+            for (size_t i = 0; i < this->nrows; ++i) {
+                res[i][0] = matOpsDetail::sumSpan(partial.data() + i * chunksPerRow, chunksPerRow, method);
+            }
+
+            return Matrix(std::move(res), InternalTag{});
+        }
+
+        /**
+         * @brief Mean along an axis.
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @param method The summation algorithm, see Summation.
+         * @return A 1 x ncols, nrows x 1 or 1 x 1 Matrix of means.
+         */
+        Matrix mean(Axis axis, Summation method = Summation::Naive) const {
+            const size_t count = axis == Axis::Rows ? this->nrows : (axis == Axis::Columns ? this->ncols : this->nrows * this->ncols);
+            return this->sum(axis, method) / static_cast<double>(count);
+        }
+
+        /**
+         * @brief Product along an axis.
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @return A 1 x ncols, nrows x 1 or 1 x 1 Matrix of products.
+         */
+        Matrix prod(Axis axis) const {
+            return this->reduce(axis, 1.0, [](double x) { return x; }, [](double x, double y) { return x * y; });
+        }
+
+        /**
+         * @brief Minimum along an axis. NaN elements are ignored.
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @return A 1 x ncols, nrows x 1 or 1 x 1 Matrix of minima (+inf for an empty axis).
+         */
+        Matrix min(Axis axis) const {
+            return this->reduce(axis, std::numeric_limits<double>::infinity(), [](double x) { return x; },
+                                [](double x, double y) { return y < x ? y : x; });
+        }
+
+        /**
+         * @brief Maximum along an axis. NaN elements are ignored.
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @return A 1 x ncols, nrows x 1 or 1 x 1 Matrix of maxima (-inf for an empty axis).
+         */
+        Matrix max(Axis axis) const {
+            return this->reduce(axis, -std::numeric_limits<double>::infinity(), [](double x) { return x; },
+                                [](double x, double y) { return y > x ? y : x; });
+        }
+
+        /**
+         * @brief Index of the minimum along an axis (first occurrence on ties).
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @return Row indices (Axis::Rows, one per column), column indices (Axis::Columns,
+         *         one per row) or a single row-major flat index (Axis::All).
+         */
+        std::vector<size_t> argmin(Axis axis) const {
+            return this->argReduce(axis, false);
+        }
+
+        /**
+         * @brief Index of the maximum along an axis (first occurrence on ties).
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @return Indices as described in argmin().
+         */
+        std::vector<size_t> argmax(Axis axis) const {
+            return this->argReduce(axis, true);
+        }
+
+        /**
+         * @brief Whether any element along an axis is non-zero.
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @return A Matrix of 1.0 (true) and 0.0 (false), shaped as for sum(Axis).
+         */
+        Matrix any(Axis axis) const {
+            return this->reduce(axis, 0.0, [](double x) { return x != 0.0 ? 1.0 : 0.0; },
+                                [](double x, double y) { return y > x ? y : x; });
+        }
+
+        /**
+         * @brief Whether every element along an axis is non-zero.
+         *
+         * @param axis The axis to collapse, see Axis.
+         * @return A Matrix of 1.0 (true) and 0.0 (false), shaped as for sum(Axis).
+         */
+        Matrix all(Axis axis) const {
+            return this->reduce(axis, 1.0, [](double x) { return x != 0.0 ? 1.0 : 0.0; },
+                                [](double x, double y) { return y < x ? y : x; });
+        }
+
+        /**
+         * @brief Computes the trace of an nxn square matrix.
+         *
+         * @return Trace of calling Matrix object.
+         * @throws std::invalid_argument If the matrix is not sqaure.
+         */
+        double trace() const {
+            double tr = 0.0;
+
+            if (this->nrows != this->ncols) {
+                throw std::invalid_argument("Trace is only defined for square matrices.");
+            }
+
+            for (size_t i = 0; i < this->nrows; ++i) {
+                tr += this->container[i][i];
+            }
+
+            return tr;
+        }
+
+        /**
+         * @brief Outputs the matrix to an output stream.
+         *
+         * @param os The output stream.
+         * @param m The Matrix to output.
+         * @return A reference to the output stream.
+         */
+        friend std::ostream& operator<<(std::ostream& os, const Matrix& m) {
+            os << "[\n";
+
+            for (size_t i = 0; i < m.nrows; ++i) {
+                os << "  [";
+                for (size_t j = 0; j < m.ncols; ++j) {
+                    os << m.container[i][j];
+
+                    if (j < m.ncols - 1) os << ", ";
+                }
+                os << "]" << (i < m.nrows - 1 ? ",\n" : "\n");
+            }
+            os << "]\n";
+            return os;
+        }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const std::pair<size_t, size_t>& shape) {
+    os << "(" << shape.first << ", " << shape.second << ")";
+
+    return os;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const std::vector<std::vector<double>>& container) {
+    size_t nrows = container.size();
+    size_t ncols = container[0].size();
+
+    os << "[\n";
+
+    for (size_t i = 0; i < nrows; ++i) {
+        os << "  [";
+        for (size_t j = 0; j < ncols; ++j) {
+            os << container[i][j];
+
+            if (j < ncols - 1) os << ", ";
+        }
+        os << "]" << (i < nrows - 1 ? ",\n" : "\n");
+    }
+    os << "]\n";
+    return os;
+}
+
+/**
+ * @class CSRMatrix
+ * @brief Compressed Sparse Row storage for matrices with few nonzeros.
+ *
+ * Row i owns the entries values[rowPtr[i] .. rowPtr[i + 1]), whose column
+ * indices are stored (sorted, without duplicates) at the same positions of colIdx.
+ *
+ * Example Usage:
+ * @code
+ * Matrix A({{4, 0, 1}, {0, 3, 0}, {1, 0, 2}});
+ * CSRMatrix S = CSRMatrix::fromDense(A);
+ * std::vector<double> y = S * std::vector<double>{1, 1, 1}; // y = {5, 3, 3}
+ * @endcode
+ */
+class CSRMatrix {
+    private:
+        std::vector<size_t> rowPtr; ///< Offsets of the first entry of every row (size nrows + 1).
+        std::vector<size_t> colIdx; ///< Column index of every stored entry.
+        std::vector<double> values; ///< Value of every stored entry.
+        size_t nrows; ///< Number of rows in the matrix.
+        size_t ncols; ///< Number of columns in the matrix.
+
+        struct InternalTag {};
+
+        /**
+         * @brief Internal constructor that moves pre-validated CSR arrays into place.
+         *
+         * @note This constructor does not perform any validation.
+         */
+        CSRMatrix(size_t rows, size_t cols, std::vector<size_t>&& rowPtr,
+                  std::vector<size_t>&& colIdx, std::vector<double>&& values, InternalTag)
+            : rowPtr(std::move(rowPtr)), colIdx(std::move(colIdx)), values(std::move(values)),
+              nrows(rows), ncols(cols) {}
+
+    public:
+        /**
+         * @brief Summary of a symmetric reordering, as returned by reorderRCM().
+         */
+        struct ReorderingReport {
+            std::vector<size_t> permutation; ///< permutation[k] is the old index placed at position k.
+            size_t bandwidthBefore; ///< Bandwidth of the original matrix.
+            size_t bandwidthAfter;  ///< Bandwidth of the reordered matrix.
+            size_t profileBefore;   ///< Profile (envelope size) of the original matrix.
+            size_t profileAfter;    ///< Profile (envelope size) of the reordered matrix.
+        };
+
+        /**
+         * @brief Constructs a CSRMatrix from raw CSR arrays.
+         *
+         * @param rows Number of rows.
+         * @param cols Number of columns.
+         * @param rowPtr Row offsets, of size rows + 1, starting at 0 and non-decreasing.
+         * @param colIdx Column indices, strictly increasing within every row.
+         * @param values Stored values, one per column index.
+         * @throws std::invalid_argument if the dimensions are zero or the arrays are ill formed.
+         */
+        CSRMatrix(size_t rows, size_t cols, std::vector<size_t> rowPtr,
+                  std::vector<size_t> colIdx, std::vector<double> values)
+            : rowPtr(std::move(rowPtr)), colIdx(std::move(colIdx)), values(std::move(values)),
+              nrows(rows), ncols(cols) {
+
+            if (rows == 0 || cols == 0) {
+                throw std::invalid_argument("Matrix cannot have zero dimensions");
+            }
+
+            if (this->rowPtr.size() != rows + 1 || this->rowPtr[0] != 0) {
+                throw std::invalid_argument("Ill formed row pointers. Expected rows + 1 offsets starting at 0");
+            }
+
+            if (this->colIdx.size() != this->values.size() || this->rowPtr[rows] != this->values.size()) {
+                throw std::invalid_argument("Row pointers, column indices and values do not agree on nnz");
+            }
+
+            for (size_t i = 0; i < rows; ++i) {
+                if (this->rowPtr[i] > this->rowPtr[i + 1]) {
+                    throw std::invalid_argument("Row pointers must be non-decreasing");
+                }
+
+                for (size_t k = this->rowPtr[i]; k < this->rowPtr[i + 1]; ++k) {
+                    if (this->colIdx[k] >= cols) {
+                        throw std::invalid_argument("Column index out of range");
+                    }
+                    if (k > this->rowPtr[i] && this->colIdx[k] <= this->colIdx[k - 1]) {
+                        throw std::invalid_argument("Column indices must be strictly increasing within a row");
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Builds a CSRMatrix holding the nonzero entries of a dense Matrix.
+         *
+         * @param dense The dense matrix to compress.
+         * @param dropTolerance Entries with |value| <= dropTolerance are not stored.
+         * @return The compressed matrix.
+         */
+        static CSRMatrix fromDense(const Matrix& dense, double dropTolerance = 0.0) {
+            std::vector<size_t> rowPtr(dense.nrows + 1, 0);
+            std::vector<size_t> colIdx;
+            std::vector<double> values;
+
+            for (size_t i = 0; i < dense.nrows; ++i) {
+                for (size_t j = 0; j < dense.ncols; ++j) {
+                    double val = dense.container[i][j];
+                    if (std::abs(val) > dropTolerance) {
+                        colIdx.push_back(j);
+                        values.push_back(val);
+                    }
+                }
+                rowPtr[i + 1] = values.size();
+            }
+
+            return CSRMatrix(dense.nrows, dense.ncols, std::move(rowPtr), std::move(colIdx), std::move(values), InternalTag{});
+        }
+
+        /**
+         * @brief Builds a CSRMatrix from coordinate (row, col, value) triplets.
+         *
+         * Triplets may come in any order. Duplicate (row, col) pairs are summed.
+         *
+         * @param rows Number of rows.
+         * @param cols Number of columns.
+         * @param rowIdx Row index of every triplet.
+         * @param colIdx Column index of every triplet.
+         * @param values Value of every triplet.
+         * @return The compressed matrix.
+         * @throws std::invalid_argument if the arrays differ in size, an index is out of range
+         *         or a dimension is zero.
+         */
+        static CSRMatrix fromTriplets(size_t rows, size_t cols, const std::vector<size_t>& rowIdx,
+                                      const std::vector<size_t>& colIdx, const std::vector<double>& values) {
+            if (rows == 0 || cols == 0) {
+                throw std::invalid_argument("Matrix cannot have zero dimensions");
+            }
+
+            if (rowIdx.size() != colIdx.size() || rowIdx.size() != values.size()) {
+                throw std::invalid_argument("Triplet arrays must have the same size");
+            }
+
+            // Counting sort of the triplets by row.
+            std::vector<size_t> rowPtr(rows + 1, 0);
+            for (size_t k = 0; k < rowIdx.size(); ++k) {
+                if (rowIdx[k] >= rows || colIdx[k] >= cols) {
+                    throw std::invalid_argument("Triplet index out of range");
+                }
+                rowPtr[rowIdx[k] + 1]++;
+            }
+            std::partial_sum(rowPtr.begin(), rowPtr.end(), rowPtr.begin());
+
+            std::vector<size_t> next(rowPtr.begin(), rowPtr.end() - 1);
+            std::vector<std::pair<size_t, double>> entries(values.size());
+            for (size_t k = 0; k < rowIdx.size(); ++k) {
+                entries[next[rowIdx[k]]++] = {colIdx[k], values[k]};
+            }
+
+            // Sort every row by column and merge duplicates.
+            std::vector<size_t> outPtr(rows + 1, 0);
+            std::vector<size_t> outCol;
+            std::vector<double> outVal;
+            outCol.reserve(entries.size());
+            outVal.reserve(entries.size());
+
+            for (size_t i = 0; i < rows; ++i) {
+                std::sort(entries.begin() + rowPtr[i], entries.begin() + rowPtr[i + 1],
+                          [](const std::pair<size_t, double>& a, const std::pair<size_t, double>& b) {
+                              return a.first < b.first;
+                          });
+
+                for (size_t k = rowPtr[i]; k < rowPtr[i + 1]; ++k) {
+                    if (outCol.size() > outPtr[i] && outCol.back() == entries[k].first) {
+                        outVal.back() += entries[k].second;
+                    } else {
+                        outCol.push_back(entries[k].first);
+                        outVal.push_back(entries[k].second);
+                    }
+                }
+                outPtr[i + 1] = outCol.size();
+            }
+
+            return CSRMatrix(rows, cols, std::move(outPtr), std::move(outCol), std::move(outVal), InternalTag{});
+        }
+
+        /**
+         * @brief Returns the dimensions of the matrix.
+         *
+         * @return A std::pair where first is the number of rows and second is the number of columns.
+         */
+        std::pair<size_t, size_t> shape() const { return {nrows, ncols}; }
+
+        /**
+         * @brief Returns the number of stored entries.
+         */
+        size_t nnz() const { return values.size(); }
+
+        /// @brief Row offsets array (size nrows + 1).
+        const std::vector<size_t>& rowPointers() const { return rowPtr; }
+
+        /// @brief Column index of every stored entry.
+        const std::vector<size_t>& colIndices() const { return colIdx; }
+
+        /// @brief Value of every stored entry.
+        const std::vector<double>& nonZeroValues() const { return values; }
+
+        /**
+         * @brief Computes the bandwidth of the matrix, max |i - j| over stored entries.
+         */
+        size_t bandwidth() const {
+            size_t band = 0;
+
+            for (size_t i = 0; i < this->nrows; ++i) {
+                if (this->rowPtr[i] == this->rowPtr[i + 1]) {
+                    continue;
+                }
+
+                // Columns are sorted, so the extremes of a row are its first and last entries.
+                size_t lo = this->colIdx[this->rowPtr[i]];
+                size_t hi = this->colIdx[this->rowPtr[i + 1] - 1];
+                band = std::max(band, std::max(lo < i ? i - lo : 0, hi > i ? hi - i : 0));
+            }
+
+            return band;
+        }
+
+        /**
+         * @brief Computes the profile (envelope size) of the matrix.
+         *
+         * The profile is the sum over rows of i - f(i), where f(i) is the column of the
+         * first entry of row i that lies on or below the diagonal.
+         */
+        size_t profile() const {
+            size_t total = 0;
+
+            for (size_t i = 0; i < this->nrows; ++i) {
+                if (this->rowPtr[i] != this->rowPtr[i + 1] && this->colIdx[this->rowPtr[i]] < i) {
+                    total += i - this->colIdx[this->rowPtr[i]];
+                }
+            }
+
+            return total;
+        }
+
+        /**
+         * @brief Computes the Reverse Cuthill-McKee ordering of the matrix.
+         *
+         * The pattern is symmetrized (A + A^T). Every connected component is traversed
+         * breadth first from a pseudo-peripheral vertex, visiting neighbours by increasing
+         * degree, and the resulting order is reversed. This clusters the entries around the
+         * diagonal, which reduces bandwidth and profile and improves the locality of SpMV.
+         *
+         * @return The permutation: element k is the old index placed at position k.
+         * @throws std::invalid_argument if the matrix is not square.
+         */
+        std::vector<size_t> reverseCuthillMcKee() const {
+            if (this->nrows != this->ncols) {
+                throw std::invalid_argument("Reordering requires a square matrix");
+            }
+
+            const size_t n = this->nrows;
+            const size_t none = static_cast<size_t>(-1);
+
+            std::vector<std::vector<size_t>> adj(n);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t k = this->rowPtr[i]; k < this->rowPtr[i + 1]; ++k) {
+                    if (this->colIdx[k] != i) {
+                        adj[i].push_back(this->colIdx[k]);
+                        adj[this->colIdx[k]].push_back(i);
+                    }
+                }
+            }
+
+            for (auto& nbrs : adj) {
+                std::sort(nbrs.begin(), nbrs.end());
+                nbrs.erase(std::unique(nbrs.begin(), nbrs.end()), nbrs.end());
+            }
+
+            for (auto& nbrs : adj) {
+                std::stable_sort(nbrs.begin(), nbrs.end(), [&adj](size_t a, size_t b) {
+                    return adj[a].size() < adj[b].size();
+                });
+            }
+
+            std::vector<size_t> level(n, none);
+            std::vector<size_t> order;
+            order.reserve(n);
+
+            // Breadth first search restricted to unordered vertices. Returns the vertices
+            // visited (in visiting order) and leaves their depth in level.
+            std::vector<size_t> visited;
+            auto bfs = [&](size_t root) {
+                visited.clear();
+                visited.push_back(root);
+                level[root] = 0;
+
+                for (size_t head = 0; head < visited.size(); ++head) {
+                    size_t v = visited[head];
+                    for (size_t u : adj[v]) {
+                        if (level[u] == none) {
+                            level[u] = level[v] + 1;
+                            visited.push_back(u);
+                        }
+                    }
+                }
+            };
+            auto resetLevels = [&]() {
+                for (size_t v : visited) {
+                    level[v] = none;
+                }
+            };
+
+            std::vector<bool> ordered(n, false);
+
+            for (size_t start = 0; start < n; ++start) {
+                if (ordered[start]) {
+                    continue;
+                }
+
+                // Pseudo-peripheral vertex (George and Liu): move to a minimum degree
+                // vertex of the last BFS level while the eccentricity keeps growing.
+                size_t root = start;
+                bfs(root);
+                size_t depth = level[visited.back()];
+
+                while (true) {
+                    size_t candidate = visited.back();
+                    for (size_t v : visited) {
+                        if (level[v] == depth && adj[v].size() < adj[candidate].size()) {
+                            candidate = v;
+                        }
+                    }
+
+                    resetLevels();
+                    bfs(candidate);
+                    size_t candidateDepth = level[visited.back()];
+
+                    if (candidateDepth <= depth) {
+                        resetLevels();
+                        bfs(root);
+                        break;
+                    }
+
+                    root = candidate;
+                    depth = candidateDepth;
+                }
+
+                // visited is now the Cuthill-McKee order of this component.
+                for (size_t v : visited) {
+                    ordered[v] = true;
+                    order.push_back(v);
+                }
+            }
+
+            std::reverse(order.begin(), order.end());
+
+            return order;
+        }
+
+        /**
+         * @brief Applies a symmetric permutation, returning P A P^T.
+         *
+         * @param perm The permutation: element k is the old index placed at position k.
+         * @return The permuted matrix, whose entry (k, l) is entry (perm[k], perm[l]) of this one.
+         * @throws std::invalid_argument if the matrix is not square or @p perm is not a permutation.
+         */
+        CSRMatrix permute(const std::vector<size_t>& perm) const {
+            if (this->nrows != this->ncols) {
+                throw std::invalid_argument("Symmetric permutation requires a square matrix");
+            }
+
+            const size_t n = this->nrows;
+            const size_t none = static_cast<size_t>(-1);
+
+            if (perm.size() != n) {
+                throw std::invalid_argument("Permutation size does not match the matrix dimension");
+            }
+
+            std::vector<size_t> iperm(n, none);
+            for (size_t k = 0; k < n; ++k) {
+                if (perm[k] >= n || iperm[perm[k]] != none) {
+                    throw std::invalid_argument("Invalid permutation");
+                }
+                iperm[perm[k]] = k;
+            }
+
+            std::vector<size_t> outPtr(n + 1, 0);
+            std::vector<size_t> outCol(this->nnz());
+            std::vector<double> outVal(this->nnz());
+
+            for (size_t k = 0; k < n; ++k) {
+                outPtr[k + 1] = outPtr[k] + (this->rowPtr[perm[k] + 1] - this->rowPtr[perm[k]]);
+            }
+
+            std::vector<std::pair<size_t, double>> row;
+            for (size_t k = 0; k < n; ++k) {
+                size_t old = perm[k];
+                row.clear();
+                for (size_t e = this->rowPtr[old]; e < this->rowPtr[old + 1]; ++e) {
+                    row.push_back({iperm[this->colIdx[e]], this->values[e]});
+                }
+                std::sort(row.begin(), row.end(),
+                          [](const std::pair<size_t, double>& a, const std::pair<size_t, double>& b) {
+                              return a.first < b.first;
+                          });
+
+                for (size_t e = 0; e < row.size(); ++e) {
+                    outCol[outPtr[k] + e] = row[e].first;
+                    outVal[outPtr[k] + e] = row[e].second;
+                }
+            }
+
+            return CSRMatrix(n, n, std::move(outPtr), std::move(outCol), std::move(outVal), InternalTag{});
+        }
+
+        /**
+         * @brief Reorders the matrix with Reverse Cuthill-McKee.
+         *
+         * Example Usage:
+         * @code
+         * auto res = A.reorderRCM();
+         * CSRMatrix B = res.first;        // P A P^T
+         * std::cout << res.second.bandwidthBefore << " -> " << res.second.bandwidthAfter;
+         * @endcode
+         *
+         * @return The symmetrically permuted matrix and a report with the permutation,
+         *         bandwidth and profile before and after.
+         * @throws std::invalid_argument if the matrix is not square.
+         */
+        std::pair<CSRMatrix, ReorderingReport> reorderRCM() const {
+            ReorderingReport report;
+            report.permutation = this->reverseCuthillMcKee();
+
+            CSRMatrix reordered = this->permute(report.permutation);
+
+            report.bandwidthBefore = this->bandwidth();
+            report.bandwidthAfter  = reordered.bandwidth();
+            report.profileBefore   = this->profile();
+            report.profileAfter    = reordered.profile();
+
+            return {std::move(reordered), std::move(report)};
+        }
+
+        /**
+         * @brief Sparse matrix-vector product (SpMV).
+         *
+         * @param x A vector of size ncols.
+         * @return The vector y = A * x of size nrows.
+         * @throws std::invalid_argument if the size of @p x does not match the number of columns.
+         */
+        std::vector<double> operator*(const std::vector<double>& x) const {
+            if (x.size() != this->ncols) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: Expected a vector of size " + std::to_string(this->ncols) +
+                    ", given: " + std::to_string(x.size()) + "."
+                );
+            }
+
+            std::vector<double> y(this->nrows, 0.0);
+
+            const size_t* rp  = this->rowPtr.data();
+            const size_t* ci  = this->colIdx.data();
+            const double* val = this->values.data();
+            const double* xp  = x.data();
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Sparse, this->nnz());
+            matOpsParallel::parallelFor(0, this->nrows, parallel, [&](size_t i) {
+                double acc = 0.0;
+
+                #pragma omp simd reduction(+:acc)
+                for (size_t k = rp[i]; k < rp[i + 1]; ++k) {
+                    acc += val[k] * xp[ci[k]];
+                }
+
+                y[i] = acc;
+            });
+
+            return y;
+        }
+
+        /**
+         * @brief Expands the matrix into a dense Matrix.
+         *
+         * @return A dense Matrix with the same shape and entries.
+         */
+        Matrix toDense() const {
+            std::vector<std::vector<double>> dense = Matrix::allocateRows(this->nrows, this->ncols);
+
+            for (size_t i = 0; i < this->nrows; ++i) {
+                for (size_t k = this->rowPtr[i]; k < this->rowPtr[i + 1]; ++k) {
+                    dense[i][this->colIdx[k]] = this->values[k];
+                }
+            }
+
+            return Matrix(std::move(dense), Matrix::InternalTag{});
+        }
+};
+
+/**
+ * @class SELLMatrix
+ * @brief Sliced ELLPACK (SELL-C-sigma) storage for SIMD friendly SpMV.
+ *
+ * Rows are grouped into chunks of C consecutive rows. Every chunk is padded to the
+ * length of its longest row and stored column-major, so that one step of the SpMV
+ * kernel processes C rows at once with unit-stride loads, i.e. one full SIMD
+ * operation when C is a multiple of the register width.
+ *
+ * To limit padding, rows are sorted by decreasing length inside windows of sigma rows
+ * before being chunked. The row permutation is remembered and undone when the result
+ * is written back, so the product is the same as for the original CSR matrix.
+ *
+ * Use fillEfficiency() to decide between SELL and CSR for a given matrix: values close
+ * to 1 mean little padding, and SELL usually wins.
+ *
+ * Example Usage:
+ * @code
+ * CSRMatrix A = CSRMatrix::fromDense(M);
+ * SELLMatrix S = SELLMatrix::fromCSR(A);      // C = 2 * SIMD width, sigma = 256
+ * std::vector<double> y = S * x;             // Same result as A * x
+ * @endcode
+ */
+class SELLMatrix {
+    private:
+        std::vector<size_t> chunkPtr; ///< Offset of the first stored entry of every chunk (size nchunks + 1).
+        std::vector<size_t> chunkLen; ///< Padded row length of every chunk.
+        std::vector<size_t> colIdx;   ///< Column indices, column-major inside every chunk.
+        std::vector<double> values;   ///< Values, column-major inside every chunk (padding is 0).
+        std::vector<size_t> rowPerm;  ///< rowPerm[k] is the original row stored at sorted position k.
+        size_t nrows; ///< Number of rows in the matrix.
+        size_t ncols; ///< Number of columns in the matrix.
+        size_t chunkSize; ///< Chunk height C.
+        size_t sigma; ///< Sorting window sigma.
+        size_t nonZeros; ///< Number of entries of the original matrix.
+
+        SELLMatrix() : nrows(0), ncols(0), chunkSize(0), sigma(0), nonZeros(0) {}
+
+        /**
+         * @brief SpMV kernel with the chunk height known at compile time.
+         *
+         * The per-chunk accumulator fits in C / SIMD width registers and the inner
+         * loop over C rows is fully vectorized.
+         */
+        template <size_t C>
+        void spmvFixed(const double* xp, double* yp) const {
+            const size_t nchunks = this->chunkLen.size();
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Sparse, this->values.size());
+            matOpsParallel::parallelFor(0, nchunks, parallel, [&](size_t c) {
+                double acc[C] = {};
+                const size_t* ci  = this->colIdx.data() + this->chunkPtr[c];
+                const double* val = this->values.data() + this->chunkPtr[c];
+
+                for (size_t j = 0; j < this->chunkLen[c]; ++j) {
+                    #pragma omp simd
+                    for (size_t r = 0; r < C; ++r) {
+                        acc[r] += val[j * C + r] * xp[ci[j * C + r]];
+                    }
+                }
+
+                const size_t rowBegin = c * C;
+                const size_t rowEnd   = std::min(rowBegin + C, this->nrows);
+                for (size_t r = rowBegin; r < rowEnd; ++r) {
+                    yp[this->rowPerm[r]] = acc[r - rowBegin];
+                }
+            });
+        }
+
+        /**
+         * @brief SpMV kernel for chunk heights without a specialized instantiation.
+         */
+        void spmvGeneric(const double* xp, double* yp) const {
+            const size_t C = this->chunkSize;
+            const size_t nchunks = this->chunkLen.size();
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Sparse, this->values.size());
+            matOpsParallel::parallelFor(0, nchunks, parallel, [&](size_t c) {
+                std::vector<double> acc(C, 0.0);
+                const size_t* ci  = this->colIdx.data() + this->chunkPtr[c];
+                const double* val = this->values.data() + this->chunkPtr[c];
+
+                for (size_t j = 0; j < this->chunkLen[c]; ++j) {
+                    #pragma omp simd
+                    for (size_t r = 0; r < C; ++r) {
+                        acc[r] += val[j * C + r] * xp[ci[j * C + r]];
+                    }
+                }
+
+                const size_t rowBegin = c * C;
+                const size_t rowEnd   = std::min(rowBegin + C, this->nrows);
+                for (size_t r = rowBegin; r < rowEnd; ++r) {
+                    yp[this->rowPerm[r]] = acc[r - rowBegin];
+                }
+            });
+        }
+
+    public:
+        /**
+         * @brief Converts a CSR matrix into SELL-C-sigma format.
+         *
+         * @param csr The matrix to convert.
+         * @param chunkSize Chunk height C. Defaults to two SIMD registers worth of doubles.
+         * @param sigma Sorting window (in rows). 1 disables sorting; values >= nrows sort globally.
+         * @return The converted matrix.
+         * @throws std::invalid_argument if @p chunkSize or @p sigma is zero.
+         */
+        static SELLMatrix fromCSR(const CSRMatrix& csr, size_t chunkSize = 2 * MATOPS_SIMD_DOUBLES, size_t sigma = 256) {
+            if (chunkSize == 0 || sigma == 0) {
+                throw std::invalid_argument("SELL chunk size and sorting window must be positive");
+            }
+
+            const std::vector<size_t>& rp = csr.rowPointers();
+            const std::vector<size_t>& ci = csr.colIndices();
+            const std::vector<double>& val = csr.nonZeroValues();
+
+            SELLMatrix sell;
+            sell.nrows     = csr.shape().first;
+            sell.ncols     = csr.shape().second;
+            sell.chunkSize = chunkSize;
+            sell.sigma     = sigma;
+            sell.nonZeros  = csr.nnz();
+
+            // Sort rows by decreasing length inside every sigma window.
+            sell.rowPerm.resize(sell.nrows);
+            std::iota(sell.rowPerm.begin(), sell.rowPerm.end(), 0);
+
+            for (size_t w = 0; w < sell.nrows; w += sigma) {
+                size_t wEnd = std::min(w + sigma, sell.nrows);
+                std::stable_sort(sell.rowPerm.begin() + w, sell.rowPerm.begin() + wEnd,
+                                 [&rp](size_t a, size_t b) {
+                                     return rp[a + 1] - rp[a] > rp[b + 1] - rp[b];
+                                 });
+            }
+
+            const size_t nchunks = (sell.nrows + chunkSize - 1) / chunkSize;
+            sell.chunkLen.assign(nchunks, 0);
+            sell.chunkPtr.assign(nchunks + 1, 0);
+
+            for (size_t c = 0; c < nchunks; ++c) {
+                size_t rowEnd = std::min((c + 1) * chunkSize, sell.nrows);
+                for (size_t r = c * chunkSize; r < rowEnd; ++r) {
+                    size_t row = sell.rowPerm[r];
+                    sell.chunkLen[c] = std::max(sell.chunkLen[c], rp[row + 1] - rp[row]);
+                }
+                sell.chunkPtr[c + 1] = sell.chunkPtr[c] + sell.chunkLen[c] * chunkSize;
+            }
+
+            // Padding points at column 0 with a zero value, so the kernel needs no masking.
+            sell.colIdx.assign(sell.chunkPtr[nchunks], 0);
+            sell.values.assign(sell.chunkPtr[nchunks], 0.0);
+
+            for (size_t c = 0; c < nchunks; ++c) {
+                size_t rowEnd = std::min((c + 1) * chunkSize, sell.nrows);
+                for (size_t r = c * chunkSize; r < rowEnd; ++r) {
+                    size_t row  = sell.rowPerm[r];
+                    size_t lane = r - c * chunkSize;
+                    for (size_t k = rp[row]; k < rp[row + 1]; ++k) {
+                        size_t pos = sell.chunkPtr[c] + (k - rp[row]) * chunkSize + lane;
+                        sell.colIdx[pos] = ci[k];
+                        sell.values[pos] = val[k];
+                    }
+                }
+            }
+
+            return sell;
+        }
+
+        /**
+         * @brief Returns the dimensions of the matrix.
+         *
+         * @return A std::pair where first is the number of rows and second is the number of columns.
+         */
+        std::pair<size_t, size_t> shape() const { return {nrows, ncols}; }
+
+        /// @brief Number of entries of the original matrix (padding excluded).
+        size_t nnz() const { return nonZeros; }
+
+        /// @brief Number of stored entries (padding included).
+        size_t storedEntries() const { return values.size(); }
+
+        /// @brief Chunk height C.
+        size_t chunkHeight() const { return chunkSize; }
+
+        /// @brief Sorting window sigma.
+        size_t sortingWindow() const { return sigma; }
+
+        /**
+         * @brief Ratio of useful entries to stored entries, in (0, 1].
+         *
+         * A value of 1 means no padding at all. Low values indicate that CSR is the
+         * better format for this matrix.
+         */
+        double fillEfficiency() const {
+            return this->values.empty() ? 1.0 : static_cast<double>(this->nonZeros) / this->values.size();
+        }
+
+        /**
+         * @brief Sparse matrix-vector product (SpMV).
+         *
+         * @param x A vector of size ncols.
+         * @return The vector y = A * x of size nrows.
+         * @throws std::invalid_argument if the size of @p x does not match the number of columns.
+         */
+        std::vector<double> operator*(const std::vector<double>& x) const {
+            if (x.size() != this->ncols) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: Expected a vector of size " + std::to_string(this->ncols) +
+                    ", given: " + std::to_string(x.size()) + "."
+                );
+            }
+
+            std::vector<double> y(this->nrows, 0.0);
+
+            switch (this->chunkSize) {
+                case 4:  spmvFixed<4>(x.data(), y.data());  break;
+                case 8:  spmvFixed<8>(x.data(), y.data());  break;
+                case 16: spmvFixed<16>(x.data(), y.data()); break;
+                case 32: spmvFixed<32>(x.data(), y.data()); break;
+                default: spmvGeneric(x.data(), y.data());   break;
+            }
+
+            return y;
+        }
+
+        /**
+         * @brief Expands the matrix into a dense Matrix.
+         *
+         * @return A dense Matrix with the same shape and entries.
+         */
+        Matrix toDense() const {
+            std::vector<std::vector<double>> dense = Matrix::allocateRows(this->nrows, this->ncols);
+
+            for (size_t c = 0; c < this->chunkLen.size(); ++c) {
+                size_t rowEnd = std::min((c + 1) * this->chunkSize, this->nrows);
+                for (size_t r = c * this->chunkSize; r < rowEnd; ++r) {
+                    size_t lane = r - c * this->chunkSize;
+                    for (size_t j = 0; j < this->chunkLen[c]; ++j) {
+                        size_t pos = this->chunkPtr[c] + j * this->chunkSize + lane;
+                        dense[this->rowPerm[r]][this->colIdx[pos]] += this->values[pos];
+                    }
+                }
+            }
+
+            return Matrix(std::move(dense), Matrix::InternalTag{});
+        }
+};
+
+/**
+ * @class BSRMatrix
+ * @brief Block Sparse Row storage with dense R x C blocks.
+ *
+ * The matrix is tiled into R x C blocks and only the blocks holding at least one
+ * nonzero are stored, each as a dense row-major R x C array. A single column index
+ * is kept per block instead of one per entry, and all block level arithmetic runs
+ * through fixed-size micro-kernels that the compiler fully unrolls.
+ *
+ * The block size is a template parameter, so BSRMatrix<3> and BSRMatrix<6> are the
+ * natural choices for 3 and 6 degree-of-freedom structural meshes.
+ *
+ * Example Usage:
+ * @code
+ * CSRMatrix K = ...;                            // 3 DOFs per node
+ * BSRMatrix<3> B = BSRMatrix<3>::fromCSR(K);
+ * std::vector<double> f = B * u;               // SpMV
+ * Matrix G = B * U;                            // SpMM with a dense block of vectors
+ * std::vector<double> g = B.transposeMultiply(u); // A^T * u
+ * @endcode
+ */
+template <size_t R, size_t C>
+class BSRMatrix {
+    static_assert(R > 0 && C > 0, "BSR block dimensions must be positive");
+
+    private:
+        std::vector<size_t> blockRowPtr; ///< Offset of the first block of every block row (size nblockrows + 1).
+        std::vector<size_t> blockColIdx; ///< Block column index of every stored block.
+        std::vector<double> blocks;      ///< Stored blocks, R * C row-major values each.
+        size_t nrows; ///< Number of rows in the matrix.
+        size_t ncols; ///< Number of columns in the matrix.
+
+        BSRMatrix() : nrows(0), ncols(0) {}
+
+        /* y[0..R) += blk * x[0..C) */
+        static inline void blockGemv(const double* blk, const double* x, double* y) {
+            for (size_t r = 0; r < R; ++r) {
+                double acc = 0.0;
+                for (size_t c = 0; c < C; ++c) {
+                    acc += blk[r * C + c] * x[c];
+                }
+                y[r] += acc;
+            }
+        }
+
+        /* y[0..C) += blk^T * x[0..R) */
+        static inline void blockGemvT(const double* blk, const double* x, double* y) {
+            for (size_t r = 0; r < R; ++r) {
+                const double xr = x[r];
+                for (size_t c = 0; c < C; ++c) {
+                    y[c] += blk[r * C + c] * xr;
+                }
+            }
+        }
+
+        /* Y[0..R)[0..k) += blk * X[0..C)[0..k), with rows given as pointers. */
+        static inline void blockGemm(const double* blk, const double* const* X, double* const* Y, size_t k) {
+            for (size_t r = 0; r < R; ++r) {
+                double* yr = Y[r];
+                for (size_t c = 0; c < C; ++c) {
+                    const double a = blk[r * C + c];
+                    const double* xc = X[c];
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < k; ++j) {
+                        yr[j] += a * xc[j];
+                    }
+                }
+            }
+        }
+
+        /* Y[0..C)[0..k) += blk^T * X[0..R)[0..k), with rows given as pointers. */
+        static inline void blockGemmT(const double* blk, const double* const* X, double* const* Y, size_t k) {
+            for (size_t r = 0; r < R; ++r) {
+                const double* xr = X[r];
+                for (size_t c = 0; c < C; ++c) {
+                    const double a = blk[r * C + c];
+                    double* yc = Y[c];
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < k; ++j) {
+                        yc[j] += a * xr[j];
+                    }
+                }
+            }
+        }
+
+    public:
+        /**
+         * @brief Converts a CSR matrix into BSR format.
+         *
+         * @param csr The matrix to convert. Its dimensions must be multiples of R and C.
+         * @return The converted matrix. Entries of a block missing from @p csr are stored as 0.
+         * @throws std::invalid_argument if the dimensions are not multiples of the block size.
+         */
+        static BSRMatrix fromCSR(const CSRMatrix& csr) {
+            const size_t rows = csr.shape().first;
+            const size_t cols = csr.shape().second;
+
+            if (rows % R != 0 || cols % C != 0) {
+                throw std::invalid_argument(
+                    "Matrix dimensions (" + std::to_string(rows) + "x" + std::to_string(cols) +
+                    ") are not multiples of the block size (" + std::to_string(R) + "x" + std::to_string(C) + ")"
+                );
+            }
+
+            const std::vector<size_t>& rp = csr.rowPointers();
+            const std::vector<size_t>& ci = csr.colIndices();
+            const std::vector<double>& val = csr.nonZeroValues();
+
+            const size_t nBlockRows = rows / R;
+            const size_t nBlockCols = cols / C;
+            const size_t unset = static_cast<size_t>(-1);
+
+            BSRMatrix bsr;
+            bsr.nrows = rows;
+            bsr.ncols = cols;
+            bsr.blockRowPtr.assign(nBlockRows + 1, 0);
+
+            std::vector<size_t> blockPos(nBlockCols, unset);
+
+            for (size_t I = 0; I < nBlockRows; ++I) {
+                // Collect the distinct block columns touched by the R rows of this block row.
+                const size_t first = bsr.blockColIdx.size();
+                for (size_t i = I * R; i < (I + 1) * R; ++i) {
+                    for (size_t k = rp[i]; k < rp[i + 1]; ++k) {
+                        size_t J = ci[k] / C;
+                        if (blockPos[J] == unset) {
+                            blockPos[J] = 0;
+                            bsr.blockColIdx.push_back(J);
+                        }
+                    }
+                }
+                std::sort(bsr.blockColIdx.begin() + first, bsr.blockColIdx.end());
+
+                for (size_t b = first; b < bsr.blockColIdx.size(); ++b) {
+                    blockPos[bsr.blockColIdx[b]] = b;
+                }
+                bsr.blocks.resize(bsr.blockColIdx.size() * R * C, 0.0);
+
+                for (size_t i = I * R; i < (I + 1) * R; ++i) {
+                    for (size_t k = rp[i]; k < rp[i + 1]; ++k) {
+                        size_t b = blockPos[ci[k] / C];
+                        bsr.blocks[b * R * C + (i - I * R) * C + ci[k] % C] = val[k];
+                    }
+                }
+
+                for (size_t b = first; b < bsr.blockColIdx.size(); ++b) {
+                    blockPos[bsr.blockColIdx[b]] = unset;
+                }
+                bsr.blockRowPtr[I + 1] = bsr.blockColIdx.size();
+            }
+
+            return bsr;
+        }
+
+        /**
+         * @brief Builds a BSRMatrix holding the nonzero blocks of a dense Matrix.
+         *
+         * @param dense The dense matrix to compress. Its dimensions must be multiples of R and C.
+         * @return The compressed matrix.
+         * @throws std::invalid_argument if the dimensions are not multiples of the block size.
+         */
+        static BSRMatrix fromDense(const Matrix& dense) {
+            return fromCSR(CSRMatrix::fromDense(dense));
+        }
+
+        /**
+         * @brief Returns the dimensions of the matrix.
+         *
+         * @return A std::pair where first is the number of rows and second is the number of columns.
+         */
+        std::pair<size_t, size_t> shape() const { return {nrows, ncols}; }
+
+        /// @brief Number of stored blocks.
+        size_t nnzBlocks() const { return blockColIdx.size(); }
+
+        /**
+         * @brief Sparse matrix-vector product (SpMV).
+         *
+         * @param x A vector of size ncols.
+         * @return The vector y = A * x of size nrows.
+         * @throws std::invalid_argument if the size of @p x does not match the number of columns.
+         */
+        std::vector<double> operator*(const std::vector<double>& x) const {
+            if (x.size() != this->ncols) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: Expected a vector of size " + std::to_string(this->ncols) +
+                    ", given: " + std::to_string(x.size()) + "."
+                );
+            }
+
+            std::vector<double> y(this->nrows, 0.0);
+            const size_t nBlockRows = this->nrows / R;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Sparse, this->blocks.size());
+            matOpsParallel::parallelFor(0, nBlockRows, parallel, [&](size_t I) {
+                double acc[R] = {};
+                for (size_t b = this->blockRowPtr[I]; b < this->blockRowPtr[I + 1]; ++b) {
+                    blockGemv(&this->blocks[b * R * C], &x[this->blockColIdx[b] * C], acc);
+                }
+                for (size_t r = 0; r < R; ++r) {
+                    y[I * R + r] = acc[r];
+                }
+            });
+
+            return y;
+        }
+
+        /**
+         * @brief Sparse times dense matrix product (SpMM).
+         *
+         * @param other A dense Matrix with ncols rows.
+         * @return The dense product A * other.
+         * @throws std::invalid_argument if the inner dimensions do not match.
+         */
+        Matrix operator*(const Matrix& other) const {
+            if (this->ncols != other.nrows) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: For matrices (m x n) and (p x r), n must be equal to p. "
+                    "Given: (" + std::to_string(this->nrows) + "x" + std::to_string(this->ncols) +
+                    ") and (" + std::to_string(other.nrows) + "x" + std::to_string(other.ncols) + ")."
+                );
+            }
+
+            const size_t k = other.ncols;
+            const size_t nBlockRows = this->nrows / R;
+            std::vector<std::vector<double>> res(this->nrows, std::vector<double>(k, 0.0));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Sparse, this->blocks.size() * k);
+            matOpsParallel::parallelFor(0, nBlockRows, parallel, [&](size_t I) {
+                double* Y[R];
+                for (size_t r = 0; r < R; ++r) {
+                    Y[r] = res[I * R + r].data();
+                }
+
+                for (size_t b = this->blockRowPtr[I]; b < this->blockRowPtr[I + 1]; ++b) {
+                    const double* X[C];
+                    for (size_t c = 0; c < C; ++c) {
+                        X[c] = other.container[this->blockColIdx[b] * C + c].data();
+                    }
+                    blockGemm(&this->blocks[b * R * C], X, Y, k);
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
+
+        /**
+         * @brief Transposed sparse matrix-vector product.
+         *
+         * @param x A vector of size nrows.
+         * @return The vector y = A^T * x of size ncols.
+         * @throws std::invalid_argument if the size of @p x does not match the number of rows.
+         */
+        std::vector<double> transposeMultiply(const std::vector<double>& x) const {
+            if (x.size() != this->nrows) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: Expected a vector of size " + std::to_string(this->nrows) +
+                    ", given: " + std::to_string(x.size()) + "."
+                );
+            }
+
+            std::vector<double> y(this->ncols, 0.0);
+            const size_t n = this->ncols;
+            const size_t nBlockRows = this->nrows / R;
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Sparse, this->blocks.size());
+
+            // Different block rows scatter into the same outputs, so every slab of block
+            // rows accumulates into a private copy; the copies are summed in slab order.
+            // Deterministic runs use a fixed slab count, so the summation order does not
+            // depend on the thread count.
+            const size_t deterministicSlabs = 8;
+            const size_t slabs = matOpsParallel::isDeterministic()
+                ? std::min(deterministicSlabs, std::max<size_t>(nBlockRows, 1))
+                : parallel ? std::min(matOpsParallel::getNumThreads(), std::max<size_t>(nBlockRows, 1)) : 1;
+            std::vector<std::vector<double>> partial(slabs - 1, std::vector<double>(n, 0.0));
+
+            matOpsParallel::parallelFor(0, slabs, parallel, [&](size_t s) {
+                double* yp = s == 0 ? y.data() : partial[s - 1].data();
+
+                for (size_t I = nBlockRows * s / slabs; I < nBlockRows * (s + 1) / slabs; ++I) {
+                    for (size_t b = this->blockRowPtr[I]; b < this->blockRowPtr[I + 1]; ++b) {
+                        blockGemvT(&this->blocks[b * R * C], &x[I * R], yp + this->blockColIdx[b] * C);
+                    }
+                }
+            });
+
+            for (const std::vector<double>& p : partial) {
+                #pragma omp simd
+                for (size_t j = 0; j < n; ++j) {
+                    y[j] += p[j];
+                }
+            }
+
+            return y;
+        }
+
+        /**
+         * @brief Transposed sparse times dense matrix product.
+         *
+         * @param other A dense Matrix with nrows rows.
+         * @return The dense product A^T * other.
+         * @throws std::invalid_argument if the row counts do not match.
+         */
+        Matrix transposeMultiply(const Matrix& other) const {
+            if (this->nrows != other.nrows) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: For A^T * B, A and B must have the same number of rows. "
+                    "Given: (" + std::to_string(this->nrows) + "x" + std::to_string(this->ncols) +
+                    ") and (" + std::to_string(other.nrows) + "x" + std::to_string(other.ncols) + ")."
+                );
+            }
+
+            const size_t k = other.ncols;
+            const size_t nBlockRows = this->nrows / R;
+            std::vector<std::vector<double>> res(this->ncols, std::vector<double>(k, 0.0));
+
+            // Block rows of A scatter into overlapping rows of the result, so the work
+            // is split across column tiles of the result instead.
+            const size_t tile = 64;
+            const size_t nTiles = (k + tile - 1) / tile;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Sparse, this->blocks.size() * k);
+            matOpsParallel::parallelFor(0, nTiles, parallel, [&](size_t t) {
+                const size_t j0 = t * tile;
+                const size_t width = std::min(tile, k - j0);
+
+                for (size_t I = 0; I < nBlockRows; ++I) {
+                    const double* X[R];
+                    for (size_t r = 0; r < R; ++r) {
+                        X[r] = other.container[I * R + r].data() + j0;
+                    }
+
+                    for (size_t b = this->blockRowPtr[I]; b < this->blockRowPtr[I + 1]; ++b) {
+                        double* Y[C];
+                        for (size_t c = 0; c < C; ++c) {
+                            Y[c] = res[this->blockColIdx[b] * C + c].data() + j0;
+                        }
+                        blockGemmT(&this->blocks[b * R * C], X, Y, width);
+                    }
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
+
+        /**
+         * @brief Expands the matrix into a dense Matrix.
+         *
+         * @return A dense Matrix with the same shape and entries.
+         */
+        Matrix toDense() const {
+            std::vector<std::vector<double>> dense = Matrix::allocateRows(this->nrows, this->ncols);
+
+            for (size_t I = 0; I < this->nrows / R; ++I) {
+                for (size_t b = this->blockRowPtr[I]; b < this->blockRowPtr[I + 1]; ++b) {
+                    for (size_t r = 0; r < R; ++r) {
+                        for (size_t c = 0; c < C; ++c) {
+                            dense[I * R + r][this->blockColIdx[b] * C + c] = this->blocks[b * R * C + r * C + c];
+                        }
+                    }
+                }
+            }
+
+            return Matrix(std::move(dense), Matrix::InternalTag{});
+        }
+};
+
+/**
+ * @class SparseCholesky
+ * @brief Supernodal sparse Cholesky factorization P A P^T = L L^T for SPD matrices.
+ *
+ * The solver works in three phases:
+ *  - analyze(): computes a fill-reducing ordering, the elimination tree, the column
+ *    structure of L and its partition into fundamental supernodes (runs of columns
+ *    with nested structure). Depends only on the sparsity pattern.
+ *  - factorize(): multifrontal numeric factorization. Every supernode is assembled
+ *    into a dense frontal matrix, its columns are factored densely and the Schur
+ *    complement passed to the parent is formed with a single dense GEMM call.
+ *  - solve(): forward and backward substitution with the supernodal factor.
+ *
+ * The symbolic analysis is kept, so matrices with the same pattern (e.g. the same
+ * mesh with new coefficients) only pay for factorize().
+ *
+ * The input must store the full symmetric pattern (both triangles); only the
+ * entries that fall in the lower triangle after permutation are read.
+ *
+ * Example Usage:
+ * @code
+ * SparseCholesky chol(K);                   // analyze + factorize
+ * std::vector<double> u = chol.solve(f);
+ *
+ * chol.factorize(K2);                       // same pattern, new values
+ * std::vector<double> u2 = chol.solve(f);
+ * @endcode
+ */
+class SparseCholesky {
+    public:
+        /// @brief Fill-reducing ordering applied before factorization.
+        enum class Ordering {
+            Natural,             ///< Keep the original order.
+            MinimumDegree,       ///< Eliminate the vertex of minimum degree first.
+            ReverseCuthillMcKee  ///< Bandwidth reducing order (see CSRMatrix::reverseCuthillMcKee()).
+        };
+
+    private:
+        size_t n; ///< Dimension of the system.
+        std::vector<size_t> perm;  ///< perm[k] is the original index eliminated at step k.
+        std::vector<size_t> iperm; ///< iperm[i] is the elimination step of original index i.
+
+        std::vector<size_t> patternRowPtr; ///< Row pointers of the analyzed pattern.
+        std::vector<size_t> patternColIdx; ///< Column indices of the analyzed pattern.
+
+        std::vector<size_t> lowerPtr; ///< Column pointers of the lower triangle of P A P^T.
+        std::vector<size_t> lowerRow; ///< Permuted row of every lower entry.
+        std::vector<size_t> lowerSrc; ///< Position of every lower entry in the values of A.
+
+        std::vector<size_t> superStart;  ///< First column of every supernode (size nsuper + 1).
+        std::vector<size_t> superParent; ///< Parent of every supernode in the supernodal tree.
+        std::vector<std::vector<size_t>> superChildren; ///< Children of every supernode.
+        std::vector<std::vector<size_t>> superRows;     ///< Row structure of every supernode.
+
+        std::vector<std::vector<double>> factor; ///< Per supernode, its (rows x width) block of L, row-major.
+
+        bool analyzed;   ///< Whether analyze() has run.
+        bool factorized; ///< Whether factorize() has succeeded.
+
+    public:
+        /**
+         * @brief Computes a minimum degree ordering of a symmetric sparsity pattern.
+         *
+         * Vertices are eliminated one by one, always picking the one with the fewest
+         * neighbours in the current elimination graph (ties broken by index), and the
+         * neighbours of the eliminated vertex are connected into a clique.
+         *
+         * @param A A square matrix whose pattern is treated as symmetric.
+         * @return The permutation: element k is the original index eliminated at step k.
+         * @throws std::invalid_argument if the matrix is not square.
+         */
+        static std::vector<size_t> minimumDegreeOrdering(const CSRMatrix& A) {
+            const size_t dim = A.shape().first;
+            if (dim != A.shape().second) {
+                throw std::invalid_argument("Ordering requires a square matrix");
+            }
+
+            const std::vector<size_t>& rp = A.rowPointers();
+            const std::vector<size_t>& ci = A.colIndices();
+
+            std::vector<std::vector<size_t>> adj(dim);
+            for (size_t i = 0; i < dim; ++i) {
+                for (size_t k = rp[i]; k < rp[i + 1]; ++k) {
+                    if (ci[k] != i) {
+                        adj[i].push_back(ci[k]);
+                        adj[ci[k]].push_back(i);
+                    }
+                }
+            }
+
+            std::set<std::pair<size_t, size_t>> queue; // (degree, vertex)
+            for (size_t i = 0; i < dim; ++i) {
+                std::sort(adj[i].begin(), adj[i].end());
+                adj[i].erase(std::unique(adj[i].begin(), adj[i].end()), adj[i].end());
+                queue.insert({adj[i].size(), i});
+            }
+
+            std::vector<size_t> order;
+            order.reserve(dim);
+            std::vector<size_t> merged;
+
+            while (!queue.empty()) {
+                const size_t v = queue.begin()->second;
+                queue.erase(queue.begin());
+                order.push_back(v);
+
+                const std::vector<size_t> nbrs = std::move(adj[v]);
+                adj[v].clear();
+
+                // Eliminating v turns its neighbourhood into a clique.
+                for (size_t u : nbrs) {
+                    queue.erase({adj[u].size(), u});
+
+                    merged.clear();
+                    std::set_union(adj[u].begin(), adj[u].end(), nbrs.begin(), nbrs.end(), std::back_inserter(merged));
+                    merged.erase(std::remove_if(merged.begin(), merged.end(),
+                                                [u, v](size_t x) { return x == u || x == v; }),
+                                 merged.end());
+                    adj[u].swap(merged);
+
+                    queue.insert({adj[u].size(), u});
+                }
+            }
+
+            return order;
+        }
+
+        /**
+         * @brief Creates an empty solver. Call analyze() and factorize() before solve().
+         */
+        SparseCholesky() : n(0), analyzed(false), factorized(false) {}
+
+        /**
+         * @brief Analyzes and factorizes @p A in one step.
+         *
+         * @param A A symmetric positive definite matrix stored with both triangles.
+         * @param ordering The fill-reducing ordering to use.
+         * @throws std::invalid_argument if the matrix is not square.
+         * @throws std::runtime_error if the matrix is not positive definite.
+         */
+        explicit SparseCholesky(const CSRMatrix& A, Ordering ordering = Ordering::MinimumDegree)
+            : n(0), analyzed(false), factorized(false) {
+            this->analyze(A, ordering);
+            this->factorize(A);
+        }
+
+        /**
+         * @brief Symbolic factorization: ordering, elimination tree and supernodes.
+         *
+         * @param A The matrix whose sparsity pattern is analyzed. Values are ignored.
+         * @param ordering The fill-reducing ordering to use.
+         * @throws std::invalid_argument if the matrix is not square.
+         */
+        void analyze(const CSRMatrix& A, Ordering ordering = Ordering::MinimumDegree) {
+            if (A.shape().first != A.shape().second) {
+                throw std::invalid_argument(
+                    "Cholesky factorization requires a square matrix. Given: " +
+                    std::to_string(A.shape().first) + "x" + std::to_string(A.shape().second)
+                );
+            }
+
+            const size_t none = static_cast<size_t>(-1);
+
+            this->n = A.shape().first;
+            this->analyzed = false;
+            this->factorized = false;
+            this->factor.clear();
+
+            const std::vector<size_t>& rp = A.rowPointers();
+            const std::vector<size_t>& ci = A.colIndices();
+            this->patternRowPtr = rp;
+            this->patternColIdx = ci;
+
+            if (ordering == Ordering::MinimumDegree) {
+                this->perm = minimumDegreeOrdering(A);
+            } else if (ordering == Ordering::ReverseCuthillMcKee) {
+                this->perm = A.reverseCuthillMcKee();
+            } else {
+                this->perm.resize(this->n);
+                std::iota(this->perm.begin(), this->perm.end(), 0);
+            }
+
+            this->iperm.resize(this->n);
+            for (size_t k = 0; k < this->n; ++k) {
+                this->iperm[this->perm[k]] = k;
+            }
+
+            // Lower triangle of P A P^T, grouped by column.
+            this->lowerPtr.assign(this->n + 1, 0);
+            for (size_t i = 0; i < this->n; ++i) {
+                for (size_t k = rp[i]; k < rp[i + 1]; ++k) {
+                    if (this->iperm[i] >= this->iperm[ci[k]]) {
+                        this->lowerPtr[this->iperm[ci[k]] + 1]++;
+                    }
+                }
+            }
+            std::partial_sum(this->lowerPtr.begin(), this->lowerPtr.end(), this->lowerPtr.begin());
+
+            this->lowerRow.resize(this->lowerPtr[this->n]);
+            this->lowerSrc.resize(this->lowerPtr[this->n]);
+            std::vector<size_t> next(this->lowerPtr.begin(), this->lowerPtr.end() - 1);
+            for (size_t i = 0; i < this->n; ++i) {
+                for (size_t k = rp[i]; k < rp[i + 1]; ++k) {
+                    size_t pi = this->iperm[i];
+                    size_t pj = this->iperm[ci[k]];
+                    if (pi >= pj) {
+                        this->lowerRow[next[pj]] = pi;
+                        this->lowerSrc[next[pj]] = k;
+                        next[pj]++;
+                    }
+                }
+            }
+
+            // Same entries grouped by row, as needed by the elimination tree.
+            std::vector<size_t> byRowPtr(this->n + 1, 0);
+            for (size_t e = 0; e < this->lowerRow.size(); ++e) {
+                byRowPtr[this->lowerRow[e] + 1]++;
+            }
+            std::partial_sum(byRowPtr.begin(), byRowPtr.end(), byRowPtr.begin());
+            std::vector<size_t> byRowCol(this->lowerRow.size());
+            next.assign(byRowPtr.begin(), byRowPtr.end() - 1);
+            for (size_t j = 0; j < this->n; ++j) {
+                for (size_t e = this->lowerPtr[j]; e < this->lowerPtr[j + 1]; ++e) {
+                    byRowCol[next[this->lowerRow[e]]++] = j;
+                }
+            }
+
+            // Elimination tree (Liu's algorithm with path compression).
+            std::vector<size_t> parent(this->n, none);
+            std::vector<size_t> ancestor(this->n, none);
+            for (size_t i = 0; i < this->n; ++i) {
+                for (size_t e = byRowPtr[i]; e < byRowPtr[i + 1]; ++e) {
+                    size_t r = byRowCol[e];
+                    while (r != none && r < i) {
+                        size_t nextAncestor = ancestor[r];
+                        ancestor[r] = i;
+                        if (nextAncestor == none) {
+                            parent[r] = i;
+                        }
+                        r = nextAncestor;
+                    }
+                }
+            }
+
+            std::vector<std::vector<size_t>> children(this->n);
+            for (size_t j = 0; j < this->n; ++j) {
+                if (parent[j] != none) {
+                    children[parent[j]].push_back(j);
+                }
+            }
+
+            // Column structures of L and fundamental supernodes. A column's structure is
+            // its own lower entries plus the structures of its children in the tree.
+            std::vector<std::vector<size_t>> colStruct(this->n);
+            std::vector<size_t> mark(this->n, none);
+            std::vector<size_t> superOf(this->n);
+            this->superStart.clear();
+
+            for (size_t j = 0; j < this->n; ++j) {
+                std::vector<size_t> structure(1, j);
+                mark[j] = j;
+
+                for (size_t e = this->lowerPtr[j]; e < this->lowerPtr[j + 1]; ++e) {
+                    size_t i = this->lowerRow[e];
+                    if (mark[i] != j) {
+                        mark[i] = j;
+                        structure.push_back(i);
+                    }
+                }
+
+                for (size_t c : children[j]) {
+                    for (size_t i : colStruct[c]) {
+                        if (i > j && mark[i] != j) {
+                            mark[i] = j;
+                            structure.push_back(i);
+                        }
+                    }
+                }
+                std::sort(structure.begin(), structure.end());
+
+                bool extendsPrevious = j > 0 && parent[j - 1] == j && children[j].size() == 1 &&
+                                       colStruct[j - 1].size() == structure.size() + 1;
+                if (!extendsPrevious) {
+                    this->superStart.push_back(j);
+                }
+                superOf[j] = this->superStart.size() - 1;
+                colStruct[j] = std::move(structure);
+
+                // Only the first column of each supernode keeps its structure.
+                for (size_t c : children[j]) {
+                    if (this->superStart[superOf[c]] != c) {
+                        std::vector<size_t>().swap(colStruct[c]);
+                    }
+                }
+            }
+
+            const size_t nsuper = this->superStart.size();
+            this->superStart.push_back(this->n);
+            this->superParent.assign(nsuper, none);
+            this->superChildren.assign(nsuper, std::vector<size_t>());
+            this->superRows.assign(nsuper, std::vector<size_t>());
+
+            for (size_t s = 0; s < nsuper; ++s) {
+                this->superRows[s] = std::move(colStruct[this->superStart[s]]);
+
+                size_t last = this->superStart[s + 1] - 1;
+                if (parent[last] != none) {
+                    this->superParent[s] = superOf[parent[last]];
+                    this->superChildren[this->superParent[s]].push_back(s);
+                }
+            }
+
+            this->analyzed = true;
+        }
+
+        /**
+         * @brief Numeric factorization of a matrix with the analyzed sparsity pattern.
+         *
+         * @param A A symmetric positive definite matrix with exactly the analyzed pattern.
+         * @throws std::runtime_error if analyze() has not been called or the matrix is
+         *         not positive definite.
+         * @throws std::invalid_argument if the pattern differs from the analyzed one.
+         */
+        void factorize(const CSRMatrix& A) {
+            if (!this->analyzed) {
+                throw std::runtime_error("SparseCholesky::analyze() must be called before factorize()");
+            }
+
+            if (A.rowPointers() != this->patternRowPtr || A.colIndices() != this->patternColIdx) {
+                throw std::invalid_argument("Sparsity pattern differs from the analyzed one");
+            }
+
+            this->factorized = false;
+
+            const double* av = A.nonZeroValues().data();
+            const size_t nsuper = this->superParent.size();
+
+            this->factor.assign(nsuper, std::vector<double>());
+            std::vector<std::vector<double>> updates(nsuper);
+            std::vector<size_t> relMap(this->n);
+
+            for (size_t s = 0; s < nsuper; ++s) {
+                const size_t first = this->superStart[s];
+                const size_t w = this->superStart[s + 1] - first;
+                const std::vector<size_t>& rows = this->superRows[s];
+                const size_t m = rows.size();
+
+                for (size_t a = 0; a < m; ++a) {
+                    relMap[rows[a]] = a;
+                }
+
+                // Assemble the frontal matrix (lower triangle only).
+                std::vector<double> F(m * m, 0.0);
+
+                for (size_t j = first; j < first + w; ++j) {
+                    for (size_t e = this->lowerPtr[j]; e < this->lowerPtr[j + 1]; ++e) {
+                        F[relMap[this->lowerRow[e]] * m + (j - first)] += av[this->lowerSrc[e]];
+                    }
+                }
+
+                for (size_t c : this->superChildren[s]) {
+                    const size_t wc = this->superStart[c + 1] - this->superStart[c];
+                    const std::vector<size_t>& crows = this->superRows[c];
+                    const size_t mu = crows.size() - wc;
+                    const std::vector<double>& U = updates[c];
+
+                    for (size_t a = 0; a < mu; ++a) {
+                        const size_t ra = relMap[crows[wc + a]];
+                        for (size_t b = 0; b <= a; ++b) {
+                            F[ra * m + relMap[crows[wc + b]]] += U[a * mu + b];
+                        }
+                    }
+
+                    std::vector<double>().swap(updates[c]);
+                }
+
+                // Dense factorization of the supernode's columns: L11 and L21 together.
+                for (size_t j = 0; j < w; ++j) {
+                    double* fj = &F[j * m];
+                    double d = fj[j];
+                    for (size_t p = 0; p < j; ++p) {
+                        d -= fj[p] * fj[p];
+                    }
+
+                    if (!(d > 0.0)) {
+                        throw std::runtime_error("Matrix is not positive definite");
+                    }
+
+                    const double ljj = std::sqrt(d);
+                    fj[j] = ljj;
+
+                    const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Factorization, (m - j) * j);
+                    matOpsParallel::parallelFor(j + 1, m, parallel, [&](size_t i) {
+                        double* fi = &F[i * m];
+                        double acc = fi[j];
+
+                        #pragma omp simd reduction(-:acc)
+                        for (size_t p = 0; p < j; ++p) {
+                            acc -= fi[p] * fj[p];
+                        }
+
+                        fi[j] = acc / ljj;
+                    });
+                }
+
+                // Schur complement for the parent: U = F22 - L21 * L21^T.
+                const size_t mu = m - w;
+                if (mu > 0) {
+                    std::vector<double> U(mu * mu, 0.0);
+                    for (size_t a = 0; a < mu; ++a) {
+                        for (size_t b = 0; b <= a; ++b) {
+                            U[a * mu + b] = F[(w + a) * m + w + b];
+                        }
+                    }
+
+                    // Only the lower triangle of U is read: skip the tiles above the diagonal.
+                    const size_t tile = 64;
+                    const size_t nTiles = (mu + tile - 1) / tile;
+                    std::vector<std::pair<size_t, size_t>> tiles;
+                    for (size_t I = 0; I < nTiles; ++I) {
+                        for (size_t J = 0; J <= I; ++J) {
+                            tiles.push_back({I, J});
+                        }
+                    }
+
+                    const double* L21 = &F[w * m];
+                    const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Multiply, mu * mu * w / 2);
+                    matOpsParallel::parallelFor(0, tiles.size(), parallel, [&](size_t t) {
+                        const size_t a0 = tiles[t].first * tile, a1 = std::min(mu, a0 + tile);
+                        const size_t b0 = tiles[t].second * tile, b1 = std::min(mu, b0 + tile);
+                        matOpsDetail::gemmNT(a1 - a0, b1 - b0, w, -1.0, L21 + a0 * m, m, L21 + b0 * m, m,
+                                             &U[a0 * mu + b0], mu);
+                    }, matOpsParallel::Schedule::Dynamic);
+                    updates[s] = std::move(U);
+                }
+
+                std::vector<double>& L = this->factor[s];
+                L.resize(m * w);
+                for (size_t a = 0; a < m; ++a) {
+                    std::copy(&F[a * m], &F[a * m] + w, &L[a * w]);
+                }
+            }
+
+            this->factorized = true;
+        }
+
+        /**
+         * @brief Solves A x = b using the computed factorization.
+         *
+         * @param b The right-hand side, of size n.
+         * @return The solution x.
+         * @throws std::runtime_error if no factorization is available.
+         * @throws std::invalid_argument if the size of @p b does not match.
+         */
+        std::vector<double> solve(const std::vector<double>& b) const {
+            if (!this->factorized) {
+                throw std::runtime_error("SparseCholesky::factorize() must succeed before solve()");
+            }
+
+            if (b.size() != this->n) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: Expected a vector of size " + std::to_string(this->n) +
+                    ", given: " + std::to_string(b.size()) + "."
+                );
+            }
+
+            std::vector<double> y(this->n);
+            for (size_t k = 0; k < this->n; ++k) {
+                y[k] = b[this->perm[k]];
+            }
+
+            const size_t nsuper = this->superParent.size();
+
+            // Forward substitution: L y = P b.
+            for (size_t s = 0; s < nsuper; ++s) {
+                const size_t first = this->superStart[s];
+                const size_t w = this->superStart[s + 1] - first;
+                const std::vector<size_t>& rows = this->superRows[s];
+                const double* L = this->factor[s].data();
+
+                for (size_t j = 0; j < w; ++j) {
+                    double acc = y[first + j];
+                    for (size_t p = 0; p < j; ++p) {
+                        acc -= L[j * w + p] * y[first + p];
+                    }
+                    y[first + j] = acc / L[j * w + j];
+                }
+
+                for (size_t i = w; i < rows.size(); ++i) {
+                    double acc = 0.0;
+                    for (size_t p = 0; p < w; ++p) {
+                        acc += L[i * w + p] * y[first + p];
+                    }
+                    y[rows[i]] -= acc;
+                }
+            }
+
+            // Backward substitution: L^T x = y.
+            for (size_t s = nsuper; s-- > 0;) {
+                const size_t first = this->superStart[s];
+                const size_t w = this->superStart[s + 1] - first;
+                const std::vector<size_t>& rows = this->superRows[s];
+                const double* L = this->factor[s].data();
+
+                for (size_t i = w; i < rows.size(); ++i) {
+                    const double yi = y[rows[i]];
+                    for (size_t p = 0; p < w; ++p) {
+                        y[first + p] -= L[i * w + p] * yi;
+                    }
+                }
+
+                for (size_t j = w; j-- > 0;) {
+                    double acc = y[first + j];
+                    for (size_t p = j + 1; p < w; ++p) {
+                        acc -= L[p * w + j] * y[first + p];
+                    }
+                    y[first + j] = acc / L[j * w + j];
+                }
+            }
+
+            std::vector<double> x(this->n);
+            for (size_t k = 0; k < this->n; ++k) {
+                x[this->perm[k]] = y[k];
+            }
+
+            return x;
+        }
+
+        /**
+         * @brief Solves A X = B for several right-hand sides at once.
+         *
+         * @param B The right-hand sides, one per column, with n rows.
+         * @return The solutions X, with the shape of @p B.
+         * @throws std::runtime_error if no factorization is available.
+         * @throws std::invalid_argument if the number of rows of @p B does not match.
+         */
+        Matrix solve(const Matrix& B) const {
+            if (!this->factorized) {
+                throw std::runtime_error("SparseCholesky::factorize() must succeed before solve()");
+            }
+
+            if (B.nrows != this->n) {
+                throw std::invalid_argument(
+                    "Incorrect dimensions: Expected " + std::to_string(this->n) +
+                    " rows, given: " + std::to_string(B.nrows) + "."
+                );
+            }
+
+            std::vector<std::vector<double>> X(B.nrows, std::vector<double>(B.ncols));
+            std::vector<double> col(B.nrows);
+
+            for (size_t j = 0; j < B.ncols; ++j) {
+                for (size_t i = 0; i < B.nrows; ++i) {
+                    col[i] = B.container[i][j];
+                }
+
+                std::vector<double> x = this->solve(col);
+                for (size_t i = 0; i < B.nrows; ++i) {
+                    X[i][j] = x[i];
+                }
+            }
+
+            return Matrix(std::move(X), Matrix::InternalTag{});
+        }
+
+        /// @brief The fill-reducing permutation: element k is the original index eliminated at step k.
+        const std::vector<size_t>& permutation() const { return perm; }
+
+        /// @brief Number of supernodes found by analyze().
+        size_t supernodeCount() const { return superParent.size(); }
+
+        /**
+         * @brief Number of entries of L (diagonal included) implied by the analysis.
+         */
+        size_t factorNnz() const {
+            size_t total = 0;
+            for (size_t s = 0; s < this->superParent.size(); ++s) {
+                size_t w = this->superStart[s + 1] - this->superStart[s];
+                total += this->superRows[s].size() * w - w * (w - 1) / 2;
+            }
+            return total;
+        }
+};
+
+/**
+ * @class DiagonalMatrix
+ * @brief An (n x n) diagonal matrix stored as its n diagonal entries.
+ *
+ * Products with a dense Matrix scale its rows (D * A) or columns (A * D) in O(n * k)
+ * instead of running a full O(n^3) multiplication.
+ *
+ * Example Usage:
+ * @code
+ * DiagonalMatrix D({2, 3});
+ * Matrix A({{1, 2}, {3, 4}});
+ * Matrix B = D * A; // [[2, 4], [9, 12]]
+ * Matrix C = A * D; // [[2, 6], [6, 12]]
+ * @endcode
+ */
+class DiagonalMatrix {
+    private:
+        std::vector<double> diag; ///< Diagonal entries.
+
+        /* A * D: scales column j of A by diag[j]. */
+        Matrix rightMultiply(const Matrix& A) const {
+            if (A.ncols != this->diag.size()) {
+                throw matOpsDetail::productShapeError(A.nrows, A.ncols, this->diag.size(), this->diag.size());
+            }
+
+            Matrix res = A;
+            const double* d = this->diag.data();
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, A.nrows * A.ncols);
+            matOpsParallel::parallelFor(0, A.nrows, parallel, [&](size_t i) {
+                double* row = res.container[i].data();
+
+                #pragma omp simd
+                for (size_t j = 0; j < A.ncols; ++j) {
+                    row[j] *= d[j];
+                }
+            });
+
+            return res;
+        }
+
+    public:
+        /**
+         * @brief Constructs a diagonal matrix from its diagonal entries.
+         *
+         * @param diag The diagonal entries.
+         * @throws std::invalid_argument if @p diag is empty.
+         */
+        explicit DiagonalMatrix(std::vector<double> diag) : diag(std::move(diag)) {
+            if (this->diag.empty()) {
+                throw std::invalid_argument("Matrix is empty. Expected a non-empty diagonal");
+            }
+        }
+
+        /// @brief Dimension n of the (n x n) matrix.
+        size_t size() const { return diag.size(); }
+
+        /// @brief The diagonal entries.
+        const std::vector<double>& diagonal() const { return diag; }
+
+        /**
+         * @brief D * A: scales row i of @p A by the i-th diagonal entry.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        Matrix operator*(const Matrix& A) const {
+            if (A.nrows != this->diag.size()) {
+                throw matOpsDetail::productShapeError(this->diag.size(), this->diag.size(), A.nrows, A.ncols);
+            }
+
+            Matrix res = A;
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, A.nrows * A.ncols);
+            matOpsParallel::parallelFor(0, A.nrows, parallel, [&](size_t i) {
+                double* row = res.container[i].data();
+                const double d = this->diag[i];
+
+                #pragma omp simd
+                for (size_t j = 0; j < A.ncols; ++j) {
+                    row[j] *= d;
+                }
+            });
+
+            return res;
+        }
+
+        /**
+         * @brief A * D: scales column j of @p A by the j-th diagonal entry.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        friend Matrix operator*(const Matrix& A, const DiagonalMatrix& D) {
+            return D.rightMultiply(A);
+        }
+
+        /**
+         * @brief Product of two diagonal matrices.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        DiagonalMatrix operator*(const DiagonalMatrix& other) const {
+            if (other.diag.size() != this->diag.size()) {
+                throw matOpsDetail::productShapeError(this->size(), this->size(), other.size(), other.size());
+            }
+
+            std::vector<double> prod(this->diag.size());
+            for (size_t i = 0; i < prod.size(); ++i) {
+                prod[i] = this->diag[i] * other.diag[i];
+            }
+
+            return DiagonalMatrix(std::move(prod));
+        }
+
+        /**
+         * @brief Matrix-vector product D * x.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        std::vector<double> operator*(const std::vector<double>& x) const {
+            if (x.size() != this->diag.size()) {
+                throw matOpsDetail::productShapeError(this->size(), this->size(), x.size(), 1);
+            }
+
+            std::vector<double> y(x.size());
+            for (size_t i = 0; i < x.size(); ++i) {
+                y[i] = this->diag[i] * x[i];
+            }
+
+            return y;
+        }
+
+        /**
+         * @brief Solves D X = B by dividing row i of @p B by the i-th diagonal entry.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         * @throws std::runtime_error if a diagonal entry is zero.
+         */
+        Matrix solve(const Matrix& B) const {
+            std::vector<double> inv(this->diag.size());
+            for (size_t i = 0; i < inv.size(); ++i) {
+                if (std::abs(this->diag[i]) < EPS) {
+                    throw std::runtime_error("Singular matrix");
+                }
+                inv[i] = 1.0 / this->diag[i];
+            }
+
+            return DiagonalMatrix(std::move(inv)) * B;
+        }
+
+        /**
+         * @brief Expands the matrix into a dense Matrix.
+         */
+        Matrix toDense() const {
+            Matrix dense = Matrix::constValMatrix(this->diag.size(), this->diag.size(), 0.0);
+            for (size_t i = 0; i < this->diag.size(); ++i) {
+                dense.container[i][i] = this->diag[i];
+            }
+            return dense;
+        }
+};
+
+/**
+ * @class TridiagonalMatrix
+ * @brief An (n x n) tridiagonal matrix stored as three diagonals.
+ *
+ * Products cost O(n * k) for a right-hand side with k columns, and solve() runs the
+ * Thomas algorithm in O(n * k). The Thomas algorithm does not pivot: it is stable for
+ * diagonally dominant or symmetric positive definite matrices, which covers the usual
+ * finite difference and spline systems.
+ *
+ * Example Usage:
+ * @code
+ * // 1D Poisson matrix [-1 2 -1]
+ * TridiagonalMatrix T({-1, -1}, {2, 2, 2}, {-1, -1});
+ * std::vector<double> x = T.solve(std::vector<double>{1, 0, 1}); // x = {1, 1, 1}
+ * @endcode
+ */
+class TridiagonalMatrix {
+    private:
+        std::vector<double> lower; ///< Sub-diagonal, lower[i] = A(i + 1, i).
+        std::vector<double> diag;  ///< Main diagonal, diag[i] = A(i, i).
+        std::vector<double> upper; ///< Super-diagonal, upper[i] = A(i, i + 1).
+
+        /* A * T: C(i, j) = A(i, j - 1) T(j - 1, j) + A(i, j) T(j, j) + A(i, j + 1) T(j + 1, j). */
+        Matrix rightMultiply(const Matrix& A) const {
+            const size_t n = this->diag.size();
+            if (A.ncols != n) {
+                throw matOpsDetail::productShapeError(A.nrows, A.ncols, n, n);
+            }
+
+            std::vector<std::vector<double>> res(A.nrows, std::vector<double>(n));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, A.nrows * n);
+            matOpsParallel::parallelFor(0, A.nrows, parallel, [&](size_t i) {
+                const std::vector<double>& a = A.container[i];
+                std::vector<double>& c = res[i];
+
+                for (size_t j = 0; j < n; ++j) {
+                    double acc = a[j] * this->diag[j];
+                    if (j > 0)     acc += a[j - 1] * this->upper[j - 1];
+                    if (j + 1 < n) acc += a[j + 1] * this->lower[j];
+                    c[j] = acc;
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
+
+    public:
+        /**
+         * @brief Constructs a tridiagonal matrix from its three diagonals.
+         *
+         * @param lower The n - 1 sub-diagonal entries.
+         * @param diag The n diagonal entries.
+         * @param upper The n - 1 super-diagonal entries.
+         * @throws std::invalid_argument if the sizes are inconsistent or @p diag is empty.
+         */
+        TridiagonalMatrix(std::vector<double> lower, std::vector<double> diag, std::vector<double> upper)
+            : lower(std::move(lower)), diag(std::move(diag)), upper(std::move(upper)) {
+            if (this->diag.empty()) {
+                throw std::invalid_argument("Matrix is empty. Expected a non-empty diagonal");
+            }
+            if (this->lower.size() + 1 != this->diag.size() || this->upper.size() + 1 != this->diag.size()) {
+                throw std::invalid_argument("Off-diagonals must have exactly one entry less than the diagonal");
+            }
+        }
+
+        /// @brief Dimension n of the (n x n) matrix.
+        size_t size() const { return diag.size(); }
+
+        /**
+         * @brief T * A for a dense Matrix with n rows.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        Matrix operator*(const Matrix& A) const {
+            const size_t n = this->diag.size();
+            if (A.nrows != n) {
+                throw matOpsDetail::productShapeError(n, n, A.nrows, A.ncols);
+            }
+
+            const size_t k = A.ncols;
+            std::vector<std::vector<double>> res(n, std::vector<double>(k));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, n * k);
+            matOpsParallel::parallelFor(0, n, parallel, [&](size_t i) {
+                const double* a = A.container[i].data();
+                const double* above = i > 0 ? A.container[i - 1].data() : nullptr;
+                const double* below = i + 1 < n ? A.container[i + 1].data() : nullptr;
+                const double d  = this->diag[i];
+                const double lo = i > 0 ? this->lower[i - 1] : 0.0;
+                const double up = i + 1 < n ? this->upper[i] : 0.0;
+                double* c = res[i].data();
+
+                #pragma omp simd
+                for (size_t j = 0; j < k; ++j) {
+                    c[j] = d * a[j];
+                }
+                if (above) {
+                    #pragma omp simd
+                    for (size_t j = 0; j < k; ++j) {
+                        c[j] += lo * above[j];
+                    }
+                }
+                if (below) {
+                    #pragma omp simd
+                    for (size_t j = 0; j < k; ++j) {
+                        c[j] += up * below[j];
+                    }
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
+
+        /**
+         * @brief A * T for a dense Matrix with n columns.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        friend Matrix operator*(const Matrix& A, const TridiagonalMatrix& T) {
+            return T.rightMultiply(A);
+        }
+
+        /**
+         * @brief Matrix-vector product T * x.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        std::vector<double> operator*(const std::vector<double>& x) const {
+            const size_t n = this->diag.size();
+            if (x.size() != n) {
+                throw matOpsDetail::productShapeError(n, n, x.size(), 1);
+            }
+
+            std::vector<double> y(n);
+            for (size_t i = 0; i < n; ++i) {
+                double acc = this->diag[i] * x[i];
+                if (i > 0)     acc += this->lower[i - 1] * x[i - 1];
+                if (i + 1 < n) acc += this->upper[i] * x[i + 1];
+                y[i] = acc;
+            }
+
+            return y;
+        }
+
+        /**
+         * @brief Solves T x = b with the Thomas algorithm.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         * @throws std::runtime_error if a zero pivot is met.
+         */
+        std::vector<double> solve(const std::vector<double>& b) const {
+            const size_t n = this->diag.size();
+            if (b.size() != n) {
+                throw matOpsDetail::productShapeError(n, n, b.size(), 1);
+            }
+
+            std::vector<double> c(n), x(b);
+
+            // Forward sweep: eliminate the sub-diagonal.
+            double pivot = this->diag[0];
+            for (size_t i = 0; i < n; ++i) {
+                if (i > 0) {
+                    pivot = this->diag[i] - this->lower[i - 1] * c[i - 1];
+                    x[i] -= this->lower[i - 1] * x[i - 1];
+                }
+                if (std::abs(pivot) < EPS) {
+                    throw std::runtime_error("Singular matrix");
+                }
+                c[i] = i + 1 < n ? this->upper[i] / pivot : 0.0;
+                x[i] /= pivot;
+            }
+
+            // Back substitution.
+            for (size_t i = n - 1; i-- > 0;) {
+                x[i] -= c[i] * x[i + 1];
+            }
+
+            return x;
+        }
+
+        /**
+         * @brief Solves T X = B for all columns of @p B at once.
+         *
+         * The sweeps run over rows of @p B, so the work on the k right-hand sides is vectorized.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         * @throws std::runtime_error if a zero pivot is met.
+         */
+        Matrix solve(const Matrix& B) const {
+            const size_t n = this->diag.size();
+            if (B.nrows != n) {
+                throw matOpsDetail::productShapeError(n, n, B.nrows, B.ncols);
+            }
+
+            const size_t k = B.ncols;
+            Matrix X = B;
+            std::vector<double> c(n);
+
+            double pivot = this->diag[0];
+            for (size_t i = 0; i < n; ++i) {
+                double* xi = X.container[i].data();
+
+                if (i > 0) {
+                    pivot = this->diag[i] - this->lower[i - 1] * c[i - 1];
+                    const double l = this->lower[i - 1];
+                    const double* xp = X.container[i - 1].data();
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < k; ++j) {
+                        xi[j] -= l * xp[j];
+                    }
+                }
+                if (std::abs(pivot) < EPS) {
+                    throw std::runtime_error("Singular matrix");
+                }
+                c[i] = i + 1 < n ? this->upper[i] / pivot : 0.0;
+
+                const double inv = 1.0 / pivot;
+                #pragma omp simd
+                for (size_t j = 0; j < k; ++j) {
+                    xi[j] *= inv;
+                }
+            }
+
+            for (size_t i = n - 1; i-- > 0;) {
+                double* xi = X.container[i].data();
+                const double* xn = X.container[i + 1].data();
+                const double ci = c[i];
+
+                #pragma omp simd
+                for (size_t j = 0; j < k; ++j) {
+                    xi[j] -= ci * xn[j];
+                }
+            }
+
+            return X;
+        }
+
+        /**
+         * @brief Expands the matrix into a dense Matrix.
+         */
+        Matrix toDense() const {
+            const size_t n = this->diag.size();
+            Matrix dense = Matrix::constValMatrix(n, n, 0.0);
+            for (size_t i = 0; i < n; ++i) {
+                dense.container[i][i] = this->diag[i];
+                if (i > 0)     dense.container[i][i - 1] = this->lower[i - 1];
+                if (i + 1 < n) dense.container[i][i + 1] = this->upper[i];
+            }
+            return dense;
+        }
+};
+
+/**
+ * @class BandedMatrix
+ * @brief An (n x n) matrix with kl sub-diagonals and ku super-diagonals.
+ *
+ * Row i stores the entries of columns [i - kl, i + ku] contiguously (entries falling
+ * outside the matrix are kept as padding), which needs n * (kl + ku + 1) doubles.
+ * Products cost O(n * (kl + ku) * k) for k right-hand sides and solve() runs a banded
+ * LU factorization with partial pivoting in O(n * kl * (kl + ku)).
+ *
+ * Example Usage:
+ * @code
+ * BandedMatrix B = BandedMatrix::fromDense(A, 2, 1); // 2 sub- and 1 super-diagonal
+ * Matrix X = B.solve(R);
+ * @endcode
+ */
+class BandedMatrix {
+    private:
+        size_t n;  ///< Dimension of the matrix.
+        size_t kl; ///< Number of sub-diagonals.
+        size_t ku; ///< Number of super-diagonals.
+        std::vector<double> band; ///< Row-major band storage, entry (i, j) at i * (kl + ku + 1) + j - i + kl.
+
+        size_t width() const { return kl + ku + 1; }
+
+        /* A * B: row i of the result accumulates A(i, r) times row r of the band. */
+        Matrix rightMultiply(const Matrix& A) const {
+            if (A.ncols != this->n) {
+                throw matOpsDetail::productShapeError(A.nrows, A.ncols, this->n, this->n);
+            }
+
+            std::vector<std::vector<double>> res(A.nrows, std::vector<double>(this->n, 0.0));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, A.nrows * this->n);
+            matOpsParallel::parallelFor(0, A.nrows, parallel, [&](size_t i) {
+                const double* a = A.container[i].data();
+                double* c = res[i].data();
+
+                for (size_t r = 0; r < this->n; ++r) {
+                    const double ar = a[r];
+                    const size_t jBegin = r > this->kl ? r - this->kl : 0;
+                    const size_t jEnd   = std::min(this->n, r + this->ku + 1);
+                    const double* br = &this->band[r * this->width() + this->kl - r];
+
+                    #pragma omp simd
+                    for (size_t j = jBegin; j < jEnd; ++j) {
+                        c[j] += ar * br[j];
+                    }
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
+
+    public:
+        /**
+         * @brief Constructs a zero banded matrix.
+         *
+         * @param n Dimension of the matrix.
+         * @param kl Number of sub-diagonals.
+         * @param ku Number of super-diagonals.
+         * @throws std::invalid_argument if @p n is zero or a bandwidth is not smaller than n.
+         */
+        BandedMatrix(size_t n, size_t kl, size_t ku) : n(n), kl(kl), ku(ku) {
+            if (n == 0) {
+                throw std::invalid_argument("Matrix cannot have zero dimensions");
+            }
+            if (kl >= n || ku >= n) {
+                throw std::invalid_argument("Bandwidths must be smaller than the matrix dimension");
+            }
+            this->band.assign(n * (kl + ku + 1), 0.0);
+        }
+
+        /**
+         * @brief Copies the band of a square dense Matrix. Entries outside the band are ignored.
+         *
+         * @throws std::invalid_argument if @p dense is not square or the bandwidths are too large.
+         */
+        static BandedMatrix fromDense(const Matrix& dense, size_t kl, size_t ku) {
+            if (dense.nrows != dense.ncols) {
+                throw std::invalid_argument("Banded matrices must be square");
+            }
+
+            BandedMatrix B(dense.nrows, kl, ku);
+            for (size_t i = 0; i < B.n; ++i) {
+                const size_t jBegin = i > kl ? i - kl : 0;
+                const size_t jEnd   = std::min(B.n, i + ku + 1);
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    B.band[i * B.width() + j - i + kl] = dense.container[i][j];
+                }
+            }
+
+            return B;
+        }
+
+        /// @brief Dimension n of the (n x n) matrix.
+        size_t size() const { return n; }
+
+        /// @brief Number of sub-diagonals.
+        size_t lowerBandwidth() const { return kl; }
+
+        /// @brief Number of super-diagonals.
+        size_t upperBandwidth() const { return ku; }
+
+        /**
+         * @brief Accesses an entry inside the band.
+         *
+         * @throws std::out_of_range if (row, col) is outside the matrix or the band.
+         */
+        double& operator()(size_t row, size_t col) {
+            if (row >= this->n || col >= this->n || col + this->kl < row || col > row + this->ku) {
+                throw std::out_of_range("Index out of bounds");
+            }
+
+            return this->band[row * this->width() + col + this->kl - row];
+        }
+
+        /**
+         * @brief B * A for a dense Matrix with n rows.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        Matrix operator*(const Matrix& A) const {
+            if (A.nrows != this->n) {
+                throw matOpsDetail::productShapeError(this->n, this->n, A.nrows, A.ncols);
+            }
+
+            const size_t k = A.ncols;
+            std::vector<std::vector<double>> res(this->n, std::vector<double>(k, 0.0));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, this->n * k);
+            matOpsParallel::parallelFor(0, this->n, parallel, [&](size_t i) {
+                double* c = res[i].data();
+                const size_t rBegin = i > this->kl ? i - this->kl : 0;
+                const size_t rEnd   = std::min(this->n, i + this->ku + 1);
+
+                for (size_t r = rBegin; r < rEnd; ++r) {
+                    const double a = this->band[i * this->width() + r + this->kl - i];
+                    const double* x = A.container[r].data();
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < k; ++j) {
+                        c[j] += a * x[j];
+                    }
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
+
+        /**
+         * @brief A * B for a dense Matrix with n columns.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        friend Matrix operator*(const Matrix& A, const BandedMatrix& B) {
+            return B.rightMultiply(A);
+        }
+
+        /**
+         * @brief Solves B X = R with banded LU and partial pivoting.
+         *
+         * Row interchanges can push fill up to kl extra super-diagonals, so the factor
+         * is computed in a working band of width 2 * kl + ku + 1, as in LAPACK's gbtrf.
+         *
+         * @param R The right-hand sides, with n rows.
+         * @return The solutions X, with the shape of @p R.
+         * @throws std::invalid_argument if the dimensions do not match.
+         * @throws std::runtime_error if the matrix is singular.
+         */
+        Matrix solve(const Matrix& R) const {
+            if (R.nrows != this->n) {
+                throw matOpsDetail::productShapeError(this->n, this->n, R.nrows, R.ncols);
+            }
+
+            const size_t n = this->n, kl = this->kl, ku = this->ku;
+            const size_t W = 2 * kl + ku + 1;
+            const size_t k = R.ncols;
+
+            // Row at position i holds columns [i - kl, i + kl + ku] at offset j - i + kl.
+            std::vector<double> work(n * W, 0.0);
+            for (size_t i = 0; i < n; ++i) {
+                std::copy(&this->band[i * this->width()], &this->band[i * this->width()] + this->width(), &work[i * W]);
+            }
+
+            Matrix X = R;
+
+            for (size_t c = 0; c < n; ++c) {
+                const size_t last = std::min(n - 1, c + kl);
+                const size_t colEnd = std::min(n - 1, c + kl + ku);
+
+                size_t pivot = c;
+                for (size_t i = c + 1; i <= last; ++i) {
+                    if (std::abs(work[i * W + c + kl - i]) > std::abs(work[pivot * W + c + kl - pivot])) {
+                        pivot = i;
+                    }
+                }
+
+                if (std::abs(work[pivot * W + c + kl - pivot]) < EPS) {
+                    throw std::runtime_error("Singular matrix");
+                }
+
+                if (pivot != c) {
+                    for (size_t j = c; j <= colEnd; ++j) {
+                        std::swap(work[c * W + j + kl - c], work[pivot * W + j + kl - pivot]);
+                    }
+                    std::swap(X.container[c], X.container[pivot]);
+                }
+
+                const double diag = work[c * W + kl];
+                const double* xc = X.container[c].data();
+
+                for (size_t i = c + 1; i <= last; ++i) {
+                    const double m = work[i * W + c + kl - i] / diag;
+                    if (m == 0.0) {
+                        continue;
+                    }
+
+                    for (size_t j = c + 1; j <= colEnd; ++j) {
+                        work[i * W + j + kl - i] -= m * work[c * W + j + kl - c];
+                    }
+
+                    double* xi = X.container[i].data();
+                    #pragma omp simd
+                    for (size_t j = 0; j < k; ++j) {
+                        xi[j] -= m * xc[j];
+                    }
+                }
+            }
+
+            // Back substitution with the upper factor (kl + ku super-diagonals).
+            for (size_t i = n; i-- > 0;) {
+                double* xi = X.container[i].data();
+                const size_t colEnd = std::min(n - 1, i + kl + ku);
+
+                for (size_t j = i + 1; j <= colEnd; ++j) {
+                    const double u = work[i * W + j + kl - i];
+                    const double* xj = X.container[j].data();
+
+                    #pragma omp simd
+                    for (size_t t = 0; t < k; ++t) {
+                        xi[t] -= u * xj[t];
+                    }
+                }
+
+                const double inv = 1.0 / work[i * W + kl];
+                #pragma omp simd
+                for (size_t t = 0; t < k; ++t) {
+                    xi[t] *= inv;
+                }
+            }
+
+            return X;
+        }
+
+        /**
+         * @brief Expands the matrix into a dense Matrix.
+         */
+        Matrix toDense() const {
+            Matrix dense = Matrix::constValMatrix(this->n, this->n, 0.0);
+            for (size_t i = 0; i < this->n; ++i) {
+                const size_t jBegin = i > this->kl ? i - this->kl : 0;
+                const size_t jEnd   = std::min(this->n, i + this->ku + 1);
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    dense.container[i][j] = this->band[i * this->width() + j + this->kl - i];
+                }
+            }
+            return dense;
+        }
+};
 
 /**
- * @class Matrix
- * @brief A simple linear algebra library for matrix operations.
- * @version 0.6.1
- * 
- * This class provides basic matrix operations such as addition, subtraction,
- * multiplication, transposition, determinant calculation, inversion, and row/column insertion.
+ * @class TriangularMatrix
+ * @brief An (n x n) lower or upper triangular matrix in packed storage.
+ *
+ * Only the n * (n + 1) / 2 entries of the triangle are stored, row by row. Products
+ * skip the zero triangle and solve() is a single forward or backward substitution,
+ * O(n^2 * k) for k right-hand sides instead of the O(n^3) of inverse().
  *
  * Example Usage:
  * @code
- * Matrix A({{1, 2}, {3, 4}});
- * Matrix B({{5, 6}, {7, 8}});
- * Matrix C = A + B; // Matrix addition
- * Matrix D = A * B; // Matrix multiplication
- * double detA = A.determinant(); // Determinant calculation
+ * TriangularMatrix L = TriangularMatrix::fromDense(A, Triangle::Lower);
+ * Matrix X = L.solve(B); // forward substitution
  * @endcode
  */
-class Matrix {
+class TriangularMatrix {
     private:
-        std::vector<std::vector<double>> container; ///< 2D vector holding matrix elements.
-        size_t nrows; ///< Number of rows in the matrix.
-        size_t ncols; ///< Number of columns in the matrix.
+        size_t n; ///< Dimension of the matrix.
+        Triangle uplo; ///< Which triangle is stored.
+        std::vector<double> packed; ///< Packed rows of the triangle.
 
-        struct InternalTag {};
+        /* Offset of row i in the packed storage. */
+        size_t rowOffset(size_t i) const {
+            return this->uplo == Triangle::Lower ? i * (i + 1) / 2 : i * (2 * this->n - i + 1) / 2;
+        }
+
+        /* First and one-past-last stored column of row i. */
+        size_t colBegin(size_t i) const { return this->uplo == Triangle::Lower ? 0 : i; }
+        size_t colEnd(size_t i) const { return this->uplo == Triangle::Lower ? i + 1 : this->n; }
+
+        /* A * T: row i of the result accumulates A(i, r) times the stored part of row r. */
+        Matrix rightMultiply(const Matrix& A) const {
+            if (A.ncols != this->n) {
+                throw matOpsDetail::productShapeError(A.nrows, A.ncols, this->n, this->n);
+            }
+
+            std::vector<std::vector<double>> res(A.nrows, std::vector<double>(this->n, 0.0));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, A.nrows * this->n);
+            matOpsParallel::parallelFor(0, A.nrows, parallel, [&](size_t i) {
+                const double* a = A.container[i].data();
+                double* c = res[i].data();
+
+                for (size_t r = 0; r < this->n; ++r) {
+                    const double ar = a[r];
+                    const size_t jBegin = this->colBegin(r), jEnd = this->colEnd(r);
+                    const double* tr = &this->packed[this->rowOffset(r)] - jBegin;
+
+                    #pragma omp simd
+                    for (size_t j = jBegin; j < jEnd; ++j) {
+                        c[j] += ar * tr[j];
+                    }
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
 
+    public:
         /**
-         * @brief Internal constructor for creating a Matrix by moving a pre-validated container.
+         * @brief Constructs a zero triangular matrix.
          *
-         * This constructor is intended for internal use only. It bypasses the usual
-         * validation performed in the public constructor, assuming that the provided
-         * container is already well-formed (i.e., non-empty and with consistent row sizes).
-         * The container is moved into the new Matrix object for efficient transfer of data.
+         * @throws std::invalid_argument if @p n is zero.
+         */
+        TriangularMatrix(size_t n, Triangle uplo) : n(n), uplo(uplo) {
+            if (n == 0) {
+                throw std::invalid_argument("Matrix cannot have zero dimensions");
+            }
+            this->packed.assign(n * (n + 1) / 2, 0.0);
+        }
+
+        /**
+         * @brief Copies one triangle of a square dense Matrix. The other triangle is ignored.
          *
-         * @param container An rvalue reference to a 2D vector of doubles representing the matrix elements.
-         * @param tag A dummy parameter (of type InternalTag) used to differentiate this constructor from the public one.
-         * @throws std::invalid_argument if the container is empty or if it contains no columns.
+         * @throws std::invalid_argument if @p dense is not square.
+         */
+        static TriangularMatrix fromDense(const Matrix& dense, Triangle uplo) {
+            if (dense.nrows != dense.ncols) {
+                throw std::invalid_argument("Triangular matrices must be square");
+            }
+
+            TriangularMatrix T(dense.nrows, uplo);
+            for (size_t i = 0; i < T.n; ++i) {
+                std::copy(dense.container[i].begin() + T.colBegin(i), dense.container[i].begin() + T.colEnd(i),
+                          T.packed.begin() + T.rowOffset(i));
+            }
+
+            return T;
+        }
+
+        /// @brief Dimension n of the (n x n) matrix.
+        size_t size() const { return n; }
+
+        /// @brief Which triangle is stored.
+        Triangle triangle() const { return uplo; }
+
+        /**
+         * @brief Accesses an entry of the stored triangle.
          *
-         * @note This constructor does not perform full validation. It assumes that the input container is valid.
+         * @throws std::out_of_range if (row, col) is outside the matrix or the triangle.
          */
-        Matrix(std::vector<std::vector<double>>&& container, InternalTag)
-            : container(std::move(container)), 
-              nrows(this->container.size()),
-              ncols(this->container.empty() ? 0 : this->container[0].size()) {
+        double& operator()(size_t row, size_t col) {
+            if (row >= this->n || col < this->colBegin(row) || col >= this->colEnd(row)) {
+                throw std::out_of_range("Index out of bounds");
+            }
+
+            return this->packed[this->rowOffset(row) + col - this->colBegin(row)];
+        }
+
+        /**
+         * @brief T * A for a dense Matrix with n rows.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        Matrix operator*(const Matrix& A) const {
+            if (A.nrows != this->n) {
+                throw matOpsDetail::productShapeError(this->n, this->n, A.nrows, A.ncols);
+            }
+
+            const size_t k = A.ncols;
+            std::vector<std::vector<double>> res(this->n, std::vector<double>(k, 0.0));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, this->n * k);
+            matOpsParallel::parallelFor(0, this->n, parallel, [&](size_t i) {
+                double* c = res[i].data();
+                const double* t = &this->packed[this->rowOffset(i)];
+
+                for (size_t r = this->colBegin(i); r < this->colEnd(i); ++r) {
+                    const double a = t[r - this->colBegin(i)];
+                    const double* x = A.container[r].data();
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < k; ++j) {
+                        c[j] += a * x[j];
+                    }
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
+
+        /**
+         * @brief A * T for a dense Matrix with n columns.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
+         */
+        friend Matrix operator*(const Matrix& A, const TriangularMatrix& T) {
+            return T.rightMultiply(A);
+        }
+
+        /**
+         * @brief Solves T X = B by forward (lower) or backward (upper) substitution.
+         *
+         * @param B The right-hand sides, with n rows.
+         * @return The solutions X, with the shape of @p B.
+         * @throws std::invalid_argument if the dimensions do not match.
+         * @throws std::runtime_error if a diagonal entry is zero.
+         */
+        Matrix solve(const Matrix& B) const {
+            if (B.nrows != this->n) {
+                throw matOpsDetail::productShapeError(this->n, this->n, B.nrows, B.ncols);
+            }
+
+            const size_t k = B.ncols;
+            Matrix X = B;
+            const bool lower = this->uplo == Triangle::Lower;
+
+            for (size_t step = 0; step < this->n; ++step) {
+                const size_t i = lower ? step : this->n - 1 - step;
+                const double* t = &this->packed[this->rowOffset(i)] - this->colBegin(i);
+                double* xi = X.container[i].data();
+
+                // Subtract the already solved unknowns (all stored columns except the diagonal).
+                const size_t jBegin = lower ? 0 : i + 1;
+                const size_t jEnd   = lower ? i : this->n;
+                for (size_t j = jBegin; j < jEnd; ++j) {
+                    const double a = t[j];
+                    const double* xj = X.container[j].data();
+
+                    #pragma omp simd
+                    for (size_t c = 0; c < k; ++c) {
+                        xi[c] -= a * xj[c];
+                    }
+                }
+
+                if (std::abs(t[i]) < EPS) {
+                    throw std::runtime_error("Singular matrix");
+                }
+
+                const double inv = 1.0 / t[i];
+                #pragma omp simd
+                for (size_t c = 0; c < k; ++c) {
+                    xi[c] *= inv;
+                }
+            }
+
+            return X;
+        }
+
+        /**
+         * @brief Expands the matrix into a dense Matrix.
+         */
+        Matrix toDense() const {
+            Matrix dense = Matrix::constValMatrix(this->n, this->n, 0.0);
+            for (size_t i = 0; i < this->n; ++i) {
+                std::copy(this->packed.begin() + this->rowOffset(i),
+                          this->packed.begin() + this->rowOffset(i) + (this->colEnd(i) - this->colBegin(i)),
+                          dense.container[i].begin() + this->colBegin(i));
+            }
+            return dense;
+        }
+};
+
+/**
+ * @class SymmetricMatrix
+ * @brief An (n x n) symmetric matrix in packed lower storage.
+ *
+ * Only the lower triangle is stored, row by row (entry (i, j) with j <= i lives at
+ * i * (i + 1) / 2 + j), which halves the memory of a dense Matrix. Entry (i, j)
+ * and entry (j, i) are the same storage location.
+ *
+ * syrk() builds Gram matrices X^T * X computing only this triangle, and symm() /
+ * operator* multiply by a dense Matrix reading the packed triangle directly.
+ *
+ * Example Usage:
+ * @code
+ * Matrix X = ...;                                 // m observations x n features
+ * SymmetricMatrix G = SymmetricMatrix::syrk(X);   // X^T * X, n * (n + 1) / 2 doubles
+ * Matrix Y = G * B;                               // symm
+ * @endcode
+ */
+class SymmetricMatrix {
+    private:
+        size_t n; ///< Dimension of the matrix.
+        std::vector<double> packed; ///< Packed rows of the lower triangle.
+
+        static size_t rowOffset(size_t i) { return i * (i + 1) / 2; }
+
+        /* B * S: row i of the result is accumulated one packed row k of S at a time. */
+        Matrix rightMultiply(const Matrix& B) const {
+            if (B.ncols != this->n) {
+                throw matOpsDetail::productShapeError(B.nrows, B.ncols, this->n, this->n);
+            }
+
+            std::vector<std::vector<double>> res(B.nrows, std::vector<double>(this->n, 0.0));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, B.nrows * this->n);
+            matOpsParallel::parallelFor(0, B.nrows, parallel, [&](size_t i) {
+                const double* b = B.container[i].data();
+                double* c = res[i].data();
+
+                for (size_t k = 0; k < this->n; ++k) {
+                    const double* pk = &this->packed[rowOffset(k)];
+                    const double bk = b[k];
+                    double dot = 0.0;
+
+                    // Lower part of row k: C(i, j) += B(i, k) * S(k, j) for j < k ...
+                    // ... and its mirror: C(i, k) += B(i, j) * S(j, k) for j < k.
+                    #pragma omp simd reduction(+:dot)
+                    for (size_t j = 0; j < k; ++j) {
+                        c[j] += bk * pk[j];
+                        dot  += b[j] * pk[j];
+                    }
+
+                    c[k] += dot + bk * pk[k];
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
+        }
+
+    public:
+        /**
+         * @brief Constructs a zero symmetric matrix.
+         *
+         * @throws std::invalid_argument if @p n is zero.
+         */
+        explicit SymmetricMatrix(size_t n) : n(n) {
+            if (n == 0) {
+                throw std::invalid_argument("Matrix cannot have zero dimensions");
+            }
+            this->packed.assign(n * (n + 1) / 2, 0.0);
+        }
+
+        /**
+         * @brief Builds a symmetric matrix from one triangle of a square dense Matrix.
+         *
+         * @param dense The source matrix. Only the selected triangle is read.
+         * @param uplo Which triangle of @p dense holds the data.
+         * @throws std::invalid_argument if @p dense is not square.
+         */
+        static SymmetricMatrix fromDense(const Matrix& dense, Triangle uplo = Triangle::Lower) {
+            if (dense.nrows != dense.ncols) {
+                throw std::invalid_argument("Symmetric matrices must be square");
+            }
+
+            SymmetricMatrix S(dense.nrows);
+            for (size_t i = 0; i < S.n; ++i) {
+                for (size_t j = 0; j <= i; ++j) {
+                    S.packed[rowOffset(i) + j] = uplo == Triangle::Lower ? dense.container[i][j] : dense.container[j][i];
+                }
+            }
+
+            return S;
+        }
+
+        /**
+         * @brief Symmetric rank-k update: computes the Gram matrix X^T * X.
+         *
+         * Only the lower triangle is computed. The output is split into square tiles
+         * and the tiles on or below the diagonal are distributed over threads; every
+         * tile streams the rows of @p X through a cache resident accumulator.
+         *
+         * With a @p shift, every row of @p X has the shift subtracted as it is streamed
+         * in, giving the centered Gram matrix (X - 1 shift^T)^T (X - 1 shift^T) without
+         * materializing the centered copy.
+         *
+         * @param X An (m x n) Matrix.
+         * @param shift Optional vector of n values subtracted from every row.
+         * @return The (n x n) symmetric product X^T * X.
+         * @throws std::invalid_argument if @p shift is neither empty nor of size n.
+         */
+        static SymmetricMatrix syrk(const Matrix& X, const std::vector<double>& shift = std::vector<double>()) {
+            const size_t m = X.nrows;
+            const size_t n = X.ncols;
+            const size_t tile = 64;
+            const size_t nTiles = (n + tile - 1) / tile;
+
+            if (!shift.empty() && shift.size() != n) {
+                throw std::invalid_argument("Shift must have one value per column");
+            }
+            const std::vector<double> zeros(shift.empty() ? n : 0, 0.0);
+            const double* mu = shift.empty() ? zeros.data() : shift.data();
+
+            SymmetricMatrix S(n);
+
+            // Enumerate the lower triangle of tiles so they can be scheduled as one loop.
+            std::vector<std::pair<size_t, size_t>> tiles;
+            for (size_t I = 0; I < nTiles; ++I) {
+                for (size_t J = 0; J <= I; ++J) {
+                    tiles.push_back({I, J});
+                }
+            }
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Multiply, m * n * n / 2);
+            matOpsParallel::parallelFor(0, tiles.size(), parallel, [&](size_t t) {
+                const size_t i0 = tiles[t].first * tile,  i1 = std::min(n, i0 + tile);
+                const size_t j0 = tiles[t].second * tile, j1 = std::min(n, j0 + tile);
+                const size_t w = j1 - j0;
+
+                std::vector<double> acc((i1 - i0) * w, 0.0);
+
+                for (size_t r = 0; r < m; ++r) {
+                    const double* x = X.container[r].data();
+
+                    for (size_t i = i0; i < i1; ++i) {
+                        const double xi = x[i] - mu[i];
+                        double* a = &acc[(i - i0) * w];
+                        const size_t jEnd = std::min(j1, i + 1);
+
+                        #pragma omp simd
+                        for (size_t j = j0; j < jEnd; ++j) {
+                            a[j - j0] += xi * (x[j] - mu[j]);
+                        }
+                    }
+                }
 
-            if (nrows == 0 || ncols == 0) {
-                throw std::invalid_argument("Matrix is empty. Expected a non-empty container.");
-            }
-            // No validation performed. Assumed well formed matrix.
+                for (size_t i = i0; i < i1; ++i) {
+                    const size_t jEnd = std::min(j1, i + 1);
+                    for (size_t j = j0; j < jEnd; ++j) {
+                        S.packed[rowOffset(i) + j] = acc[(i - i0) * w + (j - j0)];
+                    }
+                }
+            }, matOpsParallel::Schedule::Dynamic);
+
+            return S;
         }
 
-    public:
         /**
-         * @brief Returns the dimensions of the matrix.
+         * @brief Symmetric times dense product S * B (BLAS symm, left side).
          *
-         * @return A std::pair where first is the number of rows and second is the number of columns.
+         * @param S The symmetric matrix.
+         * @param B A dense Matrix with n rows.
+         * @return The dense product S * B.
+         * @throws std::invalid_argument if the dimensions do not match.
          */
-        std::pair<size_t, size_t> shape() const { return {nrows, ncols}; }
+        static Matrix symm(const SymmetricMatrix& S, const Matrix& B) {
+            return S * B;
+        }
 
+        /// @brief Dimension n of the (n x n) matrix.
+        size_t size() const { return n; }
 
         /**
-         * @brief Constructs a Matrix from a given 2D vector container.
+         * @brief Accesses entry (row, col); (row, col) and (col, row) share storage.
          *
-         * @param container A 2D vector of doubles representing the matrix.
-         * @throws std::invalid_argument if the container is empty or row sizes are inconsistent.
-         * @note The shape is determined by the size of the container.
+         * @throws std::out_of_range if the indices are out of bounds.
          */
-        Matrix(const std::vector<std::vector<double>>& container) {
-            this->nrows = container.size();
-
-            if ( this->nrows == 0 ) {
-                throw std::invalid_argument("Matrix is empty. Expected `const std::vector<std::vector<double>>& container`");
-            } else {
-                this->ncols = container[0].size();
-            }
-
-            for (const auto& row : container) {
-                if (row.size() != ncols) {
-                    throw std::invalid_argument("Inconsistent row sizes in matrix");
-                }
+        double& operator()(size_t row, size_t col) {
+            if (row >= this->n || col >= this->n) {
+                throw std::out_of_range("Index out of bounds");
             }
 
-            this->container = container;
+            return row >= col ? this->packed[rowOffset(row) + col] : this->packed[rowOffset(col) + row];
         }
 
         /**
-         * @brief Constructs an Identity Matrix of specified dimensions.
-         * @code
-         * Matrix A = Matrix::identity(3);
-         * A = [
-         *      [1, 0, 0]
-         *      [0, 1, 0]
-         *      [0, 0, 1]
-         * ]
-         * @endcode
-         * @param dim Dimensions of matrix (dim x dim).
+         * @brief S * B for a dense Matrix with n rows.
+         *
+         * Rows of the result are computed in parallel. For j <= i the packed row i is
+         * read contiguously; for j > i the mirrored entries S(j, i) are gathered.
+         *
+         * @throws std::invalid_argument if the dimensions do not match.
          */
-        static Matrix identity(size_t dim) {
-            std::vector<std::vector<double>> I(dim, std::vector<double>(dim, 0.0));
-
-            for (size_t i = 0; i < dim; ++i) {
-                I[i][i] = 1.0;
+        Matrix operator*(const Matrix& B) const {
+            if (B.nrows != this->n) {
+                throw matOpsDetail::productShapeError(this->n, this->n, B.nrows, B.ncols);
             }
 
-            return Matrix(std::move(I), InternalTag{});
+            const size_t k = B.ncols;
+            const size_t tile = 64;
+            std::vector<std::vector<double>> res(this->n, std::vector<double>(k, 0.0));
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Structured, this->n * k);
+            matOpsParallel::parallelFor(0, this->n, parallel, [&](size_t i) {
+                double* c = res[i].data();
+
+                // Tiles of columns of B keep the touched part of c in cache.
+                for (size_t c0 = 0; c0 < k; c0 += tile) {
+                    const size_t c1 = std::min(k, c0 + tile);
+
+                    for (size_t j = 0; j < this->n; ++j) {
+                        const double a = j <= i ? this->packed[rowOffset(i) + j] : this->packed[rowOffset(j) + i];
+                        const double* b = B.container[j].data();
+
+                        #pragma omp simd
+                        for (size_t t = c0; t < c1; ++t) {
+                            c[t] += a * b[t];
+                        }
+                    }
+                }
+            });
+
+            return Matrix(std::move(res), Matrix::InternalTag{});
         }
 
         /**
-         * @brief Creates a matrix with constant values.
-         *
-         * Function constructs and returns a Matrix object with the specified
-         * dimensions, initializing every element to the given constant value.
-         * 
-         * Example usage:
-         * @code
-         * // Create a 3x3 matrix filled with 5.0
-         * Matrix A = Matrix::constValMatrix(3, 3, 5.0);
-         *
-         * // Expected Output:
-         * //  5.0  5.0  5.0
-         * //  5.0  5.0  5.0
-         * //  5.0  5.0  5.0
-         * @endcode
+         * @brief B * S for a dense Matrix with n columns.
          *
-         * @param rows The number of rows in the matrix.
-         * @param cols The number of columns in the matrix.
-         * @param val The constant value to initialize each element of the matrix.
-         * @return A Matrix object of dimensions (rows x cols) where each element is set to @p val.
-         * @throws std::invalid_argument if either @p rows or @p cols is zero.
+         * @throws std::invalid_argument if the dimensions do not match.
          */
-        static Matrix constValMatrix(size_t rows, size_t cols, double val) {
-            if (rows == 0 || cols == 0) {
-                throw std::invalid_argument("Matrix cannot have zero dimensions");
-            }
-            
-            return Matrix(std::move(std::vector<std::vector<double>>(rows, std::vector<double>(cols, val))), InternalTag{});
+        friend Matrix operator*(const Matrix& B, const SymmetricMatrix& S) {
+            return S.rightMultiply(B);
         }
 
         /**
-         * @brief Returns a copy of the matrix data.
-         *
-         * This function returns a new 2D vector containing the matrix elements.
-         * Modifications to the returned vector do not affect the original matrix.
-         *
-         * @return A copy of the 2D vector representing the matrix.
+         * @brief Expands the matrix into a dense Matrix holding both triangles.
          */
-        std::vector<std::vector<double>> toVector() const {
-            return this->container;
+        Matrix toDense() const {
+            Matrix dense = Matrix::constValMatrix(this->n, this->n, 0.0);
+            for (size_t i = 0; i < this->n; ++i) {
+                for (size_t j = 0; j <= i; ++j) {
+                    dense.container[i][j] = this->packed[rowOffset(i) + j];
+                    dense.container[j][i] = this->packed[rowOffset(i) + j];
+                }
+            }
+            return dense;
+        }
+};
+
+/**
+ * @class LUDecomposition
+ * @brief LU factorization with partial pivoting, PA = LU, of a square Matrix.
+ *
+ * The factorization is computed once (right-looking, with each elimination step's row
+ * updates split across threads) and can then be reused for any number of solves with
+ * A or A^T, the determinant, and condition number estimates.
+ *
+ * Example Usage:
+ * @code
+ * LUDecomposition lu(A);
+ * Matrix X = lu.solve(B);                 // A X = B
+ * double kappa = lu.conditionEstimate();  // ~ ||A||_1 ||A^-1||_1
+ * @endcode
+ */
+class LUDecomposition {
+    private:
+        size_t n; ///< Dimension of the matrix.
+        std::vector<std::vector<double>> lu; ///< Unit lower L below the diagonal, U on and above it.
+        std::vector<size_t> perm; ///< Row i of LU is row perm[i] of A.
+        int swaps; ///< Number of row interchanges.
+        bool singular; ///< Some pivot was smaller than EPS.
+        double anorm1; ///< ||A||_1, kept for the condition estimate.
+
+        void requireSolvable(const Matrix& B) const {
+            if (B.nrows != this->n) {
+                throw matOpsDetail::productShapeError(this->n, this->n, B.nrows, B.ncols);
+            }
+            if (this->singular) {
+                throw std::runtime_error("Singular matrix");
+            }
+        }
+
+        /* ||x||_1 of a column vector. */
+        static double norm1(const std::vector<std::vector<double>>& x) {
+            double s = 0.0;
+            for (const auto& row : x) {
+                s += std::abs(row[0]);
+            }
+            return s;
         }
 
+    public:
         /**
-         * @brief Adds two matrices element-wise.
+         * @brief Factorizes a square matrix.
          *
-         * @param other The Matrix to add.
-         * @return A new Matrix representing the element-wise sum.
-         * @throws std::invalid_argument if the dimensions of the two matrices do not match.
-         * @note The shape remains unchanged.
+         * A matrix with a pivot smaller than EPS is still factorized (that column is
+         * left uneliminated) and reported by isSingular().
+         *
+         * @param A The matrix to factorize.
+         * @throws std::invalid_argument if @p A is not square.
          */
-        Matrix operator+(const Matrix& other) const {
-            if (this->nrows != other.nrows || this->ncols != other.ncols) {
+        explicit LUDecomposition(const Matrix& A)
+            : n(A.nrows), lu(A.container), perm(A.nrows), swaps(0), singular(false), anorm1(A.norm(Norm::One)) {
+            if (A.nrows != A.ncols) {
                 throw std::invalid_argument(
-                    "Matrix dimensions do not match: (" + 
-                    std::to_string(this->nrows) + "x" + std::to_string(this->ncols) + 
-                    ") vs (" + 
-                    std::to_string(other.nrows) + "x" + std::to_string(other.ncols) + 
-                    ")"
+                    "LU decomposition requires a square matrix. Given: " +
+                    std::to_string(A.nrows) + "x" + std::to_string(A.ncols)
                 );
             }
 
-            Matrix addRes = *this; // addRes = A in A + B
+            std::iota(this->perm.begin(), this->perm.end(), 0);
 
-            const size_t totalElements = this->ncols * this->nrows;
+            for (size_t k = 0; k < this->n; ++k) {
+                size_t pivotRow = k;
+                for (size_t i = k + 1; i < this->n; ++i) {
+                    if (std::abs(this->lu[i][k]) > std::abs(this->lu[pivotRow][k])) {
+                        pivotRow = i;
+                    }
+                }
 
-            #pragma omp parallel for if(totalElements > OPENMP_THRESHOLD) collapse(2)
-            for (size_t i = 0; i < this->nrows; ++i) {
-                for (size_t j = 0; j < this->ncols; ++j) {
-                    addRes.container[i][j] += other.container[i][j];
+                if (pivotRow != k) {
+                    std::swap(this->lu[k], this->lu[pivotRow]);
+                    std::swap(this->perm[k], this->perm[pivotRow]);
+                    this->swaps++;
                 }
-            }
 
-            return addRes;
+                const double pivot = this->lu[k][k];
+                if (std::abs(pivot) < EPS) {
+                    this->singular = true;
+                    continue;
+                }
+
+                const double* uk = this->lu[k].data();
+                const size_t rest = this->n - k - 1;
+
+                const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Factorization, rest * rest);
+                matOpsParallel::parallelFor(k + 1, this->n, parallel, [&](size_t i) {
+                    double* ai = this->lu[i].data();
+                    const double l = ai[k] / pivot;
+                    ai[k] = l;
+
+                    #pragma omp simd
+                    for (size_t j = k + 1; j < this->n; ++j) {
+                        ai[j] -= l * uk[j];
+                    }
+                });
+            }
         }
 
-        /**
-         * @brief Adds a scalar value to each element of the matrix. (MATRIX + K)
-         *
-         * @param scalar A double value to add.
-         * @return A new Matrix with the scalar added to each element.
-         * @note The shape remains unchanged.
-         */
-        Matrix operator+(double scalar) const {
-            Matrix addRes = *this;
-            
-            const size_t totalElements = this->ncols * this->nrows;
+        /// @brief Dimension of the factorized matrix.
+        size_t size() const { return this->n; }
 
-            #pragma omp parallel for if(totalElements > OPENMP_THRESHOLD) collapse(2)
-            for (size_t i = 0; i < this->nrows; ++i) {
-                for (size_t j = 0; j < this->ncols; ++j) {
-                    addRes.container[i][j] += scalar;
-                }
+        /// @brief Whether a pivot smaller than EPS was met.
+        bool isSingular() const { return this->singular; }
+
+        /// @brief The row permutation: row i of P A is row permutation()[i] of A.
+        const std::vector<size_t>& permutation() const { return this->perm; }
+
+        /// @brief The unit lower triangular factor L.
+        Matrix lower() const {
+            std::vector<std::vector<double>> L(this->n, std::vector<double>(this->n, 0.0));
+            for (size_t i = 0; i < this->n; ++i) {
+                std::copy(this->lu[i].begin(), this->lu[i].begin() + i, L[i].begin());
+                L[i][i] = 1.0;
             }
+            return Matrix(std::move(L), Matrix::InternalTag{});
+        }
 
-            return addRes;
+        /// @brief The upper triangular factor U.
+        Matrix upper() const {
+            std::vector<std::vector<double>> U(this->n, std::vector<double>(this->n, 0.0));
+            for (size_t i = 0; i < this->n; ++i) {
+                std::copy(this->lu[i].begin() + i, this->lu[i].end(), U[i].begin() + i);
+            }
+            return Matrix(std::move(U), Matrix::InternalTag{});
         }
 
         /**
-         * @brief Adds a scalar to each element of a matrix. (K + MATRIX)
+         * @brief Determinant of A, the signed product of the pivots.
          *
-         * @param scalar The scalar value.
-         * @param other The Matrix to add the scalar to.
-         * @return A new Matrix with the result.
-         * @note The shape remains unchanged.
+         * @return The determinant, 0 if the matrix is singular.
          */
-        friend Matrix operator+(double scalar, const Matrix& other) {
-            return other + scalar;
+        double determinant() const {
+            if (this->singular) {
+                return 0.0;
+            }
+
+            double det = (this->swaps % 2 == 0) ? 1.0 : -1.0;
+            for (size_t i = 0; i < this->n; ++i) {
+                det *= this->lu[i][i];
+            }
+            return det;
         }
 
         /**
-         * @brief Subtracts one matrix from another element-wise.
+         * @brief Solves A X = B.
          *
-         * @param other The Matrix to subtract.
-         * @return A new Matrix representing the element-wise difference.
-         * @throws std::invalid_argument if the dimensions of the two matrices do not match.
-         * @note The shape remains unchanged.
+         * @param B Right-hand sides, (n x m).
+         * @return X, (n x m).
+         * @throws std::invalid_argument if @p B does not have n rows.
+         * @throws std::runtime_error if the matrix is singular.
          */
-        Matrix operator-(const Matrix& other) const {
-            if (this->nrows != other.nrows || this->ncols != other.ncols) {
-                throw std::invalid_argument(
-                    "Matrix dimensions do not match: (" + 
-                    std::to_string(this->nrows) + "x" + std::to_string(this->ncols) + 
-                    ") vs (" + 
-                    std::to_string(other.nrows) + "x" + std::to_string(other.ncols) + 
-                    ")"
-                );
+        Matrix solve(const Matrix& B) const {
+            this->requireSolvable(B);
+
+            std::vector<std::vector<double>> X(this->n);
+            for (size_t i = 0; i < this->n; ++i) {
+                X[i] = B.container[this->perm[i]];
+            }
+            const size_t m = B.ncols;
+
+            // L Y = P B, then U X = Y, as row operations on X.
+            for (size_t i = 0; i < this->n; ++i) {
+                double* xi = X[i].data();
+                for (size_t k = 0; k < i; ++k) {
+                    const double l = this->lu[i][k];
+                    const double* xk = X[k].data();
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < m; ++j) {
+                        xi[j] -= l * xk[j];
+                    }
+                }
             }
 
-            Matrix subRes = *this; // subRes = A in A - B
+            for (size_t i = this->n; i-- > 0;) {
+                double* xi = X[i].data();
+                for (size_t k = i + 1; k < this->n; ++k) {
+                    const double u = this->lu[i][k];
+                    const double* xk = X[k].data();
 
-            const size_t totalElements = this->ncols * this->nrows;
+                    #pragma omp simd
+                    for (size_t j = 0; j < m; ++j) {
+                        xi[j] -= u * xk[j];
+                    }
+                }
 
-            #pragma omp parallel for if(totalElements > OPENMP_THRESHOLD) collapse(2)
-            for (size_t i = 0; i < this->nrows; ++i) {
-                for (size_t j = 0; j < this->ncols; ++j) {
-                    subRes.container[i][j] -= other.container[i][j];
+                const double inv = 1.0 / this->lu[i][i];
+                #pragma omp simd
+                for (size_t j = 0; j < m; ++j) {
+                    xi[j] *= inv;
                 }
             }
 
-            return subRes;
+            return Matrix(std::move(X), Matrix::InternalTag{});
         }
 
         /**
-         * @brief Subtracts a scalar from each element of the matrix. (MATRIX - K)
+         * @brief Solves A^T X = B with the same factorization.
          *
-         * @param scalar The scalar value to subtract.
-         * @return A new Matrix with each element reduced by the scalar.
-         * @note The shape remains unchanged.
+         * @param B Right-hand sides, (n x m).
+         * @return X, (n x m).
+         * @throws std::invalid_argument if @p B does not have n rows.
+         * @throws std::runtime_error if the matrix is singular.
          */
-        Matrix operator-(double scalar) const {
-            Matrix subRes = *this; // subRes = A in A - B
+        Matrix solveTransposed(const Matrix& B) const {
+            this->requireSolvable(B);
 
-            const size_t totalElements = this->ncols * this->nrows;
+            std::vector<std::vector<double>> W = B.container;
+            const size_t m = B.ncols;
 
-            #pragma omp parallel for if(totalElements > OPENMP_THRESHOLD) collapse(2)
-            for (size_t i = 0; i < this->nrows; ++i) {
-                for (size_t j = 0; j < this->ncols; ++j) {
-                    subRes.container[i][j] -= scalar;
+            // A^T = U^T L^T P: solve U^T Z = B (forward), then L^T W = Z (backward).
+            for (size_t k = 0; k < this->n; ++k) {
+                double* wk = W[k].data();
+                const double inv = 1.0 / this->lu[k][k];
+
+                #pragma omp simd
+                for (size_t j = 0; j < m; ++j) {
+                    wk[j] *= inv;
+                }
+
+                for (size_t i = k + 1; i < this->n; ++i) {
+                    const double u = this->lu[k][i];
+                    double* wi = W[i].data();
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < m; ++j) {
+                        wi[j] -= u * wk[j];
+                    }
                 }
             }
 
-            return subRes;
+            for (size_t k = this->n; k-- > 0;) {
+                const double* wk = W[k].data();
+                for (size_t i = 0; i < k; ++i) {
+                    const double l = this->lu[k][i];
+                    double* wi = W[i].data();
+
+                    #pragma omp simd
+                    for (size_t j = 0; j < m; ++j) {
+                        wi[j] -= l * wk[j];
+                    }
+                }
+            }
+
+            std::vector<std::vector<double>> X(this->n);
+            for (size_t i = 0; i < this->n; ++i) {
+                X[this->perm[i]] = std::move(W[i]);
+            }
+
+            return Matrix(std::move(X), Matrix::InternalTag{});
         }
-        
+
         /**
-         * @brief Subtracts each element of the matrix from a scalar. (K - MATRIX)
+         * @brief Estimates ||A^-1||_1 without forming the inverse.
          *
-         * @param scalar The scalar value.
-         * @param other The Matrix whose elements are subtracted from the scalar.
-         * @return A new Matrix with the result.
-         * @note The shape remains unchanged.
+         * Hager's method as refined by Higham (the estimator behind LAPACK's xLACON):
+         * alternately solves with A and A^T, moving to the unit vector that most
+         * increases ||A^-1 x||_1, for at most 5 iterations, and finally takes the larger
+         * of that and an estimate from an alternating-sign test vector.
+         *
+         * @return A lower bound on ||A^-1||_1, infinity if the matrix is singular.
          */
-        friend Matrix operator-(double scalar, const Matrix& other) {
-            Matrix subRes = other;
+        double inverseNorm1Estimate() const {
+            if (this->singular) {
+                return std::numeric_limits<double>::infinity();
+            }
+            if (this->n == 0) {
+                return 0.0;
+            }
 
-            const size_t totalElements = other.ncols * other.nrows;
+            const double nd = static_cast<double>(this->n);
+            Matrix x = Matrix::constValMatrix(this->n, 1, 1.0 / nd);
+            double estimate = 0.0;
+            size_t lastJ = this->n;
 
-            #pragma omp parallel for if(totalElements > OPENMP_THRESHOLD) collapse(2)
-            for (size_t i = 0; i < subRes.nrows; ++i) {
-                for (size_t j = 0; j < subRes.ncols; ++j) {
-                    subRes.container[i][j] = scalar - subRes.container[i][j];
+            for (int it = 0; it < 5; ++it) {
+                const Matrix y = this->solve(x);
+                const double yNorm = norm1(y.container);
+
+                if (it > 0 && yNorm <= estimate) {
+                    break;
+                }
+                estimate = yNorm;
+
+                Matrix xi = y;
+                for (auto& row : xi.container) {
+                    row[0] = row[0] >= 0 ? 1.0 : -1.0;
+                }
+
+                const Matrix z = this->solveTransposed(xi);
+                size_t j = 0;
+                double zx = 0.0;
+                for (size_t i = 0; i < this->n; ++i) {
+                    if (std::abs(z.container[i][0]) > std::abs(z.container[j][0])) {
+                        j = i;
+                    }
+                    zx += z.container[i][0] * x.container[i][0];
                 }
+
+                if (it > 0 && (std::abs(z.container[j][0]) <= zx || j == lastJ)) {
+                    break;
+                }
+
+                x = Matrix::constValMatrix(this->n, 1, 0.0);
+                x.container[j][0] = 1.0;
+                lastJ = j;
             }
 
-            return subRes;
+            // Higham's safeguard against the cases where the iteration stalls.
+            Matrix b = Matrix::constValMatrix(this->n, 1, 0.0);
+            for (size_t i = 0; i < this->n; ++i) {
+                const double sign = (i % 2 == 0) ? 1.0 : -1.0;
+                b.container[i][0] = sign * (1.0 + (this->n > 1 ? i / (nd - 1) : 0.0));
+            }
+            const double alt = 2.0 * norm1(this->solve(b).container) / (3.0 * nd);
+
+            return std::max(estimate, alt);
         }
 
         /**
-         * @brief Compares two matrices for equality.
+         * @brief Estimates the 1-norm condition number ||A||_1 ||A^-1||_1.
          *
-         * @param other The Matrix to compare with.
-         * @return True if the matrices are equal (within a tolerance), false otherwise.
+         * @return The estimate, infinity if the matrix is singular.
          */
-        bool operator==(const Matrix& other) const {
-            if (this->nrows != other.nrows || this->ncols != other.ncols) {
-                return false;
-            }
+        double conditionEstimate() const {
+            return this->anorm1 * this->inverseNorm1Estimate();
+        }
+};
 
-            for (size_t i = 0; i < this->nrows; ++i) {
-                for (size_t j = 0; j < this->ncols; ++j) {
-                    if ( std::abs(this->container[i][j] - other.container[i][j]) > EPS) {
-                        return false;
-                    }
-                }
-            }
+inline double Matrix::conditionEstimate() const {
+    return LUDecomposition(*this).conditionEstimate();
+}
+
+inline Matrix Matrix::cov(size_t ddof) const {
+    if (this->nrows <= ddof) {
+        throw std::invalid_argument(
+            "Covariance needs more than " + std::to_string(ddof) + " observations. Given: " +
+            std::to_string(this->nrows)
+        );
+    }
+
+    const std::vector<double> mu = this->mean(Axis::Rows).container[0];
+    return SymmetricMatrix::syrk(*this, mu).toDense() / static_cast<double>(this->nrows - ddof);
+}
 
-            return true;
-        }
+inline Matrix Matrix::corr() const {
+    return covarianceToCorrelation(this->cov(1));
+}
+
+/**
+ * @class RunningCovariance
+ * @brief Streaming mean and covariance of data that arrives in row batches.
+ *
+ * Each update() computes the mean and centered Gram matrix of the batch (the same
+ * fused SYRK pass as Matrix::cov()) and merges them into the running totals with the
+ * pairwise update of Chan, Golub and LeVeque, the batched form of Welford's algorithm.
+ * Only O(n^2) state is kept, whatever the number of observations, and the result is
+ * as accurate as a two-pass computation over the whole data set.
+ *
+ * Example Usage:
+ * @code
+ * RunningCovariance rc(features);
+ * while (loadNextBatch(batch)) {    // batch: rows x features
+ *     rc.update(batch);
+ * }
+ * Matrix C = rc.covariance();
+ * @endcode
+ */
+class RunningCovariance {
+    private:
+        size_t nvars; ///< Number of variables (columns).
+        size_t n; ///< Observations seen so far.
+        std::vector<double> mu; ///< Running mean.
+        SymmetricMatrix m2; ///< Running sum of centered outer products.
 
+    public:
         /**
-         * @brief Compares two matrices for inequality.
-         *
-         * This operator checks if two matrices are not equal by comparing their dimensions and
-         * individual elements. Two matrices are considered not equal if:
-         *  - Their dimensions differ, or
-         *  - At least one pair of corresponding elements differs by more than EPS.
+         * @brief Creates an empty accumulator.
          *
-         * @param other The matrix to compare with.
-         * @return true if the matrices differ by at least one element more than EPS; false otherwise.
+         * @param variables Number of variables (columns of every batch).
+         * @throws std::invalid_argument if @p variables is zero.
          */
-        bool operator!=(const Matrix& other) const {
-            return !(*this == other);
-        }
+        explicit RunningCovariance(size_t variables)
+            : nvars(variables), n(0), mu(variables, 0.0), m2(variables) {}
 
         /**
-         * @brief Multiplies two matrices.
+         * @brief Adds a batch of observations.
          *
-         * @param other The Matrix to multiply with.
-         * @return A new Matrix resulting from matrix multiplication.
-         * @throws std::invalid_argument if the number of columns of the first matrix
-         *         does not match the number of rows of the second.
-         * @note The shape of the result is (nrows of first, ncols of second).
+         * @param batch A (rows x variables) Matrix.
+         * @throws std::invalid_argument if the batch has the wrong number of columns.
          */
-        Matrix operator*(const Matrix& other) const {
-            if (this->ncols != other.nrows) {
+        void update(const Matrix& batch) {
+            if (batch.ncols != this->nvars) {
                 throw std::invalid_argument(
-                    "Incorrect dimensions: For matrices (m x n) and (p x r), n must be equal to p. "
-                    "Given: (" + std::to_string(this->nrows) + "x" + std::to_string(this->ncols) + 
-                    ") and (" + std::to_string(other.nrows) + "x" + std::to_string(other.ncols) + ")."
+                    "Batch must have " + std::to_string(this->nvars) + " columns. Given: " +
+                    std::to_string(batch.ncols)
                 );
             }
 
-            std::vector<std::vector<double>> mulResContainer(this->nrows, std::vector<double>(other.ncols, 0.0));
+            const std::vector<double> batchMean = batch.mean(Axis::Rows).container[0];
+            SymmetricMatrix batchM2 = SymmetricMatrix::syrk(batch, batchMean);
 
-            const size_t totalElements = this->ncols * this->nrows;
+            const double na = static_cast<double>(this->n);
+            const double nb = static_cast<double>(batch.nrows);
+            const double weight = na * nb / (na + nb);
 
-            #pragma omp parallel for if(totalElements > OPENMP_THRESHOLD) collapse(2)
-            for (size_t i = 0; i < this->nrows; ++i) {
-                for (size_t k = 0; k < this->ncols; ++k) {
-                    
-                    double Aik = this->container[i][k]; // Cache the A[i][k] element.
+            std::vector<double> delta(this->nvars);
+            for (size_t j = 0; j < this->nvars; ++j) {
+                delta[j] = batchMean[j] - this->mu[j];
+            }
 
-                    for (size_t j = 0; j < other.ncols; ++j) {
-                        mulResContainer[i][j] += Aik * other.container[k][j];
-                    }
+            for (size_t i = 0; i < this->nvars; ++i) {
+                for (size_t j = 0; j <= i; ++j) {
+                    this->m2(i, j) += batchM2(i, j) + weight * delta[i] * delta[j];
                 }
             }
 
-            return Matrix(std::move(mulResContainer), InternalTag{});
+            for (size_t j = 0; j < this->nvars; ++j) {
+                this->mu[j] += delta[j] * nb / (na + nb);
+            }
+            this->n += batch.nrows;
+        }
+
+        /// @brief Number of observations seen so far.
+        size_t count() const { return this->n; }
+
+        /// @brief The running mean as a (1 x variables) Matrix.
+        Matrix mean() const {
+            return Matrix(std::vector<std::vector<double>>(1, this->mu), Matrix::InternalTag{});
         }
 
         /**
-         * @brief Multiplies each element of the matrix by a scalar. (MATRIX * K)
+         * @brief Covariance of everything seen so far.
          *
-         * @param scalar The scalar value.
-         * @return A new Matrix with each element multiplied by the scalar.
-         * @note The shape remains unchanged.
+         * @param ddof Delta degrees of freedom: the divisor is count() - ddof.
+         * @return The (variables x variables) covariance matrix.
+         * @throws std::invalid_argument if count() is not greater than @p ddof.
          */
-        Matrix operator*(double scalar) const {
-            Matrix mulRes = *this;
-            const size_t totalElements = this->ncols * this->nrows;
-
-            #pragma omp parallel for if(totalElements > OPENMP_THRESHOLD) collapse(2)
-            for (size_t i = 0; i < this->nrows; ++i) {
-                for (size_t j = 0; j < this->ncols; ++j) {
-                    mulRes.container[i][j] *= scalar;
-                }
+        Matrix covariance(size_t ddof = 1) const {
+            if (this->n <= ddof) {
+                throw std::invalid_argument(
+                    "Covariance needs more than " + std::to_string(ddof) + " observations. Given: " +
+                    std::to_string(this->n)
+                );
             }
 
-            return mulRes;
+            return this->m2.toDense() / static_cast<double>(this->n - ddof);
         }
 
         /**
-         * @brief Multiplies a scalar by a matrix. (K * MATRIX)
+         * @brief Correlation matrix of everything seen so far.
          *
-         * @param scalar The scalar value.
-         * @param other The Matrix to multiply.
-         * @return A new Matrix with each element multiplied by the scalar.
-         * @note The shape remains unchanged.
+         * @throws std::invalid_argument if fewer than two observations were seen.
          */
-        friend Matrix operator*(double scalar, const Matrix& other) {
-            return other * scalar;
+        Matrix correlation() const {
+            return Matrix::covarianceToCorrelation(this->covariance(1));
         }
+};
 
-        /**
-         * @brief Divides each element of the matrix by a scalar.
-         *
-         * @param scalar The scalar value.
-         * @return A new Matrix with each element divided by the scalar.
-         * @throws std::runtime_error if scalar is zero.
-         * @note The shape remains unchanged.
-         */
-        Matrix operator/(double scalar) const {
-            if (scalar == 0) {
-                throw std::runtime_error("Division by Zero");
-            }
+/**
+ * @class MatrixBatch
+ * @brief A batch of equally sized small matrices, stored batch-interleaved.
+ *
+ * Meant for millions of independent problems of size around 4x4 to 32x32, where a
+ * Matrix per problem costs an allocation and a call per matrix and is far below the
+ * parallel threshold. The matrices are kept in groups of `lanes` consecutive matrices,
+ * with the same element of the matrices of a group stored contiguously:
+ *
+ *     element (i, j) of matrix b  ->  data[(b / lanes) * rows * cols * lanes + (i * cols + j) * lanes + b % lanes]
+ *
+ * Every batched kernel then runs the scalar algorithm once per group, with its
+ * innermost loop over the lanes, so it vectorizes across matrices whatever the matrix
+ * size; groups are processed in parallel. The last group is padded; the padding never
+ * shows in results.
+ *
+ * Example Usage:
+ * @code
+ * MatrixBatch A(100000, 4, 4), B(100000, 4, 1);
+ * ...                                   // fill A(b, i, j) and B(b, i, j)
+ * MatrixBatch X = A.solve(B);           // 100000 solves of A_b x_b = b_b
+ * std::vector<double> dets = A.determinant();
+ * @endcode
+ */
+class MatrixBatch {
+    public:
+        static const size_t lanes = 8; ///< Matrices per interleaved group.
 
-            Matrix devRes = *this;
-            return devRes * (1 / scalar);
-        }
+    private:
+        size_t count; ///< Number of matrices.
+        size_t nrows; ///< Rows of each matrix.
+        size_t ncols; ///< Columns of each matrix.
+        std::vector<double> data; ///< Groups of `lanes` interleaved matrices.
 
-        Matrix operator^(double scalar) const {
+        size_t groups() const { return (this->count + lanes - 1) / lanes; }
 
-            if (scalar == 1) {
-                return *this;
+        /* First element of group g; element (i, j) lane l is at [(i * ncols + j) * lanes + l]. */
+        double* group(size_t g) { return this->data.data() + g * this->nrows * this->ncols * lanes; }
+        const double* group(size_t g) const { return this->data.data() + g * this->nrows * this->ncols * lanes; }
+
+        size_t offset(size_t b, size_t i, size_t j) const {
+            if (b >= this->count || i >= this->nrows || j >= this->ncols) {
+                throw std::out_of_range("Index out of bounds");
             }
+            return (b / lanes) * this->nrows * this->ncols * lanes + (i * this->ncols + j) * lanes + b % lanes;
+        }
 
-            Matrix expRes = *this;
+        friend class BatchedLU;
 
-            for (std::vector<double>& row: expRes.container) {
-                for (double& num: row) {
-                    if (num == 0 && scalar <= 0) {
-                        throw std::runtime_error("Division by zero occured. (0 ^ ( <=0 ))");
-                    }
-                    num = pow(num, scalar);
-                }
+    public:
+        /**
+         * @brief Creates a batch of constant matrices.
+         *
+         * @param count Number of matrices.
+         * @param rows Rows of each matrix.
+         * @param cols Columns of each matrix.
+         * @param value Initial value of every element.
+         * @throws std::invalid_argument if any size is zero.
+         */
+        MatrixBatch(size_t count, size_t rows, size_t cols, double value = 0.0)
+            : count(count), nrows(rows), ncols(cols) {
+            if (count == 0 || rows == 0 || cols == 0) {
+                throw std::invalid_argument("Matrix batch cannot have zero dimensions");
             }
-
-            return expRes;
+            this->data.assign(this->groups() * rows * cols * lanes, value);
         }
 
         /**
-         * @brief Accesses an element of the matrix at a specified row and column.
+         * @brief Packs matrices of the same shape into a batch.
          *
-         * @param row The row index.
-         * @param col The column index.
-         * @return Reference to the value at the specified position. (modifiable)
-         * @throws std::out_of_range if the indices are out of bounds.
+         * @param matrices The matrices, in batch order.
+         * @throws std::invalid_argument if @p matrices is empty or the shapes differ.
          */
-        double& operator()(size_t row, size_t col) {
-            if (row >= this->nrows || col >= this->ncols) {
-                throw std::out_of_range("Index out of bounds");
+        explicit MatrixBatch(const std::vector<Matrix>& matrices)
+            : MatrixBatch(std::max<size_t>(matrices.size(), 1),
+                          matrices.empty() ? 1 : matrices[0].nrows,
+                          matrices.empty() ? 1 : matrices[0].ncols) {
+            if (matrices.empty()) {
+                throw std::invalid_argument("Matrix batch is empty. Expected at least one matrix.");
             }
 
-            return this->container[row][col];
+            for (size_t b = 0; b < this->count; ++b) {
+                this->set(b, matrices[b]);
+            }
+        }
+
+        /// @brief A batch of count (dim x dim) identity matrices.
+        static MatrixBatch identity(size_t count, size_t dim) {
+            MatrixBatch I(count, dim, dim);
+            for (size_t g = 0; g < I.groups(); ++g) {
+                double* ig = I.group(g);
+                for (size_t i = 0; i < dim; ++i) {
+                    std::fill(ig + (i * dim + i) * lanes, ig + (i * dim + i + 1) * lanes, 1.0);
+                }
+            }
+            return I;
         }
 
+        /// @brief Number of matrices in the batch.
+        size_t size() const { return this->count; }
+
+        /// @brief Shape (rows, columns) of each matrix.
+        std::pair<size_t, size_t> shape() const { return {this->nrows, this->ncols}; }
+
         /**
-         * @brief Transposes the matrix.
-         * @return A new matrix of dim (mxn) for a calling matrix of dim (nxm)
-         * Example:
-         * @code
-         * Matrix A({{1, 2}, {3, 4}});
-         * A = A.transpose();
-         * // A becomes:
-         * // [
-         * //   [1, 3],
-         * //   [2, 4]
-         * // ]
-         * @endcode
+         * @brief Element (i, j) of matrix b.
+         * @throws std::out_of_range if an index is out of bounds.
          */
-        Matrix transpose() const {
-
-            std::vector<std::vector<double>> transposeContainer(this->ncols, std::vector<double>(this->nrows));
+        double& operator()(size_t b, size_t i, size_t j) {
+            return this->data[this->offset(b, i, j)];
+        }
 
-            const size_t totalElements = this->ncols * this->nrows;
+        /// @copydoc operator()(size_t, size_t, size_t)
+        double operator()(size_t b, size_t i, size_t j) const {
+            return this->data[this->offset(b, i, j)];
+        }
 
-            #pragma omp parallel for if(totalElements > OPENMP_THRESHOLD) collapse(2)
+        /**
+         * @brief Copy of matrix b.
+         * @throws std::out_of_range if @p b is out of bounds.
+         */
+        Matrix get(size_t b) const {
+            std::vector<std::vector<double>> res(this->nrows, std::vector<double>(this->ncols));
             for (size_t i = 0; i < this->nrows; ++i) {
                 for (size_t j = 0; j < this->ncols; ++j) {
-                    transposeContainer[j][i] = this->container[i][j];
+                    res[i][j] = this->data[this->offset(b, i, j)];
                 }
-            } 
-
-            return Matrix(std::move(transposeContainer), InternalTag{});
+            }
+            return Matrix(std::move(res), Matrix::InternalTag{});
         }
 
         /**
-         * @brief Computes the determinant of the matrix.
-         *
-         * @return The determinant as a double.
-         * @throws std::invalid_argument if the matrix is not square.
-         * @note The shape of the matrix remains unchanged.
+         * @brief Overwrites matrix b.
+         * @throws std::out_of_range if @p b is out of bounds.
+         * @throws std::invalid_argument if @p M does not have the batch's shape.
          */
-        double determinant() const {
-            if (this->nrows != this->ncols) {
+        void set(size_t b, const Matrix& M) {
+            if (M.nrows != this->nrows || M.ncols != this->ncols) {
                 throw std::invalid_argument(
-                    "Determinant is only defined for square matrices. Given: " + 
-                    std::to_string(nrows) + "x" + std::to_string(ncols)
+                    "Matrix shape does not match the batch: (" +
+                    std::to_string(M.nrows) + "x" + std::to_string(M.ncols) + ") vs (" +
+                    std::to_string(this->nrows) + "x" + std::to_string(this->ncols) + ")"
                 );
             }
-            
-            size_t n = this->container.size();
-
-            std::vector<std::vector<double>> LU = this->container;
-            int numRowSwaps = 0;
-        
-            // Perform LU Decomposition with partial pivoting.
-            for (size_t i = 0; i < n; i++) {
-                // Find the pivot in column i.
-                double maxVal = std::abs(LU[i][i]);
-                size_t pivotRow = i;
-                for (size_t k = i + 1; k < n; k++) {
-                    double val = std::abs(LU[k][i]);
-                    if (val > maxVal) {
-                        maxVal = val;
-                        pivotRow = k;
-                    }
-                }
-
-                if (std::abs(maxVal) < EPS) {
-                    return 0.0;
-                }
-
-                if (pivotRow != i) {
-                    std::swap(LU[i], LU[pivotRow]);
-                    numRowSwaps++;
-                }
 
-                for (size_t j = i + 1; j < n; j++) {
-                    LU[j][i] /= LU[i][i];
-                    for (size_t k = i + 1; k < n; k++) {
-                        LU[j][k] -= LU[j][i] * LU[i][k];
-                    }
+            for (size_t i = 0; i < this->nrows; ++i) {
+                for (size_t j = 0; j < this->ncols; ++j) {
+                    this->data[this->offset(b, i, j)] = M.container[i][j];
                 }
             }
+        }
 
-            double det = (numRowSwaps % 2 == 0) ? 1.0 : -1.0;
-            for (size_t i = 0; i < n; i++) {
-                det *= LU[i][i];
+        /// @brief Unpacks the batch into separate matrices.
+        std::vector<Matrix> toMatrices() const {
+            std::vector<Matrix> res;
+            res.reserve(this->count);
+            for (size_t b = 0; b < this->count; ++b) {
+                res.push_back(this->get(b));
             }
-
-            return det;
+            return res;
         }
 
         /**
-         * @brief Computes the inverse of the matrix.
+         * @brief Batched product: matrix b of the result is A_b * B_b.
          *
-         * @return A new Matrix representing the inverse.
-         * @throws std::runtime_error if the matrix is singular (non-invertible).
-         * @note The shape remains unchanged.
+         * @param other A batch of the same size whose matrices have as many rows as these
+         *        have columns.
+         * @return The batch of products.
+         * @throws std::invalid_argument if the batch sizes or the matrix shapes do not match.
          */
-        Matrix inverse() const {
-            if (nrows != ncols) {
+        MatrixBatch operator*(const MatrixBatch& other) const {
+            if (this->count != other.count) {
                 throw std::invalid_argument(
-                    "Matrix must be square to invert. Given: " + 
-                    std::to_string(nrows) + "x" + std::to_string(ncols) + "."
+                    "Batch sizes do not match: " + std::to_string(this->count) + " vs " + std::to_string(other.count)
                 );
             }
+            if (this->ncols != other.nrows) {
+                throw matOpsDetail::productShapeError(this->nrows, this->ncols, other.nrows, other.ncols);
+            }
 
-            size_t n = nrows;
-            
-            // Make copies: one for the working matrix (A) and one for the identity (I)
-            Matrix A(*this);
-            Matrix I = Matrix::identity(n);
-            
-            // Gauss–Jordan elimination.
-            for (size_t i = 0; i < n; ++i) {
-                
-                size_t pivot = i;
-                for (size_t j = i + 1; j < n; ++j) {
-                    if (std::abs(A.container[j][i]) > std::abs(A.container[pivot][i])) {
-                        pivot = j;
+            const size_t m = this->nrows;
+            const size_t k = this->ncols;
+            const size_t n = other.ncols;
+            MatrixBatch res(this->count, m, n);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Multiply, this->count * m * k * n);
+            matOpsParallel::parallelFor(0, this->groups(), parallel, [&](size_t g) {
+                const double* a = this->group(g);
+                const double* b = other.group(g);
+                double* c = res.group(g);
+
+                for (size_t i = 0; i < m; ++i) {
+                    for (size_t p = 0; p < k; ++p) {
+                        const double* aip = a + (i * k + p) * lanes;
+                        for (size_t j = 0; j < n; ++j) {
+                            const double* bpj = b + (p * n + j) * lanes;
+                            double* cij = c + (i * n + j) * lanes;
+
+                            #pragma omp simd
+                            for (size_t l = 0; l < lanes; ++l) {
+                                cij[l] += aip[l] * bpj[l];
+                            }
+                        }
                     }
                 }
-                if (std::abs(A.container[pivot][i]) < EPS) {
-                    throw std::runtime_error("Singular matrix");
-                }
-                
-                
-                std::swap(A.container[i], A.container[pivot]);
-                std::swap(I.container[i], I.container[pivot]);
-                
-                // Normalize the pivot row.
-                double pivotVal = A.container[i][i];
-                for (size_t j = 0; j < n; ++j) {
-                    A.container[i][j] /= pivotVal;
-                    I.container[i][j] /= pivotVal;
+            });
+
+            return res;
+        }
+
+        /**
+         * @brief LU factorization of every matrix; see BatchedLU.
+         * @throws std::invalid_argument if the matrices are not square.
+         */
+        BatchedLU lu() const;
+
+        /**
+         * @brief Solves A_b X_b = B_b for every matrix of the batch.
+         *
+         * @param B Right-hand sides, one (n x m) matrix per matrix of the batch.
+         * @return The batch of solutions.
+         * @throws std::invalid_argument if the shapes or batch sizes do not match.
+         * @throws std::runtime_error if any matrix is singular.
+         */
+        MatrixBatch solve(const MatrixBatch& B) const;
+
+        /**
+         * @brief Inverse of every matrix.
+         * @throws std::invalid_argument if the matrices are not square.
+         * @throws std::runtime_error if any matrix is singular.
+         */
+        MatrixBatch inverse() const;
+
+        /**
+         * @brief Determinant of every matrix (0 for singular ones).
+         * @throws std::invalid_argument if the matrices are not square.
+         */
+        std::vector<double> determinant() const;
+};
+
+/**
+ * @class BatchedLU
+ * @brief LU factorizations with partial pivoting, P_b A_b = L_b U_b, of every matrix of a
+ * MatrixBatch.
+ *
+ * Uses the same algorithm and singularity test as LUDecomposition, run on the
+ * interleaved groups: pivots are chosen and rows swapped per matrix, while the
+ * elimination updates run across the matrices of a group in SIMD.
+ *
+ * Example Usage:
+ * @code
+ * BatchedLU lu = A.lu();
+ * MatrixBatch X = lu.solve(B);
+ * MatrixBatch Y = lu.solve(C);   // reuses the factorizations
+ * @endcode
+ */
+class BatchedLU {
+    private:
+        size_t n; ///< Dimension of the matrices.
+        MatrixBatch lu; ///< Unit lower L below the diagonal, U on and above it.
+        std::vector<double> perm; ///< Per group, row i of LU in lane l is row perm[i * lanes + l] of A (stored as double to blend with the data in inverse()).
+        std::vector<double> sign; ///< Per padded matrix, (-1)^(row interchanges).
+        std::vector<char> singular; ///< Per padded matrix, some pivot was smaller than EPS.
+
+        static const size_t lanes = MatrixBatch::lanes;
+
+        void requireNonsingular() const {
+            for (size_t b = 0; b < this->lu.count; ++b) {
+                if (this->singular[b]) {
+                    throw std::runtime_error("Singular matrix at batch index " + std::to_string(b));
                 }
-                
-                
-                for (size_t k = 0; k < n; ++k) {
+            }
+        }
 
-                    if (k == i) {
-                        continue;
+        /* Overwrites the permuted right-hand sides x (n x m, group g) with the solution of L U X = x. */
+        void substitute(size_t g, double* x, size_t m) const {
+            const size_t n = this->n;
+            const double* a = this->lu.group(g);
+
+            // L Y = P B, then U X = Y, as row operations on X.
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t k = 0; k < i; ++k) {
+                    const double* lik = a + (i * n + k) * lanes;
+                    for (size_t j = 0; j < m; ++j) {
+                        double* xij = x + (i * m + j) * lanes;
+                        const double* xkj = x + (k * m + j) * lanes;
+
+                        #pragma omp simd
+                        for (size_t l = 0; l < lanes; ++l) {
+                            xij[l] -= lik[l] * xkj[l];
+                        }
                     }
+                }
+            }
 
-                    double factor = A.container[k][i];
-                    for (size_t j = 0; j < n; ++j) {
-                        A.container[k][j] -= factor * A.container[i][j];
-                        I.container[k][j] -= factor * I.container[i][j];
+            for (size_t i = n; i-- > 0;) {
+                for (size_t k = i + 1; k < n; ++k) {
+                    const double* uik = a + (i * n + k) * lanes;
+                    for (size_t j = 0; j < m; ++j) {
+                        double* xij = x + (i * m + j) * lanes;
+                        const double* xkj = x + (k * m + j) * lanes;
+
+                        #pragma omp simd
+                        for (size_t l = 0; l < lanes; ++l) {
+                            xij[l] -= uik[l] * xkj[l];
+                        }
+                    }
+                }
+
+                // Padding lanes may divide by zero; they are never read.
+                const double* uii = a + (i * n + i) * lanes;
+                double inv[lanes];
+                #pragma omp simd
+                for (size_t l = 0; l < lanes; ++l) {
+                    inv[l] = 1.0 / uii[l];
+                }
+                for (size_t j = 0; j < m; ++j) {
+                    double* xij = x + (i * m + j) * lanes;
+
+                    #pragma omp simd
+                    for (size_t l = 0; l < lanes; ++l) {
+                        xij[l] *= inv[l];
                     }
                 }
             }
-            
-            return I;
         }
 
+    public:
         /**
-         * @brief Inserts a new row into the matrix.
+         * @brief Factorizes every matrix of a batch of square matrices.
          *
-         * @param row A vector representing the new row.
-         * @param idx The index at which to insert the row.
-         * @return A new Matrix with the row inserted.
-         * @throws std::invalid_argument if the row size is inconsistent or if idx is out of range.
+         * Singular matrices are still factorized and reported by isSingular(b).
+         *
+         * @param A The batch to factorize.
+         * @throws std::invalid_argument if the matrices of @p A are not square.
          */
-        Matrix insertRow(std::vector<double> row, size_t idx) const {
-            if ( this->ncols != row.size() ) {
-                throw std::invalid_argument("Ill formed row. Should be of same size as the rest of the matrix");
+        explicit BatchedLU(const MatrixBatch& A)
+            : n(A.nrows), lu(A), perm(A.groups() * A.nrows * lanes),
+              sign(A.groups() * lanes, 1.0), singular(A.groups() * lanes, 0) {
+            if (A.nrows != A.ncols) {
+                throw std::invalid_argument(
+                    "LU decomposition requires square matrices. Given: " +
+                    std::to_string(A.nrows) + "x" + std::to_string(A.ncols)
+                );
             }
 
-            if (idx > this->nrows) {
-                throw std::invalid_argument("Row index out of range");
-            }
+            const size_t n = this->n;
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Factorization, A.count * n * n);
+            matOpsParallel::parallelFor(0, A.groups(), parallel, [&](size_t g) {
+                double* a = this->lu.group(g);
+                double* p = this->perm.data() + g * n * lanes;
+                double* sg = this->sign.data() + g * lanes;
+                char* sing = this->singular.data() + g * lanes;
 
-            Matrix hstackRes = *this;
-            hstackRes.container.insert(hstackRes.container.begin() + idx, row);
-            hstackRes.nrows += 1;
+                for (size_t i = 0; i < n; ++i) {
+                    std::fill(p + i * lanes, p + (i + 1) * lanes, static_cast<double>(i));
+                }
 
-            return hstackRes;
+                double pivotRow[lanes];
+                double pivot[lanes];
+                double usable[lanes];
+
+                for (size_t k = 0; k < n; ++k) {
+                    // Pivot search; the first largest entry wins, as in LUDecomposition.
+                    #pragma omp simd
+                    for (size_t l = 0; l < lanes; ++l) {
+                        pivotRow[l] = static_cast<double>(k);
+                        pivot[l] = std::abs(a[(k * n + k) * lanes + l]);
+                    }
+                    for (size_t i = k + 1; i < n; ++i) {
+                        const double* aik = a + (i * n + k) * lanes;
+                        const double row = static_cast<double>(i);
+
+                        #pragma omp simd
+                        for (size_t l = 0; l < lanes; ++l) {
+                            const double v = std::abs(aik[l]);
+                            const double r = pivotRow[l];
+                            pivotRow[l] = v > pivot[l] ? row : r;
+                        }
+
+                        #pragma omp simd
+                        for (size_t l = 0; l < lanes; ++l) {
+                            const double v = std::abs(aik[l]);
+                            const double best = pivot[l];
+                            pivot[l] = v > best ? v : best;
+                        }
+                    }
+
+                    // Row interchanges, only in the lanes whose pivot is off the diagonal.
+                    for (size_t l = 0; l < lanes; ++l) {
+                        const size_t r = static_cast<size_t>(pivotRow[l]);
+                        if (r == k) {
+                            continue;
+                        }
+                        for (size_t j = 0; j < n; ++j) {
+                            std::swap(a[(k * n + j) * lanes + l], a[(r * n + j) * lanes + l]);
+                        }
+                        std::swap(p[k * lanes + l], p[r * lanes + l]);
+                        sg[l] = -sg[l];
+                    }
+
+                    // Singular lanes leave the column uneliminated, as in LUDecomposition.
+                    const double* akk = a + (k * n + k) * lanes;
+                    for (size_t l = 0; l < lanes; ++l) {
+                        pivot[l] = akk[l];
+                        const bool small = std::abs(akk[l]) < EPS;
+                        sing[l] |= static_cast<char>(small);
+                        usable[l] = small ? 0.0 : 1.0;
+                    }
+
+                    // Elimination, across lanes. Unusable lanes divide by a nonzero dummy and get a zero factor.
+                    for (size_t i = k + 1; i < n; ++i) {
+                        double* aik = a + (i * n + k) * lanes;
+                        double factor[lanes];
+
+                        #pragma omp simd
+                        for (size_t l = 0; l < lanes; ++l) {
+                            const double x = aik[l];
+                            const double q = x / (pivot[l] + (1.0 - usable[l])) * usable[l];
+                            factor[l] = q;
+                            aik[l] = usable[l] != 0.0 ? q : x;
+                        }
+
+                        for (size_t j = k + 1; j < n; ++j) {
+                            double* aij = a + (i * n + j) * lanes;
+                            const double* akj = a + (k * n + j) * lanes;
+
+                            #pragma omp simd
+                            for (size_t l = 0; l < lanes; ++l) {
+                                aij[l] -= factor[l] * akj[l];
+                            }
+                        }
+                    }
+                }
+            });
         }
 
+        /// @brief Number of factorized matrices.
+        size_t size() const { return this->lu.count; }
+
         /**
-         * @brief Inserts a new row filled with a constant value into the matrix.
-         *
-         * @param rowVal The constant value to fill the new row.
-         * @param idx The index at which to insert the row.
-         * @return A new Matrix with the row inserted.
-         * @throws std::invalid_argument if idx is out of range.
+         * @brief Whether a pivot smaller than EPS was met in matrix b.
+         * @throws std::out_of_range if @p b is out of bounds.
          */
-        Matrix insertRow(double rowVal, size_t idx) const {
-            if (idx > this->nrows) {
-                throw std::invalid_argument("Row index out of range");
+        bool isSingular(size_t b) const {
+            if (b >= this->lu.count) {
+                throw std::out_of_range("Index out of bounds");
             }
-
-            Matrix hstackRes = *this;
-            hstackRes.container.insert(hstackRes.container.begin() + idx, std::vector<double>(this->ncols, rowVal));
-            hstackRes.nrows += 1;
-
-            return hstackRes;
+            return this->singular[b] != 0;
         }
 
         /**
-         * @brief Inserts a new column into the matrix.
+         * @brief Determinant of every matrix, the signed product of its pivots.
          *
-         * @param col A vector representing the new column.
-         * @param idx The index at which to insert the column.
-         * @return A new Matrix with the column inserted.
-         * @throws std::invalid_argument if the column size is inconsistent or if idx is out of range.
+         * @return The determinants in batch order, 0 for singular matrices.
          */
-        Matrix insertCol(std::vector<double> col, size_t idx) const {
-            if (this->nrows != col.size()) {
-                throw std::invalid_argument("Ill formed column. Should be of same size as the rest of the matrix");
-            }
-
-            if (idx > this->ncols) {
-                throw std::invalid_argument("Column index out of range");
-            }
-
-            Matrix vstackRes = *this;
-
-            size_t colIter = 0;
+        std::vector<double> determinant() const {
+            std::vector<double> det(this->lu.groups() * lanes);
+            const size_t n = this->n;
+
+            for (size_t g = 0; g < this->lu.groups(); ++g) {
+                const double* a = this->lu.group(g);
+                double* dg = det.data() + g * lanes;
+                const double* sg = this->sign.data() + g * lanes;
+                const char* sing = this->singular.data() + g * lanes;
+
+                #pragma omp simd
+                for (size_t l = 0; l < lanes; ++l) {
+                    dg[l] = sg[l];
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    const double* aii = a + (i * n + i) * lanes;
 
-            for (auto& row : vstackRes.container) {
-                row.insert(row.begin() + idx, col[colIter]);
-                colIter++;
+                    #pragma omp simd
+                    for (size_t l = 0; l < lanes; ++l) {
+                        dg[l] *= aii[l];
+                    }
+                }
+                for (size_t l = 0; l < lanes; ++l) {
+                    if (sing[l]) {
+                        dg[l] = 0.0;
+                    }
+                }
             }
 
-            vstackRes.ncols += 1;
-
-            return vstackRes;
+            det.resize(this->lu.count);
+            return det;
         }
 
         /**
-         * @brief Inserts a new column filled with a constant value into the matrix.
+         * @brief Solves A_b X_b = B_b for every matrix of the batch.
          *
-         * @param colVal The constant value to fill the new column.
-         * @param idx The index at which to insert the column.
-         * @return A new Matrix with the column inserted.
-         * @throws std::invalid_argument if idx is out of range.
+         * @param B Right-hand sides, one (n x m) matrix per factorized matrix.
+         * @return The batch of solutions.
+         * @throws std::invalid_argument if the shapes or batch sizes do not match.
+         * @throws std::runtime_error if any matrix is singular.
          */
-        Matrix insertCol(double colVal, size_t idx) const {
-            if (idx > this->ncols) {
-                throw std::invalid_argument("Column index out of range");
+        MatrixBatch solve(const MatrixBatch& B) const {
+            if (B.count != this->lu.count) {
+                throw std::invalid_argument(
+                    "Batch sizes do not match: " + std::to_string(this->lu.count) + " vs " + std::to_string(B.count)
+                );
             }
-
-            Matrix vstackRes = *this;
-
-            for (auto& row : vstackRes.container) {
-                row.insert(row.begin() + idx, colVal);
+            if (B.nrows != this->n) {
+                throw matOpsDetail::productShapeError(this->n, this->n, B.nrows, B.ncols);
             }
+            this->requireNonsingular();
+
+            const size_t n = this->n;
+            const size_t m = B.ncols;
+            MatrixBatch X(B.count, n, m);
+
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Factorization, B.count * n * m);
+            matOpsParallel::parallelFor(0, B.groups(), parallel, [&](size_t g) {
+                const double* p = this->perm.data() + g * n * lanes;
+                const double* b = B.group(g);
+                double* x = X.group(g);
+
+                // X = P B, gathering row perm[i] of each lane's right-hand side.
+                for (size_t i = 0; i < n; ++i) {
+                    const double* pi = p + i * lanes;
+                    for (size_t l = 0; l < lanes; ++l) {
+                        const double* br = b + static_cast<size_t>(pi[l]) * m * lanes + l;
+                        double* xi = x + i * m * lanes + l;
+                        for (size_t j = 0; j < m; ++j) {
+                            xi[j * lanes] = br[j * lanes];
+                        }
+                    }
+                }
 
-            vstackRes.ncols += 1;
+                this->substitute(g, x, m);
+            });
 
-            return vstackRes;
+            return X;
         }
 
         /**
-         * @brief Horizontally concatenates two matrices.
-         *
-         * This function creates and returns a new Matrix by appending the columns of the given matrix
-         * to the right of the calling matrix. Both matrices must have the same number of rows.
-         *
-         * @param other The Matrix whose columns will be appended to the calling matrix.
-         * @return A new Matrix representing the horizontal concatenation of the two matrices.
-         * @throws std::invalid_argument if the two matrices do not have the same number of rows.
-         *
-         * @note This implementation reserves the necessary capacity before inserting to minimize reallocations.
+         * @brief Inverse of every matrix.
+         * @throws std::runtime_error if any matrix is singular.
          */
-        Matrix hStack(const Matrix& other) const {
-            if (this->nrows != other.nrows) {
-                throw std::invalid_argument("Horizontal stack requires alignment of no. of rows");
-            }
+        MatrixBatch inverse() const {
+            this->requireNonsingular();
 
-            size_t rowIter = 0;
-            Matrix hStackRes = *this;
+            const size_t n = this->n;
+            MatrixBatch X(this->lu.count, n, n);
 
-            for (auto& rows: other.container) {
-                for (double val: rows) {
-                    hStackRes.container[rowIter].push_back(val);
+            const bool parallel = matOpsParallel::exceedsThreshold(matOpsParallel::Operation::Factorization, this->lu.count * n * n);
+            matOpsParallel::parallelFor(0, this->lu.groups(), parallel, [&](size_t g) {
+                const double* p = this->perm.data() + g * n * lanes;
+                double* x = X.group(g);
+
+                // X = P I: row i has its one in column perm[i].
+                for (size_t i = 0; i < n; ++i) {
+                    const double* pi = p + i * lanes;
+                    for (size_t j = 0; j < n; ++j) {
+                        const double col = static_cast<double>(j);
+                        double* xij = x + (i * n + j) * lanes;
+
+                        #pragma omp simd
+                        for (size_t l = 0; l < lanes; ++l) {
+                            xij[l] = pi[l] == col ? 1.0 : 0.0;
+                        }
+                    }
                 }
-                rowIter++;
-            }
 
-            hStackRes.ncols += other.ncols;
+                this->substitute(g, x, n);
+            });
 
-            return hStackRes;
+            return X;
         }
+};
 
-        /**
-         * @brief Vertically concatenates two matrices.
-         *
-         * This function creates and returns a new Matrix by appending the rows of the given matrix
-         * below the rows of the calling matrix. Both matrices must have the same number of columns.
-         *
-         * @param other The Matrix whose rows will be appended to the calling matrix.
-         * @return A new Matrix representing the vertical concatenation of the two matrices.
-         * @throws std::invalid_argument if the two matrices do not have the same number of columns.
-         *
-         * @note The function appends each row of the second matrix to the container of the first,
-         *       and updates the total row count accordingly.
-         */
-        Matrix vStack(const Matrix& other) const {
-            if (this->ncols != other.ncols) {
-                throw std::invalid_argument("Vertical stack requires alignment of no. of cols");
+inline BatchedLU MatrixBatch::lu() const {
+    return BatchedLU(*this);
+}
+
+inline MatrixBatch MatrixBatch::solve(const MatrixBatch& B) const {
+    return BatchedLU(*this).solve(B);
+}
+
+inline MatrixBatch MatrixBatch::inverse() const {
+    return BatchedLU(*this).inverse();
+}
+
+inline std::vector<double> MatrixBatch::determinant() const {
+    return BatchedLU(*this).determinant();
+}
+
+namespace matOpsParallel {
+
+    namespace detail {
+
+        /* Best of a few runs in seconds, each repeated enough times to be measurable. */
+        inline double bestTime(const std::function<void()>& run) {
+            typedef std::chrono::steady_clock Clock;
+
+            Clock::time_point start = Clock::now();
+            run();
+            const double once = std::chrono::duration<double>(Clock::now() - start).count();
+            const int repeat = once > 2e-4 ? 1 : static_cast<int>(2e-4 / std::max(once, 1e-8)) + 1;
+
+            double best = std::numeric_limits<double>::infinity();
+            for (int trial = 0; trial < 3; ++trial) {
+                start = Clock::now();
+                for (int r = 0; r < repeat; ++r) {
+                    run();
+                }
+                best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count() / repeat);
             }
+            return best;
+        }
 
-            Matrix vStackRes = *this;
+        /*
+         * Times the kernel made by make(size) serially and in parallel for increasing sizes.
+         * make returns the work of the kernel (as counted by the loops of class op) and the
+         * kernel itself. Parallel counts as faster only below 0.8 x the serial time, and
+         * only after winning at two consecutive sizes. Returns the largest work measured
+         * before that streak, or just below the smallest work if the streak starts there.
+         */
+        template <typename Make>
+        size_t breakEven(Operation op, const std::vector<size_t>& sizes, Make make) {
+            const double margin = 0.8;
+            size_t threshold = 0;
+            size_t wins = 0;
+
+            for (size_t s = 0; s < sizes.size(); ++s) {
+                const std::pair<size_t, std::function<void()>> job = make(sizes[s]);
+                if (s == 0) {
+                    threshold = job.first - 1;
+                }
 
-            for (auto& row: other.container) {
-                vStackRes.container.push_back(row);
+                // Serial is timed on both sides of the parallel run, so warm-up favours neither.
+                setThreshold(op, std::numeric_limits<size_t>::max());
+                double serial = bestTime(job.second);
+                setThreshold(op, 0);
+                const double parallel = bestTime(job.second);
+                setThreshold(op, std::numeric_limits<size_t>::max());
+                serial = std::min(serial, bestTime(job.second));
+
+                if (parallel < margin * serial) {
+                    if (++wins == 2) {
+                        return threshold;
+                    }
+                } else {
+                    wins = 0;
+                    threshold = job.first;
+                }
             }
 
-            vStackRes.nrows += other.nrows;
+            return std::numeric_limits<size_t>::max();
+        }
 
-            return vStackRes;
+    }
+
+    inline void calibrate() {
+        const size_t never = std::numeric_limits<size_t>::max();
+
+        if (getNumThreads() <= 1) {
+            for (size_t op = 0; op < detail::operationCount; ++op) {
+                setThreshold(static_cast<Operation>(op), never);
+            }
+            return;
         }
 
-        /**
-         * @brief Shuffles the rows of the matrix using a random seed.
-         *
-         * This function uses a random seed generated by std::random_device to
-         * initialize the random number generator, ensuring that the shuffle
-         * is non-deterministic.
-         */
-        void shuffleRows() {
+        typedef std::pair<size_t, std::function<void()>> Job;
+        const std::vector<size_t> square = { 16, 32, 64, 128, 256, 512, 1024 };
+        const std::vector<size_t> cubic = { 8, 16, 32, 64, 128, 256 };
+        const std::vector<size_t> sparseRows = { 256, 1024, 4096, 16384, 65536, 131072 };
+
+        // A well-conditioned test matrix, so that the factorization kernel never hits a zero pivot.
+        auto testMatrix = [](size_t n) {
+            return Matrix::constValMatrix(n, n, 1.0) + Matrix::identity(n) * static_cast<double>(n);
+        };
+
+        size_t found[detail::operationCount];
+
+        found[static_cast<size_t>(Operation::Elementwise)] = detail::breakEven(Operation::Elementwise, square, [&](size_t n) {
+            std::shared_ptr<Matrix> A = std::make_shared<Matrix>(testMatrix(n));
+            return Job(n * n, [A] { Matrix C = *A + *A; (void)C; });
+        });
+
+        found[static_cast<size_t>(Operation::Transpose)] = detail::breakEven(Operation::Transpose, square, [&](size_t n) {
+            std::shared_ptr<Matrix> A = std::make_shared<Matrix>(testMatrix(n));
+            return Job(n * n, [A] { Matrix C = A->transpose(); (void)C; });
+        });
+
+        found[static_cast<size_t>(Operation::Reduction)] = detail::breakEven(Operation::Reduction, square, [&](size_t n) {
+            std::shared_ptr<Matrix> A = std::make_shared<Matrix>(testMatrix(n));
+            return Job(n * n, [A] { Matrix C = A->sum(Axis::Rows); (void)C; });
+        });
+
+        found[static_cast<size_t>(Operation::Multiply)] = detail::breakEven(Operation::Multiply, cubic, [&](size_t n) {
+            std::shared_ptr<Matrix> A = std::make_shared<Matrix>(testMatrix(n));
+            return Job(n * n * n, [A] { Matrix C = *A * *A; (void)C; });
+        });
+
+        found[static_cast<size_t>(Operation::Factorization)] = detail::breakEven(Operation::Factorization, cubic, [&](size_t n) {
+            std::shared_ptr<Matrix> A = std::make_shared<Matrix>(testMatrix(n));
+            return Job(n * n, [A] { LUDecomposition lu(*A); (void)lu; });
+        });
+
+        found[static_cast<size_t>(Operation::Sparse)] = detail::breakEven(Operation::Sparse, sparseRows, [&](size_t n) {
+            // Five-point stencil rows.
+            std::vector<size_t> rowIdx, colIdx;
+            std::vector<double> values;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j : {i, i + 1, i + 2, i + n / 2, i + n - 1}) {
+                    rowIdx.push_back(i);
+                    colIdx.push_back(j % n);
+                    values.push_back(1.0);
+                }
+            }
 
-            std::random_device rd;
-            std::mt19937 gen(rd());
+            std::shared_ptr<CSRMatrix> S = std::make_shared<CSRMatrix>(CSRMatrix::fromTriplets(n, n, rowIdx, colIdx, values));
+            std::shared_ptr<std::vector<double>> x = std::make_shared<std::vector<double>>(n, 1.0);
+            return Job(values.size(), [S, x] { std::vector<double> y = *S * *x; (void)y; });
+        });
 
-            std::shuffle(this->container.begin(), this->container.end(), gen);
+        found[static_cast<size_t>(Operation::Structured)] = detail::breakEven(Operation::Structured, square, [&](size_t n) {
+            std::shared_ptr<Matrix> A = std::make_shared<Matrix>(testMatrix(n));
+            std::shared_ptr<DiagonalMatrix> D = std::make_shared<DiagonalMatrix>(std::vector<double>(n, 2.0));
+            return Job(n * n, [A, D] { Matrix C = *D * *A; (void)C; });
+        });
+
+        for (size_t op = 0; op < detail::operationCount; ++op) {
+            setThreshold(static_cast<Operation>(op), found[op]);
         }
+    }
 
-        /**
-         * @brief Shuffles the rows of the matrix using a specified seed.
-         *
-         * This function initializes the random number generator with the provided
-         * seed (random_state), allowing for reproducible shuffling.
-         *
-         * @param random_state The seed value used to initialize the random number generator.
-         */
-        void shuffleRows(size_t random_state) {
+}
 
-            std::mt19937 gen(random_state);
+namespace matOpsGemm {
 
-            std::shuffle(this->container.begin(), this->container.end(), gen);
+    inline Blocking tune(ShapeClass shape) {
+        // Representative operands of the class, (m x k) * (k x n).
+        size_t m = 256, k = 256, n = 256;
+        switch (shape) {
+            case ShapeClass::Square: break;
+            case ShapeClass::Tall: m = 1024; k = 128; n = 128; break;
+            case ShapeClass::Wide: m = 128; k = 128; n = 1024; break;
+            case ShapeClass::Deep: m = 128; k = 1024; n = 128; break;
         }
 
-        /**
-         * @brief Extracts a submatrix from the current Matrix.
-         *
-         * Given a pair of row indices and a pair of column indices, this function creates
-         * and returns a new Matrix containing the submatrix defined by the specified ranges [start, end).
+        const Matrix A = Matrix::constValMatrix(m, k, 0.5);
+        const Matrix B = Matrix::constValMatrix(k, n, 2.0);
 
-         * @param rowSlice A std::pair<size_t, size_t> representing the start and end row indices.
-         * @param colSlice A std::pair<size_t, size_t> representing the start and end column indices.
-         * @return A new Matrix object containing the extracted submatrix.
-         * @throws std::out_of_range If any indices are out of bounds or if the slice ranges are invalid.
-         */
-        Matrix extractMatrix(std::pair<size_t, size_t> rowSlice, std::pair<size_t, size_t> colSlice) const {
-            /* Convert [start, end) to container indices */
-            size_t rowStart = rowSlice.first;       
-            size_t rowEnd   = rowSlice.second - 1;
+        const size_t rowPanels[] = { 16, 64 };
+        const size_t depthPanels[] = { 64, 128, 256 };
+        const size_t colPanels[] = { 256, 512, 2048 };
 
-            size_t colStart = colSlice.first;
-            size_t colEnd   = colSlice.second - 1;
+        Blocking best = defaultBlocking();
+        double bestTime = std::numeric_limits<double>::infinity();
 
-            if (
-                rowStart >= this->nrows ||  // Check if rowStart is out of bounds
-                rowEnd   >= this->nrows ||  // Check if rowEnd is out of bounds
-                rowStart >  rowEnd      ||  // Ensure rowStart comes before rowEnd
-                colStart >= this->ncols ||  // Check if colStart is out of bounds
-                colEnd   >= this->ncols ||  // Check if colEnd is out of bounds
-                colStart > colEnd           // Ensure colStart comes before colEnd
-            ) {
-                throw std::out_of_range("Slice indices are out of bounds or invalid.");
+        for (size_t mc : rowPanels) {
+            for (size_t kc : depthPanels) {
+                for (size_t nc : colPanels) {
+                    const Blocking candidate = { mc, kc, nc };
+                    setBlocking(shape, candidate);
+
+                    const double t = matOpsParallel::detail::bestTime([&] { Matrix C = A * B; (void)C; });
+                    if (t < bestTime) {
+                        bestTime = t;
+                        best = candidate;
+                    }
+                }
             }
+        }
+
+        setBlocking(shape, best);
+        return best;
+    }
+
+}
+
+/**
+ * @brief Asynchronous operations on the library's thread pool (matOpsParallel::pool()).
+ *
+ * Every function returns at once with a Future; the work runs on a pool worker, and
+ * then() attaches follow-up work that is queued as soon as the result is ready, so
+ * chains of dependent operations need no waiting thread. Operands passed by reference
+ * are copied, so they may go out of scope immediately.
+ *
+ * @code
+ * matOpsAsync::Future<Matrix> AB = matOpsAsync::multiply(A, B);
+ * matOpsAsync::Future<Matrix> CD = matOpsAsync::multiply(C, D);
+ * matOpsAsync::Future<double> d = matOpsAsync::multiply(AB, CD)
+ *     .then([](const Matrix& P) { return P.determinant(); });
+ * std::cout << d.get();
+ * @endcode
+ */
+namespace matOpsAsync {
+
+    template <typename T> class Future;
+
+    namespace detail {
+
+        /* Result slot shared by a Future and the task that fulfils it. */
+        template <typename T>
+        struct State {
+            std::mutex lock;
+            std::condition_variable done;
+            bool ready = false;
+            std::unique_ptr<T> value;
+            std::exception_ptr error;
+            std::vector<std::function<void()>> continuations;
+
+            void finish(std::unique_ptr<T> result, std::exception_ptr failure) {
+                std::vector<std::function<void()>> pending;
+                {
+                    std::lock_guard<std::mutex> guard(this->lock);
+                    this->value = std::move(result);
+                    this->error = failure;
+                    this->ready = true;
+                    pending.swap(this->continuations);
+                }
+                this->done.notify_all();
 
-            std::vector<std::vector<double>> slice(rowEnd - rowStart + 1); 
-            /*
-            slice = something like this
-            {
-                {},
-                {},
-                ...
+                for (std::function<void()>& continuation : pending) {
+                    continuation();
+                }
             }
-            */
-            size_t sliceRowIndex = 0;
 
-            for (size_t i = rowStart; i <= rowEnd; ++i) {
-                slice[sliceRowIndex].reserve(colEnd - colStart + 1);
-                for (size_t j = colStart; j <= colEnd; ++j) {
-                    slice[sliceRowIndex].push_back(this->container[i][j]);
+            /* Runs f on the completing thread, or right away if already complete. */
+            void onReady(std::function<void()> f) {
+                {
+                    std::lock_guard<std::mutex> guard(this->lock);
+                    if (!this->ready) {
+                        this->continuations.push_back(std::move(f));
+                        return;
+                    }
                 }
-                sliceRowIndex++;
+                f();
             }
+        };
 
-            return Matrix(std::move(slice), InternalTag{});
-        }
+        /* Access to the shared state of futures, for the functions that create them. */
+        struct Access {
+            template <typename T>
+            static const std::shared_ptr<State<T>>& state(const Future<T>& future) {
+                return future.state;
+            }
 
-        /**
-         * @brief Extracts a specific row from the current Matrix.
-         *
-         * This function creates and returns a new Matrix object containing the row at the specified index.
-         * The row is extracted as a single-row submatrix.
-         *
-         * @param rowIdx The zero-based index of the row to extract.
-         * @return A new Matrix object containing the extracted row.
-         * @throws std::invalid_argument If the specified row index is out of range.
-         */
-        Matrix extractRow(size_t rowIdx) const {
-            if (rowIdx >= this->nrows) {
-                throw std::invalid_argument("Row index out of range.");
+            template <typename T>
+            static Future<T> make(std::shared_ptr<State<T>> state) {
+                return Future<T>(std::move(state));
+            }
+        };
+
+        /* Evaluates f() into state, capturing any exception. */
+        template <typename T, typename F>
+        void fulfil(const std::shared_ptr<State<T>>& state, F& f) {
+            std::unique_ptr<T> result;
+            std::exception_ptr failure;
+
+            try {
+                result.reset(new T(f()));
+            } catch (...) {
+                failure = std::current_exception();
             }
 
-            return Matrix({this->container[rowIdx]}, InternalTag{});
+            state->finish(std::move(result), failure);
         }
 
-        /**
-         * @brief Extracts a specific column from the current Matrix.
-         *
-         * This function calls Matrix::extractMatrix() under the hood
-         * as extracting a column will require the exact same logic.
-         *
-         * @param colIdx The zero-based index of the column to extract.
-         * @return A new Matrix object containing the extracted column.
-         * @throws std::invalid_argument If the specified column index is out of range.
-         */
-        Matrix extractCol(size_t colIdx) const {
-            if (colIdx >= this->ncols) {
-                throw std::invalid_argument("Column index out of range.");
+    }
+
+    /**
+     * @brief Handle to a result computed on the thread pool.
+     *
+     * Copies share the same result. get() may be called any number of times, from any
+     * thread; a pool worker that waits runs other queued tasks meanwhile instead of
+     * blocking the pool.
+     *
+     * @tparam T The result type.
+     */
+    template <typename T>
+    class Future {
+        private:
+            std::shared_ptr<detail::State<T>> state;
+
+            friend struct detail::Access;
+
+            explicit Future(std::shared_ptr<detail::State<T>> state) : state(std::move(state)) {}
+
+        public:
+            /// @brief An empty future; valid() is false.
+            Future() = default;
+
+            /// @brief Whether the future refers to a result.
+            bool valid() const {
+                return static_cast<bool>(this->state);
             }
 
-            return this->extractMatrix({0, this->nrows}, {colIdx, colIdx + 1});
-        }
+            /// @brief Whether the result (or an exception) is available.
+            bool isReady() const {
+                std::lock_guard<std::mutex> guard(this->state->lock);
+                return this->state->ready;
+            }
 
-        /**
-         * @brief Computes the sum of the elements of a vector.
-         *
-         * Calculates the sum of elements for matrices that are
-         * considered as vectors. It supports both column vectors (K x 1) and
-         * row vectors (1 x K). 
-         *
-         * @return The sum of all elements in the vector.
-         * @throws std::invalid_argument If the matrix is not a one-dimensional vector.
-         */
-        double sum() const {
-            bool colMatrix = this->ncols == 1;
-            bool rowMatrix = this->nrows == 1;
+            /// @brief Blocks until the result is available.
+            void wait() const {
+                matOpsParallel::ThreadPool& workers = matOpsParallel::pool();
+                const bool helping = workers.isWorkerThread();
 
-            if ( !colMatrix && !rowMatrix ) {
-                throw std::invalid_argument("Sum can only be calculated for (K, 1) or (1, K) dim matrices");
-            }
+                std::unique_lock<std::mutex> guard(this->state->lock);
+                while (!this->state->ready) {
+                    if (!helping) {
+                        this->state->done.wait(guard);
+                        continue;
+                    }
 
-            double total = 0.0;
+                    // A waiting worker keeps the pool going, since the result may be queued behind it.
+                    guard.unlock();
+                    const bool ran = workers.runPendingTask();
+                    guard.lock();
+                    if (!ran && !this->state->ready) {
+                        this->state->done.wait_for(guard, std::chrono::microseconds(200));
+                    }
+                }
+            }
 
-            if ( rowMatrix ) {
-                for (auto& num: this->container[0]) {
-                    total += num;
+            /**
+             * @brief Waits for the result and returns it.
+             * @throws Whatever the operation threw.
+             */
+            const T& get() const {
+                this->wait();
+                if (this->state->error) {
+                    std::rethrow_exception(this->state->error);
                 }
+                return *this->state->value;
+            }
+
+            /**
+             * @brief Queues f(result) on the pool as soon as this result is ready.
+             *
+             * If this future fails, f is not called and the returned future fails with
+             * the same exception.
+             *
+             * @param f Callable taking const T& and returning a value.
+             * @return A future for the value returned by f.
+             */
+            template <typename F>
+            Future<typename std::decay<typename std::result_of<F(const T&)>::type>::type> then(F f) const {
+                typedef typename std::decay<typename std::result_of<F(const T&)>::type>::type R;
+
+                std::shared_ptr<detail::State<T>> source = this->state;
+                std::shared_ptr<detail::State<R>> target = std::make_shared<detail::State<R>>();
+                const matOpsParallel::ExecutionContext context = matOpsParallel::currentContext();
+
+                source->onReady([source, target, f, context]() {
+                    if (source->error) {
+                        target->finish(std::unique_ptr<R>(), source->error);
+                        return;
+                    }
+
+                    matOpsParallel::pool().submit([source, target, f, context]() {
+                        matOpsParallel::ScopedContext scope(context);
+                        auto call = [&]() { return f(*source->value); };
+                        detail::fulfil(target, call);
+                    });
+                });
 
-                return total;
+                return detail::Access::make(target);
             }
+    };
+
+    /**
+     * @brief Runs f() on the thread pool, with the calling thread's ExecutionContext.
+     * @param f Callable taking no arguments and returning a value.
+     * @return A future for the value returned by f.
+     */
+    template <typename F>
+    Future<typename std::decay<typename std::result_of<F()>::type>::type> async(F f) {
+        typedef typename std::decay<typename std::result_of<F()>::type>::type R;
+
+        std::shared_ptr<detail::State<R>> target = std::make_shared<detail::State<R>>();
+        const matOpsParallel::ExecutionContext context = matOpsParallel::currentContext();
+        matOpsParallel::pool().submit([target, f, context]() mutable {
+            matOpsParallel::ScopedContext scope(context);
+            detail::fulfil(target, f);
+        });
+
+        return detail::Access::make(target);
+    }
 
-            for (auto& row : this->container) {
-                total += row[0];
+    /**
+     * @brief Queues f(a, b) on the pool as soon as both results are ready.
+     *
+     * If either input fails, the returned future fails with its exception.
+     *
+     * @return A future for the value returned by f.
+     */
+    template <typename A, typename B, typename F>
+    Future<typename std::decay<typename std::result_of<F(const A&, const B&)>::type>::type>
+    combine(const Future<A>& a, const Future<B>& b, F f) {
+        typedef typename std::decay<typename std::result_of<F(const A&, const B&)>::type>::type R;
+
+        std::shared_ptr<detail::State<A>> first = detail::Access::state(a);
+        std::shared_ptr<detail::State<B>> second = detail::Access::state(b);
+        std::shared_ptr<detail::State<R>> target = std::make_shared<detail::State<R>>();
+        std::shared_ptr<std::atomic<int>> remaining = std::make_shared<std::atomic<int>>(2);
+        const matOpsParallel::ExecutionContext context = matOpsParallel::currentContext();
+
+        // Whichever input completes last queues the work.
+        std::function<void()> arrive = [first, second, target, remaining, f, context]() {
+            if (--*remaining != 0) {
+                return;
             }
 
-            return total;
-        }
+            if (first->error || second->error) {
+                target->finish(std::unique_ptr<R>(), first->error ? first->error : second->error);
+                return;
+            }
 
-        /**
-         * @brief Computes the sum of all elements raised to a specified power.
-         *
-         * This function calculates the sum of each element in the matrix after raising
-         * it to the given @p power. The function only works for matrices that are either
-         * a row matrix (1 x K) or a column matrix (K x 1). If the matrix has any other dimensions,
-         * an std::invalid_argument exception is thrown.
-         *
-         * Additionally, if an element is zero and the @p power is less than or equal to zero,
-         * the function will throw an std::runtime_error to indicate a division by zero scenario,
-         * since 0 raised to a non-positive power is undefined.
-         *
-         * @param power The exponent to which each element in the matrix is raised.
-         * @return The sum of all elements raised to the specified power.
-         *
-         * @throws std::invalid_argument if the matrix dimensions are not (1, K) or (K, 1).
-         * @throws std::runtime_error if any element is zero and @p power is less than or equal to zero.
-         */
-        double sum(double power) const {
-            bool colMatrix = this->ncols == 1;
-            bool rowMatrix = this->nrows == 1;
+            matOpsParallel::pool().submit([first, second, target, f, context]() {
+                matOpsParallel::ScopedContext scope(context);
+                auto call = [&]() { return f(*first->value, *second->value); };
+                detail::fulfil(target, call);
+            });
+        };
 
-            if ( !colMatrix && !rowMatrix ) {
-                throw std::invalid_argument("Sum can only be calculated for (K, 1) or (1, K) dim matrices");
-            }
+        first->onReady(arrive);
+        second->onReady(arrive);
+        return detail::Access::make(target);
+    }
 
-            double total = 0.0;
+    /// @brief A * B on the pool.
+    inline Future<Matrix> multiply(const Matrix& A, const Matrix& B) {
+        return async([A, B]() { return A * B; });
+    }
 
-            if ( rowMatrix ) {
-                for (auto& num: this->container[0]) {
-                    if (num == 0 && power <= 0) {
-                        throw std::runtime_error("Division by zero occured. (0 ^ ( <=0 ))");
+    /// @brief A * B on the pool, started as soon as both operands are ready.
+    inline Future<Matrix> multiply(const Future<Matrix>& A, const Future<Matrix>& B) {
+        return combine(A, B, [](const Matrix& x, const Matrix& y) { return x * y; });
+    }
+
+    /// @brief A.inverse() on the pool.
+    inline Future<Matrix> inverse(const Matrix& A) {
+        return async([A]() { return A.inverse(); });
+    }
+
+    /// @brief The inverse of a pending result, started as soon as it is ready.
+    inline Future<Matrix> inverse(const Future<Matrix>& A) {
+        return A.then([](const Matrix& x) { return x.inverse(); });
+    }
+
+    /// @brief A.determinant() on the pool.
+    inline Future<double> determinant(const Matrix& A) {
+        return async([A]() { return A.determinant(); });
+    }
+
+    /// @brief The determinant of a pending result, started as soon as it is ready.
+    inline Future<double> determinant(const Future<Matrix>& A) {
+        return A.then([](const Matrix& x) { return x.determinant(); });
+    }
+
+    /// @brief A.transpose() on the pool.
+    inline Future<Matrix> transpose(const Matrix& A) {
+        return async([A]() { return A.transpose(); });
+    }
+
+    /// @brief The transpose of a pending result, started as soon as it is ready.
+    inline Future<Matrix> transpose(const Future<Matrix>& A) {
+        return A.then([](const Matrix& x) { return x.transpose(); });
+    }
+
+}
+
+/**
+ * @brief Deferred execution of multi-operation expressions.
+ *
+ * Operations on Expr handles are recorded into a TaskGraph (a DAG) instead of being
+ * evaluated. TaskGraph::run() then evaluates the nodes needed by the requested outputs
+ * on the library's work-stealing pool: independent nodes run concurrently, each node
+ * is queued as soon as its last input is ready, and an intermediate result is freed as
+ * soon as its last consumer has finished.
+ *
+ * @code
+ * matOpsGraph::TaskGraph g;
+ * matOpsGraph::Expr A = g.input(a), B = g.input(b), C = g.input(c), D = g.input(d);
+ * Matrix r = g.run((A * B) + (C * D)); // A * B and C * D run concurrently
+ * @endcode
+ */
+namespace matOpsGraph {
+
+    class TaskGraph;
+
+    /**
+     * @brief Handle to a node of a TaskGraph. Arithmetic on handles records new nodes.
+     */
+    class Expr {
+        private:
+            TaskGraph* graph;
+            size_t id;
+
+            friend class TaskGraph;
+
+            Expr(TaskGraph* graph, size_t id) : graph(graph), id(id) {}
+
+        public:
+            /// @brief Records the product of two nodes.
+            Expr operator*(const Expr& other) const;
+
+            /// @brief Records the (broadcasting) sum of two nodes.
+            Expr operator+(const Expr& other) const;
+
+            /// @brief Records the (broadcasting) difference of two nodes.
+            Expr operator-(const Expr& other) const;
+
+            /// @brief Records the product with a scalar.
+            Expr operator*(double scalar) const;
+
+            /// @brief Records the product of a scalar with a node.
+            friend Expr operator*(double scalar, const Expr& e) {
+                return e * scalar;
+            }
+
+            /// @brief Records the transpose of the node.
+            Expr transpose() const;
+
+            /// @brief Records the inverse of the node.
+            Expr inverse() const;
+    };
+
+    /**
+     * @brief A recorded DAG of matrix operations.
+     *
+     * A graph can be run any number of times; every run recomputes the nodes it needs.
+     * Graphs are not copyable, since their Expr handles refer to them.
+     */
+    class TaskGraph {
+        private:
+            typedef std::function<Matrix(const std::vector<const Matrix*>&)> Operation;
+
+            struct Node {
+                Operation op;                  // Empty for inputs.
+                std::vector<size_t> inputs;
+                const Matrix* external;        // Input held by reference.
+                std::shared_ptr<Matrix> owned; // Input moved into the graph.
+            };
+
+            /* Per-run bookkeeping, shared with the pool tasks. */
+            struct RunState {
+                std::vector<const Matrix*> values;
+                std::vector<std::shared_ptr<Matrix>> results;
+                std::vector<std::vector<size_t>> consumers;
+                std::unique_ptr<std::atomic<size_t>[]> pendingInputs;
+                std::unique_ptr<std::atomic<size_t>[]> uses;
+                std::atomic<size_t> remaining;
+                std::atomic<size_t> live;
+                std::atomic<size_t> peak;
+                std::atomic<bool> failed;
+                std::exception_ptr error;
+                std::mutex lock;
+                std::condition_variable finished;
+                matOpsParallel::ExecutionContext context; // Of the thread that called run().
+
+                explicit RunState(size_t n)
+                    : values(n, nullptr), results(n), consumers(n),
+                      pendingInputs(new std::atomic<size_t>[n]), uses(new std::atomic<size_t>[n]),
+                      remaining(0), live(0), peak(0), failed(false) {
+                    for (size_t i = 0; i < n; ++i) {
+                        this->pendingInputs[i] = 0;
+                        this->uses[i] = 0;
                     }
-                    total += pow(num, power);
                 }
+            };
+
+            std::vector<Node> nodes;
+            size_t lastPeak = 0;
+
+            Expr add(Operation op, std::vector<size_t> inputs) {
+                Node node;
+                node.op = std::move(op);
+                node.inputs = std::move(inputs);
+                node.external = nullptr;
+                this->nodes.push_back(std::move(node));
+                return Expr(this, this->nodes.size() - 1);
+            }
+
+            void check(const Expr& e) const {
+                if (e.graph != this || e.id >= this->nodes.size()) {
+                    throw std::invalid_argument("Expression belongs to another task graph");
+                }
+            }
 
-                return total;
+            void schedule(const std::shared_ptr<RunState>& state, size_t id) {
+                matOpsParallel::pool().submit([this, state, id]() {
+                    matOpsParallel::ScopedContext scope(state->context);
+                    this->execute(state, id);
+                });
             }
 
-            for (auto& row : this->container) {
-                if (row[0] == 0 && power <= 0) {
-                    throw std::runtime_error("Division by zero occured. (0 ^ ( <=0 ))");
+            void execute(const std::shared_ptr<RunState>& state, size_t id) {
+                const Node& node = this->nodes[id];
+
+                if (!state->failed.load()) {
+                    try {
+                        std::vector<const Matrix*> args;
+                        for (size_t in : node.inputs) {
+                            args.push_back(state->values[in]);
+                        }
+
+                        state->results[id] = std::make_shared<Matrix>(node.op(args));
+                        state->values[id] = state->results[id].get();
+
+                        const size_t now = ++state->live;
+                        size_t seen = state->peak.load();
+                        while (now > seen && !state->peak.compare_exchange_weak(seen, now)) {}
+                    } catch (...) {
+                        std::lock_guard<std::mutex> guard(state->lock);
+                        if (!state->error) {
+                            state->error = std::current_exception();
+                        }
+                        state->failed = true;
+                    }
+                }
+
+                // Free inputs whose last consumer this was.
+                for (size_t in : node.inputs) {
+                    if (--state->uses[in] == 0 && state->results[in]) {
+                        state->results[in].reset();
+                        state->values[in] = nullptr;
+                        --state->live;
+                    }
+                }
+
+                for (size_t consumer : state->consumers[id]) {
+                    if (--state->pendingInputs[consumer] == 0) {
+                        this->schedule(state, consumer);
+                    }
+                }
+
+                if (--state->remaining == 0) {
+                    std::lock_guard<std::mutex> guard(state->lock);
+                    state->finished.notify_all();
                 }
-                total += pow(row[0], power);
             }
 
-            return total;
-        }
+        public:
+            TaskGraph() = default;
+            TaskGraph(const TaskGraph&) = delete;
+            TaskGraph& operator=(const TaskGraph&) = delete;
+
+            /**
+             * @brief Adds an input held by reference; @p m must outlive every run().
+             */
+            Expr input(const Matrix& m) {
+                Node node;
+                node.external = &m;
+                this->nodes.push_back(std::move(node));
+                return Expr(this, this->nodes.size() - 1);
+            }
 
-        /**
-         * @brief Computes the mean (average) of the elements of a vector.
-         *
-         * Calculates the mean value for matrices that are considered as vectors.
-         * It supports both row vectors (1 x K) and column vectors (K x 1) by dividing the sum
-         * of the elements by the number of elements in the vector.
-         *
-         * @return The mean (average) value of the vector elements.
-         * @throws std::invalid_argument If the matrix is not a one-dimensional vector.
-         */
-        double mean() const {
-            
-            double sum   = this->sum();
-            size_t count = (this->nrows == 1) ? this->ncols : this->nrows;
-            
-            return sum / count;
-        }
+            /// @brief Adds an input owned by the graph.
+            Expr input(Matrix&& m) {
+                Node node;
+                node.external = nullptr;
+                node.owned = std::make_shared<Matrix>(std::move(m));
+                this->nodes.push_back(std::move(node));
+                return Expr(this, this->nodes.size() - 1);
+            }
 
-        /**
-         * @brief Computes the trace of an nxn square matrix.
-         *
-         * @return Trace of calling Matrix object.
-         * @throws std::invalid_argument If the matrix is not sqaure.
-         */
-        double trace() const {
-            double tr = 0.0;
+            /**
+             * @brief Records a custom unary operation.
+             * @param a The operand.
+             * @param f Callable mapping const Matrix& to Matrix.
+             */
+            Expr apply(const Expr& a, std::function<Matrix(const Matrix&)> f) {
+                this->check(a);
+                return this->add([f](const std::vector<const Matrix*>& x) { return f(*x[0]); }, { a.id });
+            }
 
-            if (this->nrows != this->ncols) {
-                throw std::invalid_argument("Trace is only defined for square matrices.");
+            /**
+             * @brief Records a custom binary operation.
+             * @param a The first operand.
+             * @param b The second operand.
+             * @param f Callable mapping (const Matrix&, const Matrix&) to Matrix.
+             */
+            Expr apply(const Expr& a, const Expr& b, std::function<Matrix(const Matrix&, const Matrix&)> f) {
+                this->check(a);
+                this->check(b);
+                return this->add([f](const std::vector<const Matrix*>& x) { return f(*x[0], *x[1]); }, { a.id, b.id });
             }
 
-            for (size_t i = 0; i < this->nrows; ++i) {
-                tr += this->container[i][i];
+            /// @brief Number of recorded nodes, inputs included.
+            size_t size() const {
+                return this->nodes.size();
             }
 
-            return tr;
-        }
+            /**
+             * @brief Largest number of intermediate results held at once during the last
+             * run(), outputs included.
+             */
+            size_t peakIntermediates() const {
+                return this->lastPeak;
+            }
 
-        /**
-         * @brief Outputs the matrix to an output stream.
-         *
-         * @param os The output stream.
-         * @param m The Matrix to output.
-         * @return A reference to the output stream.
-         */
-        friend std::ostream& operator<<(std::ostream& os, const Matrix& m) {
-            os << "[\n";
+            /**
+             * @brief Evaluates the given outputs.
+             *
+             * Only the nodes the outputs depend on are evaluated. If a node throws, the
+             * nodes that depend on it are skipped, and the first exception is rethrown
+             * once the running nodes have finished.
+             *
+             * @param outputs The nodes to evaluate.
+             * @return Their values, in the same order.
+             * @throws std::invalid_argument if an output belongs to another graph.
+             */
+            std::vector<Matrix> run(const std::vector<Expr>& outputs) {
+                const size_t n = this->nodes.size();
+                std::shared_ptr<RunState> state = std::make_shared<RunState>(n);
+                state->context = matOpsParallel::currentContext();
+
+                // Mark the nodes the outputs depend on.
+                std::vector<bool> needed(n, false);
+                std::vector<size_t> stack;
+                for (const Expr& e : outputs) {
+                    this->check(e);
+                    stack.push_back(e.id);
+                    ++state->uses[e.id];
+                }
+                while (!stack.empty()) {
+                    const size_t id = stack.back();
+                    stack.pop_back();
+                    if (needed[id]) {
+                        continue;
+                    }
+                    needed[id] = true;
+                    for (size_t in : this->nodes[id].inputs) {
+                        stack.push_back(in);
+                    }
+                }
 
-            for (size_t i = 0; i < m.nrows; ++i) {
-                os << "  [";
-                for (size_t j = 0; j < m.ncols; ++j) {
-                    os << m.container[i][j];
+                std::vector<size_t> ready;
+                for (size_t id = 0; id < n; ++id) {
+                    if (!needed[id]) {
+                        continue;
+                    }
 
-                    if (j < m.ncols - 1) os << ", ";
+                    const Node& node = this->nodes[id];
+                    if (!node.op) {
+                        state->values[id] = node.external != nullptr ? node.external : node.owned.get();
+                        continue;
+                    }
+
+                    ++state->remaining;
+                    for (size_t in : node.inputs) {
+                        ++state->uses[in];
+                        if (this->nodes[in].op) {
+                            ++state->pendingInputs[id];
+                            state->consumers[in].push_back(id);
+                        }
+                    }
+                    if (state->pendingInputs[id] == 0) {
+                        ready.push_back(id);
+                    }
                 }
-                os << "]" << (i < m.nrows - 1 ? ",\n" : "\n");
+
+                if (state->remaining > 0) {
+                    for (size_t id : ready) {
+                        this->schedule(state, id);
+                    }
+
+                    matOpsParallel::ThreadPool& workers = matOpsParallel::pool();
+                    const bool helping = workers.isWorkerThread();
+                    std::unique_lock<std::mutex> guard(state->lock);
+                    while (state->remaining.load() != 0) {
+                        if (!helping) {
+                            state->finished.wait(guard);
+                            continue;
+                        }
+
+                        guard.unlock();
+                        const bool ran = workers.runPendingTask();
+                        guard.lock();
+                        if (!ran && state->remaining.load() != 0) {
+                            state->finished.wait_for(guard, std::chrono::microseconds(200));
+                        }
+                    }
+                }
+
+                this->lastPeak = state->peak;
+                if (state->error) {
+                    std::rethrow_exception(state->error);
+                }
+
+                std::vector<Matrix> values;
+                for (const Expr& e : outputs) {
+                    values.push_back(*state->values[e.id]);
+                }
+                return values;
             }
-            os << "]\n";
-            return os;
-        }
-};
 
-inline std::ostream& operator<<(std::ostream& os, const std::pair<size_t, size_t>& shape) {
-    os << "(" << shape.first << ", " << shape.second << ")";
+            /**
+             * @brief Evaluates a single output.
+             * @see run(const std::vector<Expr>&)
+             */
+            Matrix run(const Expr& output) {
+                return std::move(this->run(std::vector<Expr>{ output })[0]);
+            }
+    };
 
-    return os;
-}
+    inline Expr Expr::operator*(const Expr& other) const {
+        return this->graph->apply(*this, other, [](const Matrix& a, const Matrix& b) { return a * b; });
+    }
 
-inline std::ostream& operator<<(std::ostream& os, const std::vector<std::vector<double>>& container) {
-    size_t nrows = container.size();
-    size_t ncols = container[0].size();
+    inline Expr Expr::operator+(const Expr& other) const {
+        return this->graph->apply(*this, other, [](const Matrix& a, const Matrix& b) { return a + b; });
+    }
 
-    os << "[\n";
+    inline Expr Expr::operator-(const Expr& other) const {
+        return this->graph->apply(*this, other, [](const Matrix& a, const Matrix& b) { return a - b; });
+    }
 
-    for (size_t i = 0; i < nrows; ++i) {
-        os << "  [";
-        for (size_t j = 0; j < ncols; ++j) {
-            os << container[i][j];
+    inline Expr Expr::operator*(double scalar) const {
+        return this->graph->apply(*this, [scalar](const Matrix& a) { return a * scalar; });
+    }
 
-            if (j < ncols - 1) os << ", ";
-        }
-        os << "]" << (i < nrows - 1 ? ",\n" : "\n");
+    inline Expr Expr::transpose() const {
+        return this->graph->apply(*this, [](const Matrix& a) { return a.transpose(); });
     }
-    os << "]\n";
-    return os;
+
+    inline Expr Expr::inverse() const {
+        return this->graph->apply(*this, [](const Matrix& a) { return a.inverse(); });
+    }
+
 }
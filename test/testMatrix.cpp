@@ -10,6 +10,9 @@
  #include <vector>
  #include <stdexcept>
  #include <cmath>
+ #include <omp.h>
+ #include <cstdio>
+ #include <fstream>
  
  /**
   * @brief Tests for Matrix construction and shape reporting.
@@ -794,4 +797,2181 @@ TEST_CASE("trace() with vector-of-vector constructor for square matrices") {
 
         CHECK_THROWS_AS(m.trace(), std::invalid_argument);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("CSRMatrix construction and SpMV") {
+    Matrix dense({ {4.0, 0.0, 1.0},
+                   {0.0, 3.0, 0.0},
+                   {1.0, 0.0, 2.0} });
+
+    SUBCASE("fromDense keeps only nonzeros and round-trips") {
+        CSRMatrix S = CSRMatrix::fromDense(dense);
+        CHECK(S.nnz() == 5);
+        CHECK(S.toDense() == dense);
+    }
+
+    SUBCASE("fromTriplets sums duplicates") {
+        CSRMatrix S = CSRMatrix::fromTriplets(3, 3,
+            {2, 0, 1, 0, 2, 2},
+            {0, 2, 1, 0, 2, 0},
+            {0.5, 1.0, 3.0, 4.0, 2.0, 0.5});
+        CHECK(S.nnz() == 5);
+        CHECK(S.toDense() == dense);
+    }
+
+    SUBCASE("SpMV matches the dense product") {
+        CSRMatrix S = CSRMatrix::fromDense(dense);
+        std::vector<double> y = S * std::vector<double>{1.0, 2.0, 3.0};
+        CHECK(y == std::vector<double>{7.0, 6.0, 7.0});
+        CHECK_THROWS_AS(S * std::vector<double>{1.0}, std::invalid_argument);
+    }
+
+    SUBCASE("Ill formed arrays throw") {
+        CHECK_THROWS_AS(CSRMatrix(2, 2, {0, 1}, {0}, {1.0}), std::invalid_argument);
+        CHECK_THROWS_AS(CSRMatrix(2, 2, {0, 2, 2}, {1, 0}, {1.0, 2.0}), std::invalid_argument);
+        CHECK_THROWS_AS(CSRMatrix(2, 2, {0, 1, 2}, {0, 2}, {1.0, 2.0}), std::invalid_argument);
+    }
+}
+
+TEST_CASE("SELLMatrix SpMV matches CSR for irregular rows") {
+    // Rows of very different lengths so that sorting and padding both matter.
+    const size_t n = 53;
+    std::vector<size_t> rows, cols;
+    std::vector<double> vals;
+    for (size_t i = 0; i < n; ++i) {
+        size_t len = (i * 7) % 11;
+        for (size_t k = 0; k <= len; ++k) {
+            rows.push_back(i);
+            cols.push_back((i + 3 * k) % n);
+            vals.push_back(1.0 + 0.25 * static_cast<double>(i + k));
+        }
+    }
+    CSRMatrix A = CSRMatrix::fromTriplets(n, n, rows, cols, vals);
+
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = std::sin(static_cast<double>(i));
+    std::vector<double> expected = A * x;
+
+    for (size_t chunk : {1, 3, 4, 8, 16}) {
+        for (size_t sigma : {1, 8, 1000}) {
+            SELLMatrix S = SELLMatrix::fromCSR(A, chunk, sigma);
+            CHECK(S.nnz() == A.nnz());
+            CHECK(S.storedEntries() >= A.nnz());
+            CHECK(S.toDense() == A.toDense());
+
+            std::vector<double> y = S * x;
+            for (size_t i = 0; i < n; ++i) {
+                CHECK(y[i] == doctest::Approx(expected[i]));
+            }
+        }
+    }
+
+    // Global sorting can only reduce padding compared to no sorting.
+    CHECK(SELLMatrix::fromCSR(A, 8, 1000).fillEfficiency() >= SELLMatrix::fromCSR(A, 8, 1).fillEfficiency());
+    CHECK_THROWS_AS(SELLMatrix::fromCSR(A, 0, 1), std::invalid_argument);
+}
+
+TEST_CASE("BSRMatrix products match dense results") {
+    // 9x6 matrix made of 3x3 blocks, with one empty block row and a partially filled block.
+    Matrix dense({ {1, 2, 0, 0, 0, 0},
+                   {3, 4, 5, 0, 0, 0},
+                   {0, 6, 7, 0, 0, 0},
+                   {0, 0, 0, 0, 0, 0},
+                   {0, 0, 0, 0, 0, 0},
+                   {0, 0, 0, 0, 0, 0},
+                   {8, 0, 0, 1, 0, 2},
+                   {0, 0, 0, 0, 3, 0},
+                   {0, 0, 9, 4, 0, 5} });
+    BSRMatrix<3> B = BSRMatrix<3>::fromDense(dense);
+    Matrix X({ {1, -1}, {2, 0}, {3, 1}, {4, 2}, {5, 3}, {6, 4} });
+
+    CHECK(B.nnzBlocks() == 3);
+    CHECK(B.toDense() == dense);
+
+    SUBCASE("SpMV") {
+        std::vector<double> y = B * std::vector<double>{1, 2, 3, 4, 5, 6};
+        Matrix expected = dense * Matrix({ {1}, {2}, {3}, {4}, {5}, {6} });
+        for (size_t i = 0; i < 9; ++i) {
+            CHECK(y[i] == doctest::Approx(expected(i, 0)));
+        }
+    }
+
+    SUBCASE("SpMM") {
+        CHECK((B * X) == dense * X);
+    }
+
+    SUBCASE("Transposed products") {
+        Matrix Z = Matrix::constValMatrix(9, 2, 1.0);
+        Z(4, 1) = -2.0;
+        CHECK(B.transposeMultiply(Z) == dense.transpose() * Z);
+
+        std::vector<double> yt = B.transposeMultiply(std::vector<double>{1, 2, 3, 4, 5, 6, 7, 8, 9});
+        Matrix expected = dense.transpose() * Matrix({ {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9} });
+        for (size_t j = 0; j < 6; ++j) {
+            CHECK(yt[j] == doctest::Approx(expected(j, 0)));
+        }
+    }
+
+    SUBCASE("Rectangular blocks and invalid shapes") {
+        BSRMatrix<3, 2> B32 = BSRMatrix<3, 2>::fromDense(dense);
+        CHECK(B32.toDense() == dense);
+        CHECK((B32 * X) == dense * X);
+        CHECK_THROWS_AS(BSRMatrix<2>::fromDense(dense), std::invalid_argument);
+        CHECK_THROWS_AS(B * std::vector<double>(2, 1.0), std::invalid_argument);
+    }
+}
+
+/**
+ * @brief Builds the 5-point Laplacian of a (k x k) grid plus @p shift on the diagonal.
+ */
+static CSRMatrix gridLaplacian(size_t k, double shift) {
+    std::vector<size_t> rows, cols;
+    std::vector<double> vals;
+    for (size_t r = 0; r < k; ++r) {
+        for (size_t c = 0; c < k; ++c) {
+            size_t i = r * k + c;
+            rows.push_back(i); cols.push_back(i); vals.push_back(4.0 + shift);
+            if (r > 0)     { rows.push_back(i); cols.push_back(i - k); vals.push_back(-1.0); }
+            if (r + 1 < k) { rows.push_back(i); cols.push_back(i + k); vals.push_back(-1.0); }
+            if (c > 0)     { rows.push_back(i); cols.push_back(i - 1); vals.push_back(-1.0); }
+            if (c + 1 < k) { rows.push_back(i); cols.push_back(i + 1); vals.push_back(-1.0); }
+        }
+    }
+    return CSRMatrix::fromTriplets(k * k, k * k, rows, cols, vals);
+}
+
+TEST_CASE("SparseCholesky solves SPD grid systems") {
+    const size_t k = 12;
+    CSRMatrix A = gridLaplacian(k, 0.1);
+    std::vector<double> b(k * k);
+    for (size_t i = 0; i < b.size(); ++i) b[i] = std::cos(static_cast<double>(i));
+
+    SUBCASE("Both orderings give the same solution, minimum degree with less fill") {
+        SparseCholesky natural(A, SparseCholesky::Ordering::Natural);
+        SparseCholesky md(A, SparseCholesky::Ordering::MinimumDegree);
+        CHECK(md.factorNnz() < natural.factorNnz());
+        CHECK(md.supernodeCount() <= k * k);
+
+        std::vector<double> x1 = natural.solve(b);
+        std::vector<double> x2 = md.solve(b);
+        std::vector<double> r = A * x2;
+        for (size_t i = 0; i < b.size(); ++i) {
+            CHECK(x1[i] == doctest::Approx(x2[i]));
+            CHECK(r[i] == doctest::Approx(b[i]));
+        }
+    }
+
+    SUBCASE("Symbolic analysis is reused for a new matrix with the same pattern") {
+        SparseCholesky chol(A);
+        CSRMatrix A2 = gridLaplacian(k, 2.5);
+        chol.factorize(A2);
+        std::vector<double> r = A2 * chol.solve(b);
+        for (size_t i = 0; i < b.size(); ++i) {
+            CHECK(r[i] == doctest::Approx(b[i]));
+        }
+
+        CHECK_THROWS_AS(chol.factorize(gridLaplacian(k + 1, 0.1)), std::invalid_argument);
+    }
+
+    SUBCASE("Multiple right-hand sides") {
+        Matrix dense = A.toDense();
+        Matrix B = Matrix::constValMatrix(k * k, 2, 1.0);
+        B(3, 1) = 5.0;
+        SparseCholesky chol(A);
+        CHECK((dense * chol.solve(B)) == B);
+    }
+
+    SUBCASE("Schur updates wider than one tile") {
+        // Columns 0 and 1 couple to a 100-node clique, so their updates are 100 x 100.
+        const size_t size = 102;
+        Matrix dense = Matrix::constValMatrix(size, size, 0.0);
+        for (size_t i = 0; i < size; ++i) {
+            for (size_t j = 0; j < size; ++j) {
+                if (i == j) {
+                    dense(i, j) = 300.0;
+                } else if (i >= 2 || j >= 2) {
+                    dense(i, j) = std::sin(0.3 * (i + j) + 0.1 * i * j);
+                }
+            }
+        }
+        Matrix rhs = Matrix::constValMatrix(size, 1, 1.0);
+
+        SparseCholesky chol(CSRMatrix::fromDense(dense), SparseCholesky::Ordering::Natural);
+        CHECK(Matrix::allclose(dense * chol.solve(rhs), rhs, 1e-12, 1e-10));
+    }
+
+    SUBCASE("Indefinite matrices are rejected") {
+        CSRMatrix bad = CSRMatrix::fromDense(Matrix({ {1, 2}, {2, 1} }));
+        CHECK_THROWS_AS(SparseCholesky chol(bad), std::runtime_error);
+        CHECK_THROWS_AS(SparseCholesky().solve(b), std::runtime_error);
+        CHECK_THROWS_AS(SparseCholesky().solve(Matrix::constValMatrix(3, 1, 1.0)), std::runtime_error);
+    }
+}
+
+TEST_CASE("CSRMatrix Reverse Cuthill-McKee reordering") {
+    // Grid Laplacian with its vertices randomly relabeled, which destroys the band.
+    const size_t k = 8;
+    CSRMatrix grid = gridLaplacian(k, 0.0);
+    std::vector<size_t> shuffle(k * k);
+    std::iota(shuffle.begin(), shuffle.end(), 0);
+    std::shuffle(shuffle.begin(), shuffle.end(), std::mt19937(7));
+    CSRMatrix A = grid.permute(shuffle);
+
+    SUBCASE("Bandwidth and profile metrics") {
+        CSRMatrix tri = CSRMatrix::fromDense(Matrix({ {2, 1, 0}, {1, 2, 1}, {0, 1, 2} }));
+        CHECK(tri.bandwidth() == 1);
+        CHECK(tri.profile() == 2);
+        CHECK(grid.bandwidth() == k);
+    }
+
+    SUBCASE("RCM returns a permutation and reduces bandwidth and profile") {
+        auto res = A.reorderRCM();
+        const CSRMatrix::ReorderingReport& report = res.second;
+
+        std::vector<size_t> sorted = report.permutation;
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            CHECK(sorted[i] == i);
+        }
+
+        CHECK(report.bandwidthBefore == A.bandwidth());
+        CHECK(report.bandwidthAfter == res.first.bandwidth());
+        CHECK(report.bandwidthAfter <= k + 1);
+        CHECK(report.bandwidthAfter < report.bandwidthBefore);
+        CHECK(report.profileAfter < report.profileBefore);
+        CHECK(res.first.nnz() == A.nnz());
+    }
+
+    SUBCASE("Symmetric permutation preserves products") {
+        std::vector<size_t> perm = A.reverseCuthillMcKee();
+        CSRMatrix B = A.permute(perm);
+        std::vector<double> x(k * k), px(k * k);
+        for (size_t i = 0; i < x.size(); ++i) x[i] = static_cast<double>(i % 5) - 1.5;
+        for (size_t i = 0; i < x.size(); ++i) px[i] = x[perm[i]];
+
+        std::vector<double> y = A * x;
+        std::vector<double> py = B * px;
+        for (size_t i = 0; i < x.size(); ++i) {
+            CHECK(py[i] == doctest::Approx(y[perm[i]]));
+        }
+
+        CHECK_THROWS_AS(A.permute(std::vector<size_t>(k * k, 0)), std::invalid_argument);
+    }
+
+    SUBCASE("Disconnected components and use as a Cholesky ordering") {
+        CSRMatrix two = CSRMatrix::fromDense(Matrix({ {4, 0, 1, 0}, {0, 4, 0, 1}, {1, 0, 4, 0}, {0, 1, 0, 4} }));
+        CHECK(two.reverseCuthillMcKee().size() == 4);
+        CHECK(two.reorderRCM().second.bandwidthAfter == 1);
+
+        SparseCholesky chol(A, SparseCholesky::Ordering::ReverseCuthillMcKee);
+        std::vector<double> b(k * k, 1.0);
+        std::vector<double> r = A * chol.solve(b);
+        for (size_t i = 0; i < b.size(); ++i) {
+            CHECK(r[i] == doctest::Approx(1.0));
+        }
+    }
+}
+
+TEST_CASE("Structured matrices: Diagonal, Tridiagonal, Banded, Triangular") {
+    Matrix A({ {1, 2, 3, 4},
+               {5, 6, 7, 8},
+               {9, 1, 2, 3},
+               {4, 5, 6, 7} });
+
+    SUBCASE("DiagonalMatrix scales rows and columns") {
+        DiagonalMatrix D({2, -1, 0.5, 3});
+        CHECK((D * A) == D.toDense() * A);
+        CHECK((A * D) == A * D.toDense());
+        CHECK((D * D).diagonal() == std::vector<double>{4, 1, 0.25, 9});
+        CHECK((D * D.solve(A)) == A);
+        CHECK_THROWS_AS(DiagonalMatrix({1, 0}).solve(Matrix({ {1}, {1} })), std::runtime_error);
+        CHECK_THROWS_AS(D * Matrix({ {1, 2} }), std::invalid_argument);
+    }
+
+    SUBCASE("TridiagonalMatrix products and Thomas solve") {
+        TridiagonalMatrix T({-1, -1, -1}, {2, 2, 2, 2}, {-1, -1, -1});
+        Matrix dense = T.toDense();
+        CHECK((T * A) == dense * A);
+        CHECK((A * T) == A * dense);
+
+        std::vector<double> x = T.solve(std::vector<double>{1, 0, 0, 1});
+        for (double v : x) {
+            CHECK(v == doctest::Approx(1.0));
+        }
+        CHECK((dense * T.solve(A)) == A);
+        CHECK_THROWS_AS(TridiagonalMatrix({1}, {1, 2, 3}, {1, 1}), std::invalid_argument);
+    }
+
+    SUBCASE("BandedMatrix products and pivoting solve") {
+        Matrix dense({ {0, 2, 0, 0, 0},
+                       {3, 1, 4, 0, 0},
+                       {1, 5, 9, 2, 0},
+                       {0, 6, 5, 3, 5},
+                       {0, 0, 8, 9, 7} });
+        BandedMatrix B = BandedMatrix::fromDense(dense, 2, 1);
+        CHECK(B.toDense() == dense);
+        CHECK(B(2, 0) == 1.0);
+        CHECK_THROWS_AS(B(0, 2), std::out_of_range);
+
+        Matrix R({ {1, 0}, {2, 1}, {3, 0}, {4, 1}, {5, 0} });
+        CHECK((B * R) == dense * R);
+        CHECK((R.transpose() * B) == R.transpose() * dense);
+
+        // The zero leading entry forces a row interchange.
+        Matrix X = B.solve(R);
+        CHECK((dense * X) == R);
+        CHECK_THROWS_AS(BandedMatrix(3, 1, 1).solve(Matrix({ {1}, {1}, {1} })), std::runtime_error);
+    }
+
+    SUBCASE("TriangularMatrix products and substitution") {
+        for (Triangle uplo : {Triangle::Lower, Triangle::Upper}) {
+            TriangularMatrix T = TriangularMatrix::fromDense(A, uplo);
+            Matrix dense = T.toDense();
+            for (size_t i = 0; i < 4; ++i) {
+                for (size_t j = 0; j < 4; ++j) {
+                    bool inside = uplo == Triangle::Lower ? j <= i : j >= i;
+                    CHECK(dense(i, j) == (inside ? A(i, j) : 0.0));
+                }
+            }
+
+            CHECK((T * A) == dense * A);
+            CHECK((A * T) == A * dense);
+            CHECK((dense * T.solve(A)) == A);
+        }
+
+        TriangularMatrix L(2, Triangle::Lower);
+        L(1, 0) = 1.0;
+        CHECK_THROWS_AS(L(0, 1), std::out_of_range);
+        CHECK_THROWS_AS(L.solve(Matrix({ {1}, {1} })), std::runtime_error);
+    }
+}
+
+TEST_CASE("SymmetricMatrix packed storage, syrk and symm") {
+    Matrix X({ {1, 2, 0},
+               {3, -1, 4},
+               {0, 5, 2},
+               {2, 2, 1} });
+    Matrix B({ {1, 0}, {2, 1}, {-1, 3} });
+
+    SUBCASE("Packed access is symmetric") {
+        SymmetricMatrix S(3);
+        S(0, 2) = 7.0;
+        CHECK(S(2, 0) == 7.0);
+        CHECK_THROWS_AS(S(3, 0), std::out_of_range);
+        CHECK(S.toDense() == S.toDense().transpose());
+    }
+
+    SUBCASE("syrk computes X^T * X") {
+        SymmetricMatrix G = SymmetricMatrix::syrk(X);
+        CHECK(G.size() == 3);
+        CHECK(G.toDense() == X.transpose() * X);
+    }
+
+    SUBCASE("syrk handles several tiles") {
+        Matrix W = Matrix::constValMatrix(5, 130, 0.5);
+        for (size_t j = 0; j < 130; ++j) {
+            W(j % 5, j) = static_cast<double>(j) / 10.0;
+        }
+        CHECK(SymmetricMatrix::syrk(W).toDense() == W.transpose() * W);
+    }
+
+    SUBCASE("symm from both sides") {
+        SymmetricMatrix G = SymmetricMatrix::syrk(X);
+        Matrix dense = G.toDense();
+        CHECK(SymmetricMatrix::symm(G, B) == dense * B);
+        CHECK((B.transpose() * G) == B.transpose() * dense);
+        CHECK(SymmetricMatrix::fromDense(dense, Triangle::Upper).toDense() == dense);
+        CHECK_THROWS_AS(G * X, std::invalid_argument);
+    }
+}
+
+TEST_CASE("Broadcasting in operator+ and operator-") {
+    Matrix A({ {1, 2, 3},
+               {4, 5, 6} });
+    Matrix rowVec({ {10, 20, 30} });
+    Matrix colVec({ {100}, {200} });
+
+    SUBCASE("Row vector is broadcast down the rows") {
+        CHECK((A + rowVec) == Matrix({ {11, 22, 33}, {14, 25, 36} }));
+        CHECK((rowVec - A) == Matrix({ {9, 18, 27}, {6, 15, 24} }));
+    }
+
+    SUBCASE("Column vector is broadcast across the columns") {
+        CHECK((A + colVec) == Matrix({ {101, 102, 103}, {204, 205, 206} }));
+        CHECK((A - colVec) == Matrix({ {-99, -98, -97}, {-196, -195, -194} }));
+    }
+
+    SUBCASE("Outer broadcast and 1x1 operands") {
+        CHECK((colVec + rowVec) == Matrix({ {110, 120, 130}, {210, 220, 230} }));
+        CHECK((A - Matrix::constValMatrix(1, 1, 1.0)) == A - 1);
+    }
+
+    SUBCASE("Centering data by column means") {
+        Matrix means({ {2.5, 3.5, 4.5} });
+        Matrix centered = A - means;
+        CHECK(centered == Matrix({ {-1.5, -1.5, -1.5}, {1.5, 1.5, 1.5} }));
+    }
+
+    SUBCASE("Incompatible shapes still throw") {
+        CHECK_THROWS_AS(A + Matrix({ {1, 2} }), std::invalid_argument);
+        CHECK_THROWS_AS(A - Matrix({ {1}, {2}, {3} }), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Hadamard product, element-wise division and fma") {
+    Matrix A({ {1, 2, 3},
+               {4, 5, 6} });
+    Matrix B({ {2, 2, 2},
+               {0.5, 4, -1} });
+
+    SUBCASE("Hadamard product") {
+        CHECK(A.hadamard(B) == Matrix({ {2, 4, 6}, {2, 20, -6} }));
+        CHECK(A.hadamard(Matrix({ {1, 0, -1} })) == Matrix({ {1, 0, -3}, {4, 0, -6} }));
+        CHECK_THROWS_AS(A.hadamard(Matrix({ {1, 2} })), std::invalid_argument);
+    }
+
+    SUBCASE("Element-wise division") {
+        CHECK(A.divide(B) == Matrix({ {0.5, 1, 1.5}, {8, 1.25, -6} }));
+        CHECK(A.divide(Matrix({ {1}, {2} })) == Matrix({ {1, 2, 3}, {2, 2.5, 3} }));
+        CHECK_THROWS_AS(A.divide(Matrix({ {1, 0, 1} })), std::runtime_error);
+        CHECK_THROWS_AS(A.divide(Matrix({ {1, 0} })), std::invalid_argument);
+    }
+
+    SUBCASE("Fused multiply-add") {
+        Matrix C = Matrix::constValMatrix(2, 3, 1.0);
+        CHECK(Matrix::fma(A, B, C) == A.hadamard(B) + C);
+        CHECK_THROWS_AS(Matrix::fma(A, B, Matrix::constValMatrix(3, 2, 1.0)), std::invalid_argument);
+    }
+
+    SUBCASE("Large operands take the parallel path") {
+        Matrix L = Matrix::constValMatrix(200, 100, 3.0);
+        Matrix R = Matrix::constValMatrix(200, 100, 2.0);
+        CHECK(L.hadamard(R) == Matrix::constValMatrix(200, 100, 6.0));
+        CHECK(L.divide(R) == Matrix::constValMatrix(200, 100, 1.5));
+        CHECK(Matrix::fma(L, R, R) == Matrix::constValMatrix(200, 100, 8.0));
+    }
+}
+
+TEST_CASE("Vectorized math functions and apply / zip") {
+    SUBCASE("Functions match the standard library") {
+        double worstExp = 0, worstLog = 0, worstSqrt = 0, worstTanh = 0, worstSigmoid = 0, worstErf = 0;
+
+        for (int i = -2000; i <= 2000; ++i) {
+            const double x = i * 0.01 + 0.003;
+            const double ex = std::exp(x);
+            worstExp = std::max(worstExp, std::abs(matOpsMath::exp(x) - ex) / ex);
+            worstTanh = std::max(worstTanh, std::abs(matOpsMath::tanh(x) - std::tanh(x)) / std::abs(std::tanh(x)));
+            worstSigmoid = std::max(worstSigmoid, std::abs(matOpsMath::sigmoid(x) - 1 / (1 + std::exp(-x))) * (1 + std::exp(-x)));
+            worstErf = std::max(worstErf, std::abs(matOpsMath::erf(x) - std::erf(x)) / std::abs(std::erf(x)));
+
+            const double y = std::pow(10.0, i * 0.1);
+            worstLog = std::max(worstLog, std::abs(matOpsMath::log(y) - std::log(y)) / std::max(1.0, std::abs(std::log(y))));
+            worstSqrt = std::max(worstSqrt, std::abs(matOpsMath::sqrt(y) - std::sqrt(y)) / std::sqrt(y));
+        }
+
+        CHECK(worstExp < 1e-15);
+        CHECK(worstLog < 1e-15);
+        CHECK(worstSqrt < 1e-15);
+        CHECK(worstTanh < 1e-15);
+        CHECK(worstSigmoid < 1e-15);
+        CHECK(worstErf < 1e-14);
+    }
+
+    SUBCASE("Special values") {
+        const double inf = std::numeric_limits<double>::infinity();
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+
+        CHECK(matOpsMath::exp(0.0) == 1.0);
+        CHECK(matOpsMath::exp(1000.0) == inf);
+        CHECK(matOpsMath::exp(-1000.0) == 0.0);
+        CHECK(matOpsMath::exp(-inf) == 0.0);
+        CHECK(std::isnan(matOpsMath::exp(nan)));
+        CHECK(matOpsMath::exp(-740.0) > 0.0); // subnormal result
+
+        CHECK(matOpsMath::log(1.0) == 0.0);
+        CHECK(matOpsMath::log(0.0) == -inf);
+        CHECK(matOpsMath::log(inf) == inf);
+        CHECK(std::isnan(matOpsMath::log(-1.0)));
+        CHECK(std::abs(matOpsMath::log(1e-310) - std::log(1e-310)) < 1e-12);
+
+        CHECK(matOpsMath::sqrt(0.0) == 0.0);
+        CHECK(matOpsMath::sqrt(4.0) == 2.0);
+        CHECK(matOpsMath::sqrt(inf) == inf);
+        CHECK(std::isnan(matOpsMath::sqrt(-1.0)));
+        CHECK(std::abs(matOpsMath::sqrt(1e-310) / std::sqrt(1e-310) - 1) < 1e-15);
+
+        CHECK(matOpsMath::tanh(inf) == 1.0);
+        CHECK(matOpsMath::tanh(-inf) == -1.0);
+        CHECK(matOpsMath::sigmoid(-inf) == 0.0);
+        CHECK(matOpsMath::sigmoid(inf) == 1.0);
+        CHECK(matOpsMath::erf(10.0) == 1.0);
+        CHECK(matOpsMath::erf(-10.0) == -1.0);
+    }
+
+    Matrix A({ {1, 4, 9},
+               {16, 25, 36} });
+
+    SUBCASE("apply and applyInPlace") {
+        CHECK(A.apply(matOpsMath::Sqrt()) == Matrix({ {1, 2, 3}, {4, 5, 6} }));
+        CHECK(A.apply([](double x) { return x - 1; }) == Matrix({ {0, 3, 8}, {15, 24, 35} }));
+
+        Matrix B = A;
+        B.applyInPlace(matOpsMath::Sqrt());
+        B.applyInPlace(matOpsMath::Log());
+        B.applyInPlace(matOpsMath::Exp());
+        CHECK(B == Matrix({ {1, 2, 3}, {4, 5, 6} }));
+    }
+
+    SUBCASE("zip and zipInPlace") {
+        Matrix B({ {2, 2, 2},
+                   {1, 5, 7} });
+        auto maxOf = [](double a, double b) { return a > b ? a : b; };
+
+        CHECK(Matrix::zip(A, B, maxOf) == Matrix({ {2, 4, 9}, {16, 25, 36} }));
+        CHECK(Matrix::zip(A, Matrix({ {10, 0, 10} }), maxOf) == Matrix({ {10, 4, 10}, {16, 25, 36} }));
+        CHECK_THROWS_AS(Matrix::zip(A, Matrix({ {1, 2} }), maxOf), std::invalid_argument);
+
+        Matrix C = A;
+        C.zipInPlace(B, [](double a, double b) { return a * b; });
+        CHECK(C == A.hadamard(B));
+        C.zipInPlace(Matrix({ {1}, {2} }), [](double a, double b) { return a / b; });
+        CHECK(C == Matrix({ {2, 8, 18}, {8, 62.5, 126} }));
+        CHECK_THROWS_AS(C.zipInPlace(Matrix({ {1, 2, 3}, {4, 5, 6}, {7, 8, 9} }), maxOf), std::invalid_argument);
+    }
+
+    SUBCASE("Large matrices take the parallel path") {
+        Matrix L = Matrix::constValMatrix(300, 100, 0.5);
+        Matrix S = L.apply(matOpsMath::Sigmoid());
+        CHECK(std::abs(S(299, 99) - 1 / (1 + std::exp(-0.5))) < 1e-15);
+
+        L.applyInPlace(matOpsMath::Erf());
+        CHECK(std::abs(L(150, 50) - std::erf(0.5)) < 1e-15);
+
+        L.zipInPlace(S, [](double a, double b) { return a + b; });
+        CHECK(std::abs(L(0, 0) - std::erf(0.5) - 1 / (1 + std::exp(-0.5))) < 1e-15);
+    }
+}
+
+TEST_CASE("Fast paths for common exponents") {
+    Matrix A({ {1.5, -2, 0.25},
+               {3, 7.5, -0.5} });
+    Matrix P({ {1.5, 2, 0.25},
+               {3, 7.5, 0.5} });
+
+    auto matchesPow = [](const Matrix& base, double power) {
+        Matrix R = base ^ power;
+        for (size_t i = 0; i < base.shape().first; ++i) {
+            for (size_t j = 0; j < base.shape().second; ++j) {
+                const double expected = std::pow(base(i, j), power);
+                if (std::abs(R(i, j) - expected) > 1e-14 * std::abs(expected)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    SUBCASE("Integer exponents") {
+        for (int k = -12; k <= 12; ++k) {
+            CHECK(matchesPow(A, k));
+        }
+        CHECK(matchesPow(A, 64));
+        CHECK((A ^ 2) == A.hadamard(A));
+    }
+
+    SUBCASE("Half-integer exponents") {
+        for (int k = -9; k <= 9; k += 2) {
+            CHECK(matchesPow(P, k / 2.0));
+        }
+        Matrix R = A ^ 0.5;
+        CHECK(std::isnan(R(0, 1)));
+
+        // The square root is correctly rounded, as std::sqrt is.
+        std::vector<std::vector<double>> roots(1, std::vector<double>(101));
+        for (size_t j = 0; j < 101; ++j) {
+            roots[0][j] = 0.37 * j + 1e-3;
+        }
+        const Matrix X(roots);
+        const Matrix S = X ^ 0.5;
+        size_t inexact = 0;
+        for (size_t j = 0; j < 101; ++j) {
+            inexact += S(0, j) != std::sqrt(roots[0][j]);
+        }
+        CHECK(inexact == 0);
+        CHECK((Matrix::constValMatrix(1, 1, 3.0) ^ 0.5)(0, 0) == std::sqrt(3.0));
+    }
+
+    SUBCASE("Negative half-integer exponents at extreme magnitudes") {
+        // x^-|k| alone overflows or underflows here although x^p is representable.
+        const std::vector<std::pair<double, double>> cases = {
+            { 1e-310, -0.5 }, { 1e-300, -0.5 }, { 1e-200, -1.5 },
+            { 1e200, -1.5 }, { 1e-120, -2.5 }, { 1e120, -2.5 }
+        };
+        for (const auto& c : cases) {
+            const double expected = std::pow(c.first, c.second);
+            REQUIRE(std::isfinite(expected));
+            REQUIRE(expected != 0);
+
+            Matrix E({ {c.first, c.first} });
+            Matrix R = E ^ c.second;
+            CHECK(R(0, 0) == doctest::Approx(expected).epsilon(1e-14));
+            CHECK(R(0, 1) == doctest::Approx(expected).epsilon(1e-14));
+            CHECK(E.sum(c.second) == doctest::Approx(2 * expected).epsilon(1e-14));
+        }
+    }
+
+    SUBCASE("General exponents") {
+        CHECK(matchesPow(P, 1.0 / 3));
+        CHECK(matchesPow(P, -2.7));
+        CHECK(matchesPow(P, 100.0));
+    }
+
+    SUBCASE("Zero base with non-positive exponent") {
+        Matrix Z({ {1, 0} });
+        CHECK_THROWS_AS(Z ^ -1, std::runtime_error);
+        CHECK_THROWS_AS(Z ^ 0, std::runtime_error);
+        CHECK_THROWS_AS(Z.sum(-0.5), std::runtime_error);
+        CHECK((Z ^ 2) == Z);
+    }
+
+    SUBCASE("sum(power) on long vectors") {
+        std::vector<std::vector<double>> col(20000, std::vector<double>(1));
+        double expected2 = 0, expectedHalf = 0;
+        for (size_t i = 0; i < col.size(); ++i) {
+            col[i][0] = 1.0 + i * 1e-3;
+            expected2 += col[i][0] * col[i][0];
+            expectedHalf += std::sqrt(col[i][0]);
+        }
+        Matrix C(col);
+        Matrix R = C.transpose();
+
+        CHECK(std::abs(C.sum(2) - expected2) < 1e-9 * expected2);
+        CHECK(std::abs(R.sum(2) - expected2) < 1e-9 * expected2);
+        CHECK(std::abs(C.sum(0.5) - expectedHalf) < 1e-9 * expectedHalf);
+        CHECK(std::abs(R.sum(1.7) - C.sum(1.7)) < 1e-9 * C.sum(1.7));
+    }
+
+    SUBCASE("Large matrices take the parallel path") {
+        Matrix L = Matrix::constValMatrix(200, 100, 1.5);
+        CHECK((L ^ 3) == Matrix::constValMatrix(200, 100, 3.375));
+        CHECK((L ^ -1) == Matrix::constValMatrix(200, 100, 1 / 1.5));
+        CHECK((L ^ 0.5) == Matrix::constValMatrix(200, 100, std::sqrt(1.5)));
+    }
+}
+
+TEST_CASE("Reductions along an axis") {
+    Matrix A({ {1, -2, 3},
+               {4, 5, -6} });
+
+    SUBCASE("sum, mean and prod") {
+        CHECK(A.sum(Axis::Rows) == Matrix({ {5, 3, -3} }));
+        CHECK(A.sum(Axis::Columns) == Matrix({ {2}, {3} }));
+        CHECK(A.sum(Axis::All) == Matrix::constValMatrix(1, 1, 5));
+        CHECK(A.mean(Axis::Rows) == Matrix({ {2.5, 1.5, -1.5} }));
+        CHECK(A.mean(Axis::Columns) == Matrix({ {2.0 / 3}, {1} }));
+        CHECK(A.prod(Axis::Rows) == Matrix({ {4, -10, -18} }));
+        CHECK(A.prod(Axis::All) == Matrix::constValMatrix(1, 1, 720));
+    }
+
+    SUBCASE("min, max, argmin and argmax") {
+        CHECK(A.min(Axis::Rows) == Matrix({ {1, -2, -6} }));
+        CHECK(A.max(Axis::Columns) == Matrix({ {3}, {5} }));
+        CHECK(A.max(Axis::All) == Matrix::constValMatrix(1, 1, 5));
+
+        CHECK(A.argmin(Axis::Rows) == std::vector<size_t>({ 0, 0, 1 }));
+        CHECK(A.argmax(Axis::Columns) == std::vector<size_t>({ 2, 1 }));
+        CHECK(A.argmin(Axis::All) == std::vector<size_t>({ 5 }));
+        CHECK(A.argmax(Axis::All) == std::vector<size_t>({ 4 }));
+
+        Matrix T({ {2, 1, 1},
+                   {1, 2, 1} });
+        CHECK(T.argmin(Axis::Columns) == std::vector<size_t>({ 1, 0 }));
+        CHECK(T.argmin(Axis::Rows) == std::vector<size_t>({ 1, 0, 0 }));
+        CHECK(T.argmin(Axis::All) == std::vector<size_t>({ 1 }));
+
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        Matrix N({ {nan, 3, 1},
+                   {2, nan, 4} });
+        CHECK(N.min(Axis::Columns) == Matrix({ {1}, {2} }));
+        CHECK(N.argmax(Axis::Rows) == std::vector<size_t>({ 1, 0, 1 }));
+
+        Matrix W({ {nan, 1},
+                   {nan, nan},
+                   {nan, 0} });
+        CHECK(W.argmin(Axis::Rows) == std::vector<size_t>({ 0, 2 }));
+        CHECK(W.argmax(Axis::Rows) == std::vector<size_t>({ 0, 0 }));
+        CHECK(W.argmin(Axis::Columns) == std::vector<size_t>({ 1, 0, 1 }));
+        CHECK(W.argmin(Axis::All) == std::vector<size_t>({ 5 }));
+        CHECK(Matrix::constValMatrix(3, 2, nan).argmax(Axis::All) == std::vector<size_t>({ 0 }));
+    }
+
+    SUBCASE("any and all") {
+        Matrix B({ {0, 1, 0},
+                   {0, 2, 3} });
+        CHECK(B.any(Axis::Rows) == Matrix({ {0, 1, 1} }));
+        CHECK(B.all(Axis::Rows) == Matrix({ {0, 1, 0} }));
+        CHECK(B.any(Axis::Columns) == Matrix({ {1}, {1} }));
+        CHECK(B.all(Axis::All) == Matrix::constValMatrix(1, 1, 0));
+    }
+
+    SUBCASE("Large and oddly shaped matrices match serial results") {
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<double> dist(-1, 1);
+
+        const size_t shapes[3][2] = { {300, 200}, {20000, 3}, {2, 9000} };
+        for (const auto& shape : shapes) {
+            std::vector<std::vector<double>> data(shape[0], std::vector<double>(shape[1]));
+            for (auto& row : data) {
+                for (auto& x : row) {
+                    x = dist(gen);
+                }
+            }
+            Matrix M(data);
+
+            Matrix colSums = M.sum(Axis::Rows);
+            Matrix rowMax = M.max(Axis::Columns);
+            std::vector<size_t> colArgmin = M.argmin(Axis::Rows);
+            std::vector<size_t> rowArgmax = M.argmax(Axis::Columns);
+            double total = 0;
+            size_t mismatches = 0;
+
+            for (size_t j = 0; j < shape[1]; ++j) {
+                double s = 0;
+                size_t best = 0;
+                for (size_t i = 0; i < shape[0]; ++i) {
+                    s += data[i][j];
+                    if (data[i][j] < data[best][j]) {
+                        best = i;
+                    }
+                }
+                mismatches += std::abs(colSums(0, j) - s) > 1e-10 || colArgmin[j] != best;
+                total += s;
+            }
+
+            for (size_t i = 0; i < shape[0]; ++i) {
+                const size_t best = std::max_element(data[i].begin(), data[i].end()) - data[i].begin();
+                mismatches += rowArgmax[i] != best || rowMax(i, 0) != data[i][best];
+            }
+
+            CHECK(mismatches == 0);
+
+            Matrix all = M.sum(Axis::All);
+            CHECK(std::abs(all(0, 0) - total) < 1e-9);
+        }
+    }
+}
+
+TEST_CASE("Compensated and reproducible summation") {
+    SUBCASE("Kahan and pairwise beat naive accumulation") {
+        // 0.1 is not representable; a million of them expose the accumulated error.
+        Matrix tenths = Matrix::constValMatrix(1, 1000000, 0.1);
+        const double exact = 100000.0;
+
+        const double naive = std::abs(tenths.sum() - exact);
+        const double pairwise = std::abs(tenths.sum(Summation::Pairwise) - exact);
+        const double kahan = std::abs(tenths.sum(Summation::Kahan) - exact);
+
+        CHECK(kahan <= 1e-10);
+        CHECK(pairwise <= 1e-9);
+        CHECK(kahan <= naive);
+        CHECK(pairwise <= naive);
+
+        Matrix cancel({ {1e16, 1, -1e16, 1} });
+        CHECK(cancel.sum(Summation::Kahan) == 2.0);
+        CHECK(cancel.transpose().sum(Summation::Kahan) == 2.0);
+    }
+
+    SUBCASE("Axis sums accept every method") {
+        Matrix A({ {1, 2, 3},
+                   {4, 5, 6} });
+        for (Summation method : { Summation::Naive, Summation::Pairwise, Summation::Kahan }) {
+            CHECK(A.sum(Axis::Rows, method) == Matrix({ {5, 7, 9} }));
+            CHECK(A.sum(Axis::Columns, method) == Matrix({ {6}, {15} }));
+            CHECK(A.mean(Axis::All, method) == Matrix::constValMatrix(1, 1, 3.5));
+        }
+        CHECK(Matrix({ {1, 2, 4} }).mean(Summation::Kahan) == doctest::Approx(7.0 / 3));
+        CHECK(Matrix({ {1}, {2}, {3} }).sum(2, Summation::Pairwise) == 14);
+    }
+
+    SUBCASE("Results are bitwise identical for any thread count") {
+        std::mt19937 gen(11);
+        std::uniform_real_distribution<double> dist(-1e3, 1e3);
+        std::vector<std::vector<double>> data(400, std::vector<double>(300));
+        for (auto& row : data) {
+            for (auto& x : row) {
+                x = dist(gen);
+            }
+        }
+        Matrix M(data);
+        Matrix V = M.extractRow(0).hStack(M.extractRow(1)).hStack(M.extractRow(2));
+
+        const int saved = omp_get_max_threads();
+        std::vector<double> reference;
+
+        for (int threads : { 1, 2, 3, 7 }) {
+            omp_set_num_threads(threads);
+            std::vector<double> results;
+            for (Summation method : { Summation::Naive, Summation::Pairwise, Summation::Kahan }) {
+                Matrix all = M.sum(Axis::All, method);
+                Matrix rows = M.sum(Axis::Rows, method);
+                Matrix cols = M.sum(Axis::Columns, method);
+                results.push_back(all(0, 0));
+                results.push_back(rows(0, 17));
+                results.push_back(cols(123, 0));
+                results.push_back(V.sum(method));
+                results.push_back(V.sum(3, method));
+            }
+            if (reference.empty()) {
+                reference = results;
+            }
+            CHECK(results == reference);
+        }
+
+        omp_set_num_threads(saved);
+
+        // Neither the Reduction threshold nor the backend may change the blocking.
+        using matOpsParallel::Operation;
+        using matOpsParallel::Backend;
+
+        Matrix column = Matrix::constValMatrix(20000, 1, 0.0);
+        for (size_t i = 0; i < 20000; ++i) {
+            column(i, 0) = dist(gen);
+        }
+
+        auto sums = [&] {
+            std::vector<double> results;
+            for (Summation method : { Summation::Naive, Summation::Pairwise, Summation::Kahan }) {
+                Matrix rows = M.sum(Axis::Rows, method);
+                results.push_back(M.sum(Axis::All, method)(0, 0));
+                results.push_back(rows(0, 17));
+                results.push_back(rows(0, 299));
+                results.push_back(column.sum(Axis::Rows, method)(0, 0));
+                results.push_back(column.sum(method));
+                results.push_back(V.sum(method));
+            }
+            return results;
+        };
+
+        const Backend previous = matOpsParallel::getBackend();
+        matOpsParallel::setBackend(Backend::Serial);
+        matOpsParallel::resetThresholds();
+        reference = sums();
+
+        for (Backend backend : { Backend::OpenMP, Backend::ThreadPool }) {
+            matOpsParallel::setBackend(backend);
+            matOpsParallel::setNumThreads(3);
+            CAPTURE(static_cast<int>(backend));
+
+            for (size_t threshold : { size_t(0), size_t(OPENMP_THRESHOLD), std::numeric_limits<size_t>::max() }) {
+                CAPTURE(threshold);
+                matOpsParallel::setThreshold(Operation::Reduction, threshold);
+                CHECK(sums() == reference);
+            }
+        }
+
+        matOpsParallel::resetThresholds();
+        matOpsParallel::setNumThreads(0);
+        matOpsParallel::setBackend(previous);
+    }
+}
+
+TEST_CASE("Matrix norms and condition number estimates") {
+    Matrix A({ {1, -2},
+               {3, 4} });
+
+    SUBCASE("Norms") {
+        CHECK(A.norm(Norm::One) == 6);
+        CHECK(A.norm(Norm::Infinity) == 7);
+        CHECK(A.norm(Norm::Max) == 4);
+        CHECK(A.norm() == doctest::Approx(std::sqrt(30.0)));
+
+        Matrix huge = Matrix::constValMatrix(2, 2, 1e200);
+        CHECK(huge.norm() == doctest::Approx(2e200));
+        Matrix tiny = Matrix::constValMatrix(2, 2, 1e-200);
+        CHECK(tiny.norm() == doctest::Approx(2e-200));
+        CHECK(Matrix::constValMatrix(3, 3, 0.0).norm() == 0);
+    }
+
+    SUBCASE("2-norm estimate") {
+        // Singular values of A are sqrt(15 +- sqrt(125)).
+        CHECK(A.norm2Estimate() == doctest::Approx(std::sqrt(15 + std::sqrt(125.0))));
+        CHECK(Matrix::identity(50).norm2Estimate() == doctest::Approx(1));
+        CHECK(Matrix({ {3, 0, 0}, {0, -7, 0} }).norm2Estimate() == doctest::Approx(7));
+    }
+
+    SUBCASE("LU decomposition") {
+        Matrix M({ {2, 1, 1},
+                   {4, -6, 0},
+                   {-2, 7, 2} });
+        LUDecomposition lu(M);
+
+        Matrix PA = Matrix::constValMatrix(3, 3, 0.0);
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                PA(i, j) = M.toVector()[lu.permutation()[i]][j];
+            }
+        }
+        CHECK(lu.lower() * lu.upper() == PA);
+        CHECK(lu.determinant() == doctest::Approx(M.determinant()));
+
+        Matrix B({ {1, 2}, {3, 4}, {5, 6} });
+        CHECK(M * lu.solve(B) == B);
+        CHECK(M.transpose() * lu.solveTransposed(B) == B);
+
+        CHECK_THROWS_AS(LUDecomposition(Matrix({ {1, 2, 3} })), std::invalid_argument);
+        CHECK_THROWS_AS(lu.solve(Matrix({ {1, 2} })), std::invalid_argument);
+
+        LUDecomposition singular(Matrix({ {1, 2}, {2, 4} }));
+        CHECK(singular.isSingular());
+        CHECK(singular.determinant() == 0);
+        CHECK_THROWS_AS(singular.solve(Matrix({ {1}, {1} })), std::runtime_error);
+    }
+
+    SUBCASE("Condition estimate matches the exact 1-norm condition number") {
+        std::mt19937 gen(3);
+        std::uniform_real_distribution<double> dist(-1, 1);
+
+        for (size_t n : { 5, 40, 120 }) {
+            std::vector<std::vector<double>> data(n, std::vector<double>(n));
+            for (auto& row : data) {
+                for (auto& x : row) {
+                    x = dist(gen);
+                }
+            }
+            Matrix M(data);
+
+            const double exact = M.norm(Norm::One) * M.inverse().norm(Norm::One);
+            const double estimate = M.conditionEstimate();
+            CHECK(estimate <= exact * (1 + 1e-9));
+            CHECK(estimate >= exact / 3);
+        }
+
+        // Hilbert matrices are the classic ill-conditioned example.
+        std::vector<std::vector<double>> hilbert(8, std::vector<double>(8));
+        for (size_t i = 0; i < 8; ++i) {
+            for (size_t j = 0; j < 8; ++j) {
+                hilbert[i][j] = 1.0 / (i + j + 1);
+            }
+        }
+        CHECK(Matrix(hilbert).conditionEstimate() > 1e9);
+        CHECK(Matrix({ {1, 2}, {2, 4} }).conditionEstimate() == std::numeric_limits<double>::infinity());
+    }
+}
+
+TEST_CASE("Covariance, correlation and streaming covariance") {
+    std::mt19937 gen(5);
+    std::normal_distribution<double> dist(0, 1);
+
+    // 500 observations of 70 variables, with a large offset to stress the centering.
+    const size_t m = 500, n = 70;
+    std::vector<std::vector<double>> data(m, std::vector<double>(n));
+    for (auto& row : data) {
+        const double shared = dist(gen);
+        for (size_t j = 0; j < n; ++j) {
+            row[j] = 1e4 + j + shared * (j % 3) + dist(gen);
+        }
+    }
+    Matrix X(data);
+
+    // Reference: explicit two-pass centering and product.
+    std::vector<double> mu(n, 0.0);
+    for (const auto& row : data) {
+        for (size_t j = 0; j < n; ++j) {
+            mu[j] += row[j] / m;
+        }
+    }
+    std::vector<std::vector<double>> centered = data;
+    for (auto& row : centered) {
+        for (size_t j = 0; j < n; ++j) {
+            row[j] -= mu[j];
+        }
+    }
+    Matrix Xc(centered);
+    Matrix reference = Xc.transpose() * Xc / static_cast<double>(m - 1);
+
+    SUBCASE("cov and corr") {
+        CHECK((X.cov() - reference).norm(Norm::Max) < 1e-10);
+        CHECK((X.cov(0) * (m / static_cast<double>(m - 1)) - reference).norm(Norm::Max) < 1e-10);
+
+        Matrix R = X.corr();
+        const Matrix& ref = reference;
+        size_t bad = 0;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                const double expected = ref(i, j) / std::sqrt(ref(i, i) * ref(j, j));
+                bad += std::abs(R(i, j) - expected) > 1e-12;
+            }
+        }
+        CHECK(bad == 0);
+        CHECK(R(5, 5) == 1.0);
+
+        Matrix small({ {1, 2}, {2, 4}, {3, 6} });
+        CHECK(small.cov() == Matrix({ {1, 2}, {2, 4} }));
+        CHECK(small.corr() == Matrix({ {1, 1}, {1, 1} }));
+        CHECK(std::isnan(Matrix({ {1, 5}, {2, 5} }).corr()(0, 1)));
+
+        CHECK_THROWS_AS(Matrix({ {1, 2} }).cov(), std::invalid_argument);
+    }
+
+    SUBCASE("syrk with a shift") {
+        Matrix G = SymmetricMatrix::syrk(X, mu).toDense();
+        CHECK((G - Xc.transpose() * Xc).norm(Norm::Max) < 1e-8);
+        CHECK_THROWS_AS(SymmetricMatrix::syrk(X, std::vector<double>(3, 0.0)), std::invalid_argument);
+    }
+
+    SUBCASE("Streaming batches match the full computation") {
+        RunningCovariance rc(n);
+        size_t start = 0;
+        for (size_t batch : { 1, 7, 100, 250, 142 }) {
+            rc.update(X.extractMatrix({start, start + batch}, {0, n}));
+            start += batch;
+        }
+
+        CHECK(rc.count() == m);
+        CHECK((rc.mean() - X.mean(Axis::Rows)).norm(Norm::Max) < 1e-9);
+        CHECK((rc.covariance() - reference).norm(Norm::Max) < 1e-10);
+        CHECK((rc.correlation() - X.corr()).norm(Norm::Max) < 1e-12);
+
+        CHECK_THROWS_AS(rc.update(Matrix({ {1, 2} })), std::invalid_argument);
+        CHECK_THROWS_AS(RunningCovariance(3).covariance(), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Pairwise distance matrices") {
+    std::mt19937 gen(9);
+    std::uniform_real_distribution<double> dist(-2, 2);
+
+    auto randomPoints = [&](size_t n, size_t d) {
+        std::vector<std::vector<double>> p(n, std::vector<double>(d));
+        for (auto& row : p) {
+            for (auto& x : row) {
+                x = dist(gen);
+            }
+        }
+        return p;
+    };
+
+    const std::vector<std::vector<double>> xs = randomPoints(150, 13), ys = randomPoints(300, 13);
+    Matrix X(xs), Y(ys);
+
+    auto reference = [&](size_t i, size_t j, DistanceMetric metric) {
+        double l1 = 0, l2 = 0, dot = 0, nx = 0, ny = 0;
+        for (size_t k = 0; k < 13; ++k) {
+            l1 += std::abs(xs[i][k] - ys[j][k]);
+            l2 += (xs[i][k] - ys[j][k]) * (xs[i][k] - ys[j][k]);
+            dot += xs[i][k] * ys[j][k];
+            nx += xs[i][k] * xs[i][k];
+            ny += ys[j][k] * ys[j][k];
+        }
+        switch (metric) {
+            case DistanceMetric::Euclidean:        return std::sqrt(l2);
+            case DistanceMetric::SquaredEuclidean: return l2;
+            case DistanceMetric::Cosine:           return 1 - dot / std::sqrt(nx * ny);
+            default:                               return l1;
+        }
+    };
+
+    const DistanceMetric metrics[] = { DistanceMetric::Euclidean, DistanceMetric::SquaredEuclidean,
+                                       DistanceMetric::Cosine, DistanceMetric::Manhattan };
+
+    SUBCASE("Dense output matches the definitions") {
+        for (DistanceMetric metric : metrics) {
+            Matrix D = Matrix::pairwiseDistances(X, Y, metric);
+            CHECK(D.shape() == std::make_pair<size_t, size_t>(150, 300));
+
+            size_t bad = 0;
+            for (size_t i = 0; i < 150; ++i) {
+                for (size_t j = 0; j < 300; ++j) {
+                    bad += std::abs(D(i, j) - reference(i, j, metric)) > 1e-10;
+                }
+            }
+            CHECK(bad == 0);
+        }
+
+        CHECK_THROWS_AS(Matrix::pairwiseDistances(X, Matrix::constValMatrix(2, 3, 0.0)), std::invalid_argument);
+    }
+
+    SUBCASE("Self distances have an exact zero diagonal") {
+        Matrix D = Matrix::pairwiseDistances(X, X);
+        Matrix C = Matrix::pairwiseDistances(X, X, DistanceMetric::Cosine);
+        for (size_t i = 0; i < 150; i += 17) {
+            CHECK(D(i, i) == 0.0);
+            CHECK(C(i, i) == 0.0);
+        }
+
+        Matrix Z({ {0, 0}, {1, 0} });
+        Matrix Dz = Matrix::pairwiseDistances(Z, Z, DistanceMetric::Cosine);
+        CHECK(Dz(0, 1) == 1.0);
+        CHECK(Dz(0, 0) == 1.0);
+        CHECK(Dz(1, 1) == 0.0);
+
+        Matrix::pairwiseDistances(Z, Z, DistanceMetric::Cosine, 1, [](size_t r0, size_t c0, const Matrix& tile) {
+            if (r0 == c0) {
+                CHECK(tile(0, 0) == (r0 == 0 ? 1.0 : 0.0));
+            }
+        });
+    }
+
+    SUBCASE("Blocked output covers every pair exactly once") {
+        for (DistanceMetric metric : metrics) {
+            Matrix full = Matrix::pairwiseDistances(X, Y, metric);
+            Matrix assembled = Matrix::constValMatrix(150, 300, -1.0);
+            size_t tiles = 0;
+
+            Matrix::pairwiseDistances(X, Y, metric, 64, [&](size_t r0, size_t c0, const Matrix& tile) {
+                ++tiles;
+                for (size_t i = 0; i < tile.shape().first; ++i) {
+                    for (size_t j = 0; j < tile.shape().second; ++j) {
+                        assembled(r0 + i, c0 + j) = tile.toVector()[i][j];
+                    }
+                }
+            });
+
+            CHECK(tiles == 3 * 5);
+            CHECK(assembled == full);
+        }
+
+        size_t calls = 0;
+        Matrix::pairwiseDistances(X, X, DistanceMetric::Euclidean, 100, [&](size_t r0, size_t c0, const Matrix& tile) {
+            ++calls;
+            if (r0 == c0) {
+                CHECK(tile(7, 7) == 0.0);
+            }
+        });
+        CHECK(calls == 4);
+        CHECK_THROWS_AS(Matrix::pairwiseDistances(X, Y, DistanceMetric::Euclidean, 0, [](size_t, size_t, const Matrix&) {}), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Approximate comparison: allclose, isclose and ULP distance") {
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    SUBCASE("allclose uses absolute and relative tolerances") {
+        Matrix A({ {1e10, 1, -inf} });
+        Matrix B({ {1e10 + 1, 1 + 1e-9, -inf} });
+
+        CHECK(A != B);
+        CHECK(Matrix::allclose(A, B));
+        CHECK_FALSE(Matrix::allclose(A, B, 0, 1e-8));
+        CHECK_FALSE(Matrix::allclose(A, Matrix({ {1e10, 1.1, -inf} })));
+        CHECK_FALSE(Matrix::allclose(A, Matrix({ {1e10, 1, inf} })));
+        CHECK_FALSE(Matrix::allclose(Matrix::constValMatrix(1, 1, nan), Matrix::constValMatrix(1, 1, nan)));
+        CHECK_FALSE(Matrix::allclose(A, A.transpose()));
+    }
+
+    SUBCASE("isclose returns a mask") {
+        Matrix A({ {1, 2, 3},
+                   {4, 5, 6} });
+        Matrix B({ {1, 2.5, 3 + 1e-12} });
+        CHECK(Matrix::isclose(A, B) == Matrix({ {1, 0, 1}, {0, 0, 0} }));
+        CHECK(Matrix::isclose(A, A + 0.01, 0.01) == Matrix::constValMatrix(2, 3, 1.0));
+        CHECK_THROWS_AS(Matrix::isclose(A, Matrix({ {1, 2} })), std::invalid_argument);
+    }
+
+    SUBCASE("ULP distance") {
+        const double one = 1.0;
+        const double next = std::nextafter(one, 2.0);
+        const double prev = std::nextafter(one, 0.0);
+
+        CHECK(matOpsDetail::ulpDistance(one, one) == 0);
+        CHECK(matOpsDetail::ulpDistance(one, next) == 1);
+        CHECK(matOpsDetail::ulpDistance(prev, next) == 2);
+        CHECK(matOpsDetail::ulpDistance(0.0, -0.0) == 0);
+        CHECK(matOpsDetail::ulpDistance(-std::numeric_limits<double>::denorm_min(), std::numeric_limits<double>::denorm_min()) == 2);
+        CHECK(matOpsDetail::ulpDistance(nan, 1.0) == std::numeric_limits<uint64_t>::max());
+
+        Matrix A({ {1, 1e300, -1e-300} });
+        Matrix B({ {std::nextafter(1.0, 2.0), std::nextafter(1e300, 0.0), -1e-300} });
+        CHECK(Matrix::ulpClose(A, B, 1));
+        CHECK_FALSE(Matrix::ulpClose(A, B, 0));
+        CHECK_FALSE(Matrix::ulpClose(A, A.transpose()));
+    }
+
+    SUBCASE("Large matrices and early exit") {
+        Matrix L = Matrix::constValMatrix(400, 300, 1.0);
+        Matrix M = L * (1 + 1e-15);
+        CHECK(Matrix::allclose(L, M, 1e-14, 0));
+        CHECK(Matrix::ulpClose(L, M, 8));
+        CHECK(L == M);
+
+        M(0, 0) = 2;
+        M(399, 299) = 2;
+        CHECK_FALSE(Matrix::allclose(L, M));
+        CHECK_FALSE(Matrix::ulpClose(L, M, 8));
+        CHECK(L != M);
+    }
+}
+
+TEST_CASE("Content hash and version stamps") {
+    SUBCASE("xxHash64 reference value") {
+        const uint64_t none[1] = { 0 };
+        CHECK(matOpsDetail::xxHash64(none, 0, 0) == 0xEF46DB3751D8E999ULL);
+    }
+
+    SUBCASE("Equal contents hash equally") {
+        Matrix A({ {1, 2, 3}, {4, 5, 6} });
+        Matrix B({ {1, 2, 3}, {4, 5, 6} });
+        CHECK(A.hash() == B.hash());
+        CHECK(A.hash() == A.hash());
+        CHECK(A.version() != B.version());
+
+        Matrix C = A;
+        CHECK(C.version() != A.version());
+        CHECK(C.hash() == A.hash());
+
+        Matrix D = A + 1.0;
+        CHECK(D.hash() != A.hash());
+        CHECK(D.hash() == (Matrix({ {2, 3, 4}, {5, 6, 7} })).hash());
+
+        CHECK(A.hash() != A.transpose().hash());
+        CHECK(A.hash() != Matrix({ {1, 2, 3, 4, 5, 6} }).hash());
+        CHECK(Matrix::constValMatrix(1, 1, 0.0).hash() != Matrix::constValMatrix(1, 1, -0.0).hash());
+    }
+
+    SUBCASE("Mutations renew the version and the hash") {
+        Matrix A({ {1, 2}, {3, 4} });
+        const uint64_t h = A.hash();
+        uint64_t v = A.version();
+
+        A(0, 1) = 7;
+        CHECK(A.version() > v);
+        CHECK(A.hash() != h);
+
+        A(0, 1) = 2;
+        CHECK(A.hash() == h);
+
+        v = A.version();
+        A.applyInPlace([](double x) { return x * 2; });
+        CHECK(A.version() > v);
+        CHECK(A.hash() == (Matrix({ {1, 2}, {3, 4} }) * 2).hash());
+
+        v = A.version();
+        A.zipInPlace(Matrix({ {1, 1} }), [](double a, double b) { return a - b; });
+        CHECK(A.version() > v);
+
+        v = A.version();
+        A.shuffleRows(3);
+        CHECK(A.version() > v);
+
+        // Writes only mark the matrix; one stamp is drawn when the version is read.
+        v = A.version();
+        for (size_t k = 0; k < 1000; ++k) {
+            A(k % 2, 0) += 0.0;
+        }
+        const uint64_t after = A.version();
+        CHECK(after > v);
+        CHECK(after - v < 1000);
+        CHECK(A.version() == after);
+
+        const Matrix& cref = A;
+        v = A.version();
+        CHECK(cref(0, 0) + cref(1, 0) == 6);
+        CHECK(cref.version() == v);
+        CHECK_THROWS_AS(cref(2, 0), std::out_of_range);
+    }
+
+    SUBCASE("Large matrices hash identically for any thread count") {
+        std::vector<std::vector<double>> data(300, std::vector<double>(5000));
+        for (size_t i = 0; i < 300; ++i) {
+            for (size_t j = 0; j < 5000; ++j) {
+                data[i][j] = std::sin(0.37 * i + 0.011 * j);
+            }
+        }
+        Matrix L(data);
+        const int threads = omp_get_max_threads();
+        std::vector<uint64_t> hashes;
+        for (int t : {1, 2, 5}) {
+            omp_set_num_threads(t);
+            Matrix copy = L.apply([](double x) { return x; });
+            hashes.push_back(copy.hash());
+        }
+        omp_set_num_threads(threads);
+
+        CHECK(hashes[0] == hashes[1]);
+        CHECK(hashes[0] == hashes[2]);
+        CHECK(hashes[0] == L.hash());
+
+        L(299, 4999) += 1;
+        CHECK(L.hash() != hashes[0]);
+    }
+}
+
+TEST_CASE("Parallel backends and the work-stealing thread pool") {
+    using matOpsParallel::Backend;
+    using matOpsParallel::Schedule;
+
+    SUBCASE("ThreadPool runs every submitted task") {
+        std::atomic<int> count(0);
+        {
+            matOpsParallel::ThreadPool pool(3);
+            CHECK(pool.size() == 3);
+            CHECK_FALSE(pool.isWorkerThread());
+            for (int t = 0; t < 200; ++t) {
+                pool.submit([&count] { ++count; });
+            }
+        }
+        CHECK(count.load() == 200);
+    }
+
+    SUBCASE("Every backend runs loops completely and gives identical results") {
+        const Backend previous = matOpsParallel::getBackend();
+        matOpsParallel::setNumThreads(4);
+
+        for (Backend backend : {Backend::Serial, Backend::OpenMP, Backend::ThreadPool}) {
+            matOpsParallel::setBackend(backend);
+            CAPTURE(static_cast<int>(backend));
+
+            // Every index is visited exactly once, whatever the schedule.
+            std::vector<int> hits(1000, 0);
+            matOpsParallel::parallelFor(0, hits.size(), true, [&](size_t i) { ++hits[i]; });
+            matOpsParallel::parallelFor(0, hits.size(), true, [&](size_t i) { ++hits[i]; }, Schedule::Dynamic, 7);
+            matOpsParallel::parallelForRange(5, hits.size(), true, [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; ++i) {
+                    ++hits[i];
+                }
+            });
+            CHECK(std::count(hits.begin(), hits.begin() + 5, 2) == 5);
+            CHECK(std::count(hits.begin() + 5, hits.end(), 3) == 995);
+
+            // Nested loops complete, including from inside pool workers.
+            std::atomic<size_t> nested(0);
+            matOpsParallel::parallelFor(0, 8, true, [&](size_t) {
+                matOpsParallel::parallelFor(0, 100, true, [&](size_t) { ++nested; }, Schedule::Dynamic);
+            });
+            CHECK(nested.load() == 800);
+
+            // Exceptions reach the caller.
+            CHECK_THROWS_AS(matOpsParallel::parallelFor(0, 100, true, [](size_t i) {
+                if (i == 42) {
+                    throw std::runtime_error("failed");
+                }
+            }), std::runtime_error);
+
+            // Results do not depend on the backend.
+            std::vector<std::vector<double>> data(150, std::vector<double>(120));
+            for (size_t i = 0; i < 150; ++i) {
+                for (size_t j = 0; j < 120; ++j) {
+                    data[i][j] = std::cos(0.13 * i - 0.07 * j);
+                }
+            }
+            Matrix A(data);
+            Matrix P = A * A.transpose();
+
+            matOpsParallel::setBackend(Backend::Serial);
+            Matrix expected = A * A.transpose();
+            Matrix expectedSum = A.sum(Axis::Rows, Summation::Kahan);
+            matOpsParallel::setBackend(backend);
+
+            CHECK(P.hash() == expected.hash());
+            CHECK(A.sum(Axis::Rows, Summation::Kahan).hash() == expectedSum.hash());
+
+            Matrix S = P + Matrix::identity(150);
+            CHECK(Matrix::allclose(S.inverse() * S, Matrix::identity(150), 1e-8, 1e-8));
+        }
+
+        matOpsParallel::setNumThreads(0);
+        matOpsParallel::setBackend(previous);
+        CHECK(matOpsParallel::getBackend() == previous);
+    }
+}
+
+TEST_CASE("Per-operation parallel thresholds and wisdom files") {
+    using matOpsParallel::Operation;
+
+    matOpsParallel::resetThresholds();
+
+    SUBCASE("Defaults and setters") {
+        CHECK(matOpsParallel::getThreshold(Operation::Elementwise) == OPENMP_THRESHOLD);
+        CHECK(matOpsParallel::getThreshold(Operation::Multiply) == 100 * OPENMP_THRESHOLD);
+
+        matOpsParallel::setThreshold(Operation::Transpose, 50);
+        CHECK(matOpsParallel::getThreshold(Operation::Transpose) == 50);
+        CHECK(matOpsParallel::exceedsThreshold(Operation::Transpose, 51));
+        CHECK_FALSE(matOpsParallel::exceedsThreshold(Operation::Transpose, 50));
+        CHECK(matOpsParallel::getThreshold(Operation::Elementwise) == OPENMP_THRESHOLD);
+
+        matOpsParallel::resetThresholds();
+        CHECK(matOpsParallel::getThreshold(Operation::Transpose) == OPENMP_THRESHOLD);
+    }
+
+    SUBCASE("Results do not depend on the thresholds") {
+        std::vector<std::vector<double>> data(40, std::vector<double>(30));
+        for (size_t i = 0; i < 40; ++i) {
+            for (size_t j = 0; j < 30; ++j) {
+                data[i][j] = std::sin(0.5 * i + 0.3 * j);
+            }
+        }
+        Matrix A(data);
+        const Operation all[] = { Operation::Elementwise, Operation::Transpose, Operation::Reduction,
+                                  Operation::Multiply, Operation::Factorization, Operation::Sparse,
+                                  Operation::Structured };
+
+        Matrix G = A.transpose() * A + Matrix::identity(30);
+        Matrix expected = LUDecomposition(G).solve(A.transpose()) + A.transpose().sum(Axis::Rows, Summation::Pairwise);
+
+        matOpsParallel::setNumThreads(3);
+        for (Operation op : all) {
+            matOpsParallel::setThreshold(op, 0);
+        }
+        Matrix Gp = A.transpose() * A + Matrix::identity(30);
+        Matrix result = LUDecomposition(Gp).solve(A.transpose()) + A.transpose().sum(Axis::Rows, Summation::Pairwise);
+        matOpsParallel::setNumThreads(0);
+        matOpsParallel::resetThresholds();
+
+        CHECK(Gp.hash() == G.hash());
+        CHECK(result.hash() == expected.hash());
+    }
+
+    SUBCASE("Wisdom files") {
+        const std::string path = "matops_test.wisdom";
+        std::remove(path.c_str());
+        CHECK_FALSE(matOpsParallel::loadWisdom(path));
+
+        matOpsParallel::setThreshold(Operation::Multiply, 12345);
+        matOpsParallel::saveWisdom(path);
+        matOpsParallel::resetThresholds();
+        CHECK(matOpsParallel::loadWisdom(path));
+        CHECK(matOpsParallel::getThreshold(Operation::Multiply) == 12345);
+
+        // Thresholds measured for another backend or thread count are not applied.
+        const matOpsParallel::Backend previous = matOpsParallel::getBackend();
+        matOpsParallel::resetThresholds();
+        matOpsParallel::setBackend(matOpsParallel::Backend::ThreadPool);
+        matOpsParallel::setNumThreads(matOpsParallel::getNumThreads() + 1);
+        CHECK_FALSE(matOpsParallel::loadWisdom(path));
+        CHECK(matOpsParallel::getThreshold(Operation::Multiply) == 100 * OPENMP_THRESHOLD);
+        matOpsParallel::setNumThreads(0);
+        matOpsParallel::setBackend(previous);
+
+        {
+            std::ofstream out(path);
+            out << "backend openmp\nthreads 2\nmultiply lots\n";
+        }
+        CHECK_THROWS_AS(matOpsParallel::loadWisdom(path), std::runtime_error);
+        CHECK_THROWS_AS(matOpsParallel::saveWisdom("no_such_directory/matops.wisdom"), std::runtime_error);
+
+        std::remove(path.c_str());
+    }
+
+    SUBCASE("Calibration and tune()") {
+        const std::string path = "matops_tune.wisdom";
+        std::remove(path.c_str());
+
+        matOpsParallel::setNumThreads(2);
+        matOpsParallel::tune(path);
+        const size_t tuned = matOpsParallel::getThreshold(Operation::Elementwise);
+
+        matOpsParallel::resetThresholds();
+        matOpsParallel::tune(path);
+        CHECK(matOpsParallel::getThreshold(Operation::Elementwise) == tuned);
+
+        matOpsParallel::setNumThreads(1);
+        matOpsParallel::calibrate();
+        CHECK(matOpsParallel::getThreshold(Operation::Multiply) == std::numeric_limits<size_t>::max());
+        CHECK_FALSE(matOpsParallel::exceedsThreshold(Operation::Multiply, std::numeric_limits<size_t>::max()));
+
+        matOpsParallel::setNumThreads(0);
+        matOpsParallel::resetThresholds();
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("GEMM blocking and planner wisdom") {
+    using matOpsGemm::ShapeClass;
+    using matOpsGemm::Blocking;
+
+    matOpsGemm::resetBlocking();
+
+    SUBCASE("Shape classes") {
+        CHECK(matOpsGemm::classify(100, 100, 100) == ShapeClass::Square);
+        CHECK(matOpsGemm::classify(1000, 100, 100) == ShapeClass::Tall);
+        CHECK(matOpsGemm::classify(100, 100, 1000) == ShapeClass::Wide);
+        CHECK(matOpsGemm::classify(100, 1000, 100) == ShapeClass::Deep);
+
+        CHECK_THROWS_AS(matOpsGemm::setBlocking(ShapeClass::Square, Blocking{ 0, 8, 8 }), std::invalid_argument);
+    }
+
+    SUBCASE("Products do not depend on the blocking") {
+        std::vector<std::vector<double>> a(37, std::vector<double>(53)), b(53, std::vector<double>(29));
+        for (size_t i = 0; i < 37; ++i) {
+            for (size_t j = 0; j < 53; ++j) {
+                a[i][j] = std::sin(0.3 * i + 0.7 * j);
+            }
+        }
+        for (size_t i = 0; i < 53; ++i) {
+            for (size_t j = 0; j < 29; ++j) {
+                b[i][j] = std::cos(0.2 * i - 0.5 * j);
+            }
+        }
+        Matrix A(a), B(b);
+
+        // Reference: the textbook triple loop.
+        std::vector<std::vector<double>> ref(37, std::vector<double>(29, 0.0));
+        for (size_t i = 0; i < 37; ++i) {
+            for (size_t k = 0; k < 53; ++k) {
+                for (size_t j = 0; j < 29; ++j) {
+                    ref[i][j] += a[i][k] * b[k][j];
+                }
+            }
+        }
+        CHECK((A * B).hash() == Matrix(ref).hash());
+
+        matOpsParallel::setNumThreads(3);
+        matOpsParallel::setThreshold(matOpsParallel::Operation::Multiply, 0);
+        for (Blocking blocking : { Blocking{ 1, 1, 1 }, Blocking{ 5, 7, 3 }, Blocking{ 64, 16, 8 }, Blocking{ 100, 100, 100 } }) {
+            matOpsGemm::setBlocking(ShapeClass::Square, blocking);
+            CHECK((A * B).hash() == Matrix(ref).hash());
+        }
+
+        // Fewer rows than threads: the columns are split too.
+        matOpsGemm::resetBlocking();
+        for (size_t rows : { 1, 2, 4 }) {
+            std::vector<std::vector<double>> head(a.begin(), a.begin() + rows);
+            std::vector<std::vector<double>> expected(ref.begin(), ref.begin() + rows);
+            CHECK((Matrix(head) * B).hash() == Matrix(expected).hash());
+        }
+        matOpsParallel::resetThresholds();
+        matOpsParallel::setNumThreads(0);
+        matOpsGemm::resetBlocking();
+    }
+
+    SUBCASE("Tuning and wisdom keyed by CPU model") {
+        const Blocking tuned = matOpsGemm::tune(ShapeClass::Wide);
+        const Blocking current = matOpsGemm::getBlocking(ShapeClass::Wide);
+        CHECK(current.rowPanel == tuned.rowPanel);
+        CHECK(current.depthPanel == tuned.depthPanel);
+        CHECK(current.colPanel == tuned.colPanel);
+
+        const std::string path = "matops_gemm_test.wisdom";
+        {
+            std::ofstream out(path);
+            out << "square 8 8 8 Some Other CPU @ 1.00GHz\n";
+        }
+
+        CHECK(matOpsGemm::loadWisdom(path) == 0);
+        matOpsGemm::setBlocking(ShapeClass::Deep, Blocking{ 32, 64, 1024 });
+        matOpsGemm::saveWisdom(path);
+        matOpsGemm::resetBlocking();
+
+        CHECK(matOpsGemm::loadWisdom(path) == 4);
+        CHECK(matOpsGemm::getBlocking(ShapeClass::Deep).colPanel == 1024);
+        CHECK(matOpsGemm::getBlocking(ShapeClass::Square).rowPanel == matOpsGemm::defaultBlocking().rowPanel);
+        CHECK_FALSE(matOpsGemm::plan(path));
+
+        // The other CPU's entry survives the rewrite.
+        std::ifstream in(path);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        CHECK(contents.find("square 8 8 8 Some Other CPU @ 1.00GHz") != std::string::npos);
+        CHECK_THROWS_AS(matOpsGemm::saveWisdom("no_such_directory/gemm.wisdom"), std::runtime_error);
+
+        matOpsGemm::resetBlocking();
+        std::remove(path.c_str());
+    }
+}
+
+TEST_CASE("Asynchronous operations and continuations") {
+    matOpsParallel::setNumThreads(2);
+
+    Matrix A({ {4, 7, 2},
+               {3, 6, 1},
+               {2, 5, 3} });
+    Matrix B({ {1, 0, 2},
+               {0, 1, 0},
+               {3, 0, 1} });
+
+    SUBCASE("Futures match the synchronous results") {
+        matOpsAsync::Future<Matrix> product = matOpsAsync::multiply(A, B);
+        matOpsAsync::Future<Matrix> inv = matOpsAsync::inverse(A);
+        matOpsAsync::Future<double> det = matOpsAsync::determinant(A);
+        matOpsAsync::Future<Matrix> tr = matOpsAsync::transpose(A);
+
+        CHECK(product.valid());
+        CHECK(product.get() == A * B);
+        CHECK(product.isReady());
+        CHECK(inv.get() == A.inverse());
+        CHECK(det.get() == doctest::Approx(A.determinant()));
+        CHECK(tr.get() == A.transpose());
+        CHECK_FALSE(matOpsAsync::Future<Matrix>().valid());
+    }
+
+    SUBCASE("Continuations and combined inputs") {
+        matOpsAsync::Future<Matrix> AB = matOpsAsync::multiply(A, B);
+        matOpsAsync::Future<Matrix> BA = matOpsAsync::multiply(B, A);
+        matOpsAsync::Future<double> d = matOpsAsync::multiply(AB, BA)
+            .then([](const Matrix& P) { return P.determinant(); });
+        matOpsAsync::Future<Matrix> chain = matOpsAsync::transpose(matOpsAsync::inverse(AB));
+
+        CHECK(d.get() == doctest::Approx(((A * B) * (B * A)).determinant()));
+        CHECK(chain.get() == (A * B).inverse().transpose());
+        CHECK(matOpsAsync::determinant(BA).get() == doctest::Approx((B * A).determinant()));
+
+        matOpsAsync::Future<size_t> rows = matOpsAsync::combine(AB, d, [](const Matrix& m, double) {
+            return m.shape().first;
+        });
+        CHECK(rows.get() == 3);
+    }
+
+    SUBCASE("Exceptions propagate along a chain") {
+        Matrix singular({ {1, 2}, {2, 4} });
+        matOpsAsync::Future<Matrix> inv = matOpsAsync::inverse(singular);
+        matOpsAsync::Future<double> after = inv.then([](const Matrix& m) { return m.determinant(); });
+
+        CHECK_THROWS_AS(inv.get(), std::runtime_error);
+        CHECK_THROWS_AS(after.get(), std::runtime_error);
+        CHECK_THROWS_AS(matOpsAsync::multiply(A, singular).get(), std::invalid_argument);
+        CHECK_THROWS_AS(matOpsAsync::multiply(inv, matOpsAsync::transpose(A)).get(), std::runtime_error);
+    }
+
+    SUBCASE("Many independent requests and waits inside pool tasks") {
+        std::vector<matOpsAsync::Future<double>> results;
+        for (int r = 0; r < 50; ++r) {
+            Matrix M = A + static_cast<double>(r);
+            results.push_back(matOpsAsync::multiply(M, B).then([](const Matrix& P) { return P.determinant(); }));
+        }
+        for (int r = 0; r < 50; ++r) {
+            CHECK(results[r].get() == doctest::Approx(((A + static_cast<double>(r)) * B).determinant()));
+        }
+
+        // A task that waits for another pool task must not stall the pool.
+        matOpsAsync::Future<double> outer = matOpsAsync::async([&]() {
+            return matOpsAsync::determinant(matOpsAsync::multiply(A, B)).get() + 1.0;
+        });
+        CHECK(outer.get() == doctest::Approx((A * B).determinant() + 1.0));
+    }
+
+    matOpsParallel::setNumThreads(0);
+}
+
+TEST_CASE("Task graph deferred execution") {
+    matOpsParallel::setNumThreads(3);
+
+    Matrix a({ {1, 2}, {3, 4} });
+    Matrix b({ {0, 1}, {1, 0} });
+    Matrix c({ {2, 0}, {0, 2} });
+    Matrix d({ {1, 1}, {0, 1} });
+
+    SUBCASE("Expressions evaluate like their eager counterparts") {
+        matOpsGraph::TaskGraph g;
+        matOpsGraph::Expr A = g.input(a), B = g.input(b), C = g.input(c), D = g.input(d);
+
+        matOpsGraph::Expr sum = (A * B) + (C * D);
+        CHECK(g.size() == 7);
+        CHECK(g.run(sum) == (a * b) + (c * d));
+
+        matOpsGraph::Expr other = (2.0 * (A - D).transpose()).inverse();
+        std::vector<Matrix> both = g.run({ sum, other, A });
+        CHECK(both.size() == 3);
+        CHECK(both[0] == (a * b) + (c * d));
+        CHECK(both[1] == ((a - d).transpose() * 2.0).inverse());
+        CHECK(both[2] == a);
+
+        matOpsGraph::Expr custom = g.apply(sum, [](const Matrix& m) { return m.apply(matOpsMath::Sqrt()); });
+        CHECK(g.run(custom) == ((a * b) + (c * d)).apply(matOpsMath::Sqrt()));
+
+        matOpsGraph::Expr owned = g.input(Matrix::identity(2));
+        CHECK(g.run(owned * A) == a);
+    }
+
+    SUBCASE("Intermediates are freed after their last consumer") {
+        matOpsGraph::TaskGraph g;
+        matOpsGraph::Expr x = g.input(a);
+        for (int step = 0; step < 20; ++step) {
+            x = x * 0.5 + x.transpose();
+        }
+
+        Matrix expected = a;
+        for (int step = 0; step < 20; ++step) {
+            expected = expected * 0.5 + expected.transpose();
+        }
+
+        CHECK(Matrix::allclose(g.run(x), expected));
+        CHECK(g.peakIntermediates() <= 4);
+        CHECK(g.peakIntermediates() >= 1);
+    }
+
+    SUBCASE("Many independent products") {
+        matOpsGraph::TaskGraph g;
+        std::vector<Matrix> inputs;
+        for (int k = 0; k < 16; ++k) {
+            inputs.push_back(Matrix::constValMatrix(20, 20, 0.1 * k) + Matrix::identity(20));
+        }
+
+        matOpsGraph::Expr total = g.input(Matrix::constValMatrix(20, 20, 0.0));
+        Matrix expected = Matrix::constValMatrix(20, 20, 0.0);
+        for (int k = 0; k < 16; ++k) {
+            matOpsGraph::Expr X = g.input(inputs[k]);
+            total = total + X * X;
+            expected = expected + inputs[k] * inputs[k];
+        }
+        CHECK(g.run(total) == expected);
+    }
+
+    SUBCASE("Errors") {
+        matOpsGraph::TaskGraph g, h;
+        Matrix singular({ {1, 2}, {2, 4} });
+        matOpsGraph::Expr S = g.input(singular);
+        matOpsGraph::Expr bad = (S.inverse() * g.input(a)) + g.input(b);
+        CHECK_THROWS_AS(g.run(bad), std::runtime_error);
+        CHECK(g.run(S * S) == singular * singular);
+
+        matOpsGraph::Expr foreign = h.input(a);
+        CHECK_THROWS_AS(S * foreign, std::invalid_argument);
+        CHECK_THROWS_AS(g.run(foreign), std::invalid_argument);
+
+        matOpsGraph::Expr shape = g.input(a) * g.input(Matrix({ {1, 2, 3} }));
+        CHECK_THROWS_AS(g.run(shape), std::invalid_argument);
+    }
+
+    matOpsParallel::setNumThreads(0);
+}
+
+/**
+ * @brief Tests for NUMA-aware first-touch placement and thread binding.
+ */
+TEST_CASE("NUMA placement and thread binding") {
+    using matOpsParallel::Backend;
+    using matOpsParallel::Placement;
+    using matOpsParallel::Affinity;
+
+    std::vector<std::vector<double>> a(60, std::vector<double>(50));
+    std::vector<std::vector<double>> b(50, std::vector<double>(40));
+    for (size_t i = 0; i < 60; ++i) {
+        for (size_t j = 0; j < 50; ++j) {
+            a[i][j] = std::sin(0.3 * i + 0.7 * j);
+        }
+    }
+    for (size_t i = 0; i < 50; ++i) {
+        for (size_t j = 0; j < 40; ++j) {
+            b[i][j] = std::cos(0.2 * i - 0.5 * j);
+        }
+    }
+    const Matrix A(a);
+    const Matrix B(b);
+
+    SUBCASE("Topology lists every allowed CPU once") {
+        const std::vector<std::vector<int>>& nodes = matOpsParallel::numaNodes();
+        REQUIRE_FALSE(nodes.empty());
+
+        std::set<int> seen;
+        size_t total = 0;
+        for (const std::vector<int>& node : nodes) {
+            CHECK_FALSE(node.empty());
+            for (int cpu : node) {
+                CHECK(cpu >= 0);
+                seen.insert(cpu);
+                ++total;
+            }
+        }
+        CHECK(seen.size() == total);
+    }
+
+    SUBCASE("Every placement builds the same matrices") {
+        const Backend previous = matOpsParallel::getBackend();
+        const Placement previousPlacement = matOpsParallel::getPlacement();
+
+        matOpsParallel::setPlacement(Placement::Serial);
+        const Matrix product = A * B;
+        const Matrix sum = A + A;
+        const Matrix transposed = A.transpose();
+
+        matOpsParallel::setThreshold(matOpsParallel::Operation::Elementwise, 0);
+        matOpsParallel::setNumThreads(3);
+
+        for (Backend backend : {Backend::OpenMP, Backend::ThreadPool}) {
+            for (Placement placement : {Placement::Partitioned, Placement::Interleaved}) {
+                CAPTURE(static_cast<int>(backend));
+                CAPTURE(static_cast<int>(placement));
+                matOpsParallel::setBackend(backend);
+                matOpsParallel::setPlacement(placement);
+
+                CHECK(Matrix::constValMatrix(7, 5, 2.5) == Matrix(std::vector<std::vector<double>>(7, std::vector<double>(5, 2.5))));
+                CHECK(Matrix::identity(9).trace() == doctest::Approx(9.0));
+                CHECK((A * B).hash() == product.hash());
+                CHECK((A + A).hash() == sum.hash());
+                CHECK(A.transpose().hash() == transposed.hash());
+
+                Matrix copy = A;
+                CHECK(copy.hash() == A.hash());
+                CHECK(copy.version() != A.version());
+
+                Matrix assigned = Matrix::constValMatrix(1, 1, 0.0);
+                const uint64_t before = assigned.version();
+                assigned = B;
+                CHECK(assigned == B);
+                CHECK(assigned.version() != before);
+            }
+        }
+
+        matOpsParallel::setBackend(previous);
+        matOpsParallel::setPlacement(previousPlacement);
+        CHECK(matOpsParallel::getPlacement() == previousPlacement);
+        matOpsParallel::resetThresholds();
+        matOpsParallel::setNumThreads(0);
+    }
+
+#ifdef __linux__
+    SUBCASE("Workers are bound to single CPUs") {
+        auto boundCpus = [] {
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask);
+            return static_cast<int>(CPU_COUNT(&mask));
+        };
+        const int unbound = boundCpus();
+        const Backend previous = matOpsParallel::getBackend();
+        const Affinity previousAffinity = matOpsParallel::getAffinity();
+        matOpsParallel::setNumThreads(2);
+
+        for (Affinity affinity : {Affinity::Compact, Affinity::Scatter}) {
+            CAPTURE(static_cast<int>(affinity));
+            matOpsParallel::setAffinity(affinity);
+            CHECK(matOpsParallel::getAffinity() == affinity);
+
+            // Pool workers bind when the pool is rebuilt; the caller stays unbound.
+            matOpsParallel::setBackend(Backend::ThreadPool);
+            CHECK(matOpsAsync::async(boundCpus).get() == 1);
+            CHECK(boundCpus() == unbound);
+
+            // OpenMP workers bind at their next loop; the calling thread runs chunk 0 unbound.
+            matOpsParallel::setBackend(Backend::OpenMP);
+            std::vector<int> counts(2, 0);
+            matOpsParallel::parallelFor(0, 2, true, [&](size_t i) {
+                counts[i] = boundCpus();
+            });
+            CHECK(counts[0] == unbound);
+            CHECK(counts[1] == 1);
+            CHECK(boundCpus() == unbound);
+        }
+
+        matOpsParallel::setAffinity(Affinity::None);
+        matOpsParallel::parallelFor(0, 2, true, [](size_t) {});
+        CHECK(boundCpus() == unbound);
+        matOpsParallel::setBackend(Backend::ThreadPool);
+        CHECK(matOpsAsync::async(boundCpus).get() == unbound);
+
+        matOpsParallel::setAffinity(previousAffinity);
+        matOpsParallel::setBackend(previous);
+        matOpsParallel::setNumThreads(0);
+    }
+#endif
+}
+
+/**
+ * @brief Tests for execution contexts and the serial fallback of nested loops.
+ */
+TEST_CASE("Execution contexts and nested parallelism") {
+    using matOpsParallel::Backend;
+    using matOpsParallel::ExecutionContext;
+    using matOpsParallel::ScopedContext;
+
+    const Backend global = matOpsParallel::getBackend();
+    Matrix A = Matrix::constValMatrix(30, 20, 0.0);
+    Matrix B = Matrix::constValMatrix(20, 10, 0.0);
+    for (size_t i = 0; i < 30; ++i) {
+        for (size_t j = 0; j < 20; ++j) {
+            A(i, j) = std::sin(0.4 * i + 0.1 * j);
+        }
+    }
+    for (size_t i = 0; i < 20; ++i) {
+        for (size_t j = 0; j < 10; ++j) {
+            B(i, j) = std::cos(0.3 * i - 0.2 * j);
+        }
+    }
+
+    SUBCASE("A scoped context overrides the global settings on its own thread") {
+        ExecutionContext defaults;
+        CHECK(defaults.backend == global);
+        CHECK(defaults.affinity == matOpsParallel::getAffinity());
+        CHECK_FALSE(defaults.deterministic);
+
+        ExecutionContext context;
+        context.backend = Backend::ThreadPool;
+        context.threads = 3;
+        context.deterministic = true;
+
+        {
+            ScopedContext scope(context);
+            CHECK(matOpsParallel::getBackend() == Backend::ThreadPool);
+            CHECK(matOpsParallel::getNumThreads() == 3);
+            CHECK(matOpsParallel::isDeterministic());
+            CHECK(matOpsParallel::currentContext().threads == 3);
+
+            Backend seen = Backend::Serial;
+            std::thread other([&seen] { seen = matOpsParallel::getBackend(); });
+            other.join();
+            CHECK(seen == global);
+
+            {
+                ScopedContext inner(ExecutionContext::serial());
+                CHECK(matOpsParallel::getBackend() == Backend::Serial);
+                CHECK(matOpsParallel::getNumThreads() == 1);
+            }
+            CHECK(matOpsParallel::getNumThreads() == 3);
+        }
+
+        CHECK(matOpsParallel::getBackend() == global);
+        CHECK_FALSE(matOpsParallel::isDeterministic());
+    }
+
+    SUBCASE("Contexts passed to operations, futures and task graphs") {
+        const Matrix expected = A * B;
+        const Matrix product = matOpsParallel::withContext(ExecutionContext::serial(), [&] { return A * B; });
+        CHECK(product.hash() == expected.hash());
+
+        matOpsAsync::Future<Backend> backend = matOpsParallel::withContext(ExecutionContext::serial(), [] {
+            return matOpsAsync::async([] { return matOpsParallel::getBackend(); });
+        });
+        CHECK(backend.get() == Backend::Serial);
+
+        ExecutionContext two;
+        two.backend = Backend::ThreadPool;
+        two.threads = 2;
+        ScopedContext scope(two);
+
+        matOpsGraph::TaskGraph g;
+        matOpsGraph::Expr threads = g.apply(g.input(A), [](const Matrix&) {
+            return Matrix::constValMatrix(1, 1, static_cast<double>(matOpsParallel::getNumThreads()));
+        });
+        CHECK(g.run(threads)(0, 0) == 2.0);
+        CHECK(matOpsAsync::multiply(A, B).get().hash() == expected.hash());
+    }
+
+    SUBCASE("Loops nested in a parallel loop or an OpenMP region run serially") {
+        CHECK_FALSE(matOpsParallel::inParallelRegion());
+        matOpsParallel::setNumThreads(3);
+
+        for (Backend backend : {Backend::OpenMP, Backend::ThreadPool}) {
+            CAPTURE(static_cast<int>(backend));
+            matOpsParallel::setBackend(backend);
+
+            std::vector<int> serialInside(6, 0);
+            matOpsParallel::parallelFor(0, 6, true, [&](size_t i) {
+                const std::thread::id self = std::this_thread::get_id();
+                bool sameThread = true;
+                matOpsParallel::parallelFor(0, 64, true, [&](size_t) {
+                    if (std::this_thread::get_id() != self) {
+                        sameThread = false;
+                    }
+                });
+                serialInside[i] = matOpsParallel::inParallelRegion() && sameThread;
+            });
+            CHECK(std::count(serialInside.begin(), serialInside.end(), 1) == 6);
+
+            std::vector<int> serialInRegion(2, 1);
+            #pragma omp parallel num_threads(2)
+            {
+                const std::thread::id self = std::this_thread::get_id();
+                int sameThread = 1;
+                matOpsParallel::parallelFor(0, 64, true, [&](size_t) {
+                    if (std::this_thread::get_id() != self) {
+                        sameThread = 0;
+                    }
+                });
+                serialInRegion[static_cast<size_t>(omp_get_thread_num()) % 2] = sameThread;
+            }
+            CHECK(serialInRegion[0] == 1);
+            CHECK(serialInRegion[1] == 1);
+        }
+
+        matOpsParallel::setBackend(global);
+        matOpsParallel::setNumThreads(0);
+        CHECK_FALSE(matOpsParallel::inParallelRegion());
+    }
+
+#if defined(__linux__) && defined(_OPENMP)
+    SUBCASE("OpenMP teams bind to the CPU slice of their context") {
+        using matOpsParallel::Affinity;
+        const std::vector<int>& order = matOpsParallel::detail::cpuOrder(Affinity::Compact);
+        REQUIRE_FALSE(order.empty());
+
+        ExecutionContext context;
+        context.backend = Backend::OpenMP;
+        context.threads = 2;
+        context.affinity = Affinity::Compact;
+        CHECK(context.cpuOffset == 0);
+
+        for (size_t offset : {0, 1, 5}) {
+            CAPTURE(offset);
+            context.cpuOffset = offset;
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+
+            matOpsParallel::withContext(context, [&] {
+                matOpsParallel::parallelFor(0, 2, true, [&](size_t i) {
+                    if (i == 1) {
+                        pthread_getaffinity_np(pthread_self(), sizeof(mask), &mask);
+                    }
+                });
+            });
+
+            CHECK(CPU_COUNT(&mask) == 1);
+            CHECK(CPU_ISSET(order[(offset + 1) % order.size()], &mask));
+        }
+
+        // Release the OpenMP workers again.
+        context.affinity = Affinity::None;
+        matOpsParallel::withContext(context, [] { matOpsParallel::parallelFor(0, 2, true, [](size_t) {}); });
+    }
+#endif
+
+    SUBCASE("Deterministic contexts give bitwise identical sparse results") {
+        Matrix dense = Matrix::constValMatrix(64, 48, 0.0);
+        for (size_t i = 0; i < 64; ++i) {
+            for (size_t j = 0; j < 48; ++j) {
+                if ((i * 7 + j * 3) % 5 == 0) {
+                    dense(i, j) = std::sin(0.7 * i + 1.3 * j) * 1e3;
+                }
+            }
+        }
+        BSRMatrix<2> S = BSRMatrix<2>::fromDense(dense);
+        std::vector<double> x(64);
+        for (size_t i = 0; i < 64; ++i) {
+            x[i] = std::cos(0.9 * i) * std::pow(10.0, static_cast<double>(i % 7));
+        }
+
+        matOpsParallel::setThreshold(matOpsParallel::Operation::Sparse, 0);
+        ExecutionContext context = ExecutionContext::serial();
+        context.deterministic = true;
+        const std::vector<double> reference = matOpsParallel::withContext(context, [&] { return S.transposeMultiply(x); });
+
+        for (Backend backend : {Backend::OpenMP, Backend::ThreadPool}) {
+            for (size_t threads : {2, 3, 5}) {
+                CAPTURE(threads);
+                context.backend = backend;
+                context.threads = threads;
+                CHECK(matOpsParallel::withContext(context, [&] { return S.transposeMultiply(x); }) == reference);
+            }
+        }
+        matOpsParallel::resetThresholds();
+    }
+}
+
+/**
+ * @brief Tests for batched small-matrix operations.
+ */
+TEST_CASE("Batched small-matrix operations") {
+    // 21 matrices: two full interleaved groups and a padded one.
+    const size_t count = 21;
+    const size_t n = 5;
+    std::vector<Matrix> As, Bs;
+    for (size_t b = 0; b < count; ++b) {
+        Matrix A = Matrix::constValMatrix(n, n, 0.0);
+        Matrix B = Matrix::constValMatrix(n, 3, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                A(i, j) = std::sin(1.3 * b + 0.7 * i + 0.31 * j * j) + (i == j ? 0.5 : 0.0);
+            }
+            for (size_t j = 0; j < 3; ++j) {
+                B(i, j) = std::cos(0.9 * b - 0.4 * i + 1.1 * j);
+            }
+        }
+        As.push_back(A);
+        Bs.push_back(B);
+    }
+    const MatrixBatch A(As);
+    const MatrixBatch B(Bs);
+
+    SUBCASE("Construction and element access") {
+        CHECK(A.size() == count);
+        CHECK(A.shape() == std::make_pair(n, n));
+        CHECK(A(13, 2, 4) == As[13](2, 4));
+        CHECK(A.get(20) == As[20]);
+        CHECK(A.toMatrices().size() == count);
+
+        MatrixBatch C(3, 2, 2, 1.5);
+        C(1, 0, 1) = -2.0;
+        C.set(2, Matrix::identity(2));
+        CHECK(C.get(0) == Matrix::constValMatrix(2, 2, 1.5));
+        CHECK(C(1, 0, 1) == -2.0);
+        CHECK(C.get(2) == Matrix::identity(2));
+        CHECK(MatrixBatch::identity(9, 3).get(8) == Matrix::identity(3));
+
+        CHECK_THROWS_AS(MatrixBatch(0, 2, 2), std::invalid_argument);
+        CHECK_THROWS_AS(MatrixBatch(std::vector<Matrix>()), std::invalid_argument);
+        CHECK_THROWS_AS(C.set(0, Matrix::identity(3)), std::invalid_argument);
+        CHECK_THROWS_AS(C(3, 0, 0), std::out_of_range);
+        CHECK_THROWS_AS(C.get(5), std::out_of_range);
+    }
+
+    SUBCASE("Batched products match per-matrix products") {
+        MatrixBatch C = A * B;
+        CHECK(C.shape() == std::make_pair(n, size_t(3)));
+        for (size_t b = 0; b < count; ++b) {
+            CAPTURE(b);
+            CHECK(C.get(b) == As[b] * Bs[b]);
+        }
+
+        CHECK_THROWS_AS(B * A, std::invalid_argument);
+        CHECK_THROWS_AS(A * MatrixBatch(4, n, n), std::invalid_argument);
+    }
+
+    SUBCASE("LU, solve, inverse and determinant match LUDecomposition") {
+        BatchedLU lu = A.lu();
+        const std::vector<double> det = A.determinant();
+        MatrixBatch X = lu.solve(B);
+        MatrixBatch inv = A.inverse();
+        REQUIRE(det.size() == count);
+
+        for (size_t b = 0; b < count; ++b) {
+            CAPTURE(b);
+            LUDecomposition reference(As[b]);
+            CHECK_FALSE(lu.isSingular(b));
+            CHECK(det[b] == doctest::Approx(reference.determinant()).epsilon(1e-12));
+            CHECK(X.get(b) == reference.solve(Bs[b]));
+            CHECK(As[b] * X.get(b) == Bs[b]);
+            CHECK(As[b] * inv.get(b) == Matrix::identity(n));
+        }
+        CHECK(A.solve(B).get(7) == X.get(7));
+
+        CHECK_THROWS_AS(MatrixBatch(2, 2, 3).lu(), std::invalid_argument);
+        CHECK_THROWS_AS(lu.solve(MatrixBatch(count, n + 1, 1)), std::invalid_argument);
+        CHECK_THROWS_AS(lu.solve(MatrixBatch(count - 1, n, 1)), std::invalid_argument);
+    }
+
+    SUBCASE("Singular matrices are reported per matrix") {
+        std::vector<Matrix> mixed(As.begin(), As.begin() + 10);
+        mixed[6] = Matrix({ {1, 2, 3}, {2, 4, 6}, {1, 0, 1} });
+        for (size_t b = 0; b < mixed.size(); ++b) {
+            if (b != 6) {
+                mixed[b] = Matrix({ {2, 1, 0}, {1, 3, 1}, {0, 1, static_cast<double>(b + 1)} });
+            }
+        }
+
+        MatrixBatch M(mixed);
+        BatchedLU lu = M.lu();
+        const std::vector<double> det = lu.determinant();
+        for (size_t b = 0; b < mixed.size(); ++b) {
+            CAPTURE(b);
+            CHECK(lu.isSingular(b) == (b == 6));
+            CHECK(det[b] == doctest::Approx(mixed[b].determinant()));
+        }
+        CHECK_THROWS_AS(lu.solve(MatrixBatch(10, 3, 1, 1.0)), std::runtime_error);
+        CHECK_THROWS_AS(M.inverse(), std::runtime_error);
+        CHECK_THROWS_AS(lu.isSingular(10), std::out_of_range);
+    }
+
+    SUBCASE("Every backend gives bitwise identical batches") {
+        const MatrixBatch product = A * B;
+        const MatrixBatch inv = A.inverse();
+        const std::vector<double> det = A.determinant();
+
+        matOpsParallel::setThreshold(matOpsParallel::Operation::Multiply, 0);
+        matOpsParallel::setThreshold(matOpsParallel::Operation::Factorization, 0);
+        matOpsParallel::ExecutionContext context;
+        context.threads = 3;
+        for (matOpsParallel::Backend backend : {matOpsParallel::Backend::OpenMP, matOpsParallel::Backend::ThreadPool}) {
+            CAPTURE(static_cast<int>(backend));
+            context.backend = backend;
+            matOpsParallel::ScopedContext scope(context);
+
+            const MatrixBatch C = A * B;
+            const MatrixBatch I = A.inverse();
+            CHECK(A.determinant() == det);
+            for (size_t b = 0; b < count; ++b) {
+                CHECK(C.get(b).hash() == product.get(b).hash());
+                CHECK(I.get(b).hash() == inv.get(b).hash());
+            }
+        }
+        matOpsParallel::resetThresholds();
+    }
+}